@@ -0,0 +1,252 @@
+// crc32c.h — CRC32C (Castagnoli) with hardware crc32 instructions, three
+// interleaved streams, and a slicing-by-8 table fallback
+//
+// Header-only, always compiled in. Same polynomial and conventions as
+// iSCSI, ext4, Btrfs and RocksDB: crc32c(0, "123456789", 9) == 0xE3069283.
+//
+// API:
+//   crc32c(crc, p, n)       CRC32C of p[0..n) continuing from crc (start at 0),
+//                           so crc32c(crc32c(0, a, na), b, nb) == CRC of a||b
+//   crc32c_isa()            name of the active kernel
+//   crc32c_use("sse42")     force a kernel (0 ok, -1 unsupported);
+//                           CRC32C_ISA=scalar|sse42|sse42x3 (x86) or
+//                           armv8|armv8x3 (arm64) does the same from the env
+//
+// One crc32 instruction has a latency of 3 cycles but a throughput of one
+// per cycle, so a single dependency chain uses a third of the unit. The x3
+// kernels run three independent CRCs over three adjacent blocks and merge
+// them: CRC(a||b) = CRC(a) * x^(8*|b|) + CRC(b) over GF(2), where "multiply
+// by x^(8*|b|)" is a linear map on 32 bits, precomputed as four 256-entry
+// tables per block length (Mark Adler's construction). Tables are built on
+// first use.
+//
+// Other targets (and x86 without SSE4.2) get the table-driven kernel.
+//
+// Thread-safe: the tables and the kernel choice are set up once under
+// pthread_once (batch workers checksum their reports concurrently).
+// crc32c_use() is meant for start-up, before any thread is running.
+
+#ifndef COMMON_CRC32C_H
+#define COMMON_CRC32C_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY  0x82F63B78u    // reflected Castagnoli polynomial
+#define CRC32C_LONG  8192           // x3 block sizes: three LONG blocks per round,
+#define CRC32C_SHORT 256            // then three SHORT blocks for the remainder
+
+/* ============================ Table-driven kernel ========================== */
+static uint32_t crc32c_table_[8][256];      // slicing-by-8
+static uint32_t crc32c_long_[4][256];       // multiply by x^(8*LONG)
+static uint32_t crc32c_short_[4][256];      // multiply by x^(8*SHORT)
+static pthread_once_t crc32c_tables_once_ = PTHREAD_ONCE_INIT;
+
+// GF(2) 32x32 matrix (one column per bit) times a vector.
+static inline uint32_t crc32c_gf2_times_(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (; vec; vec >>= 1, mat++)
+        if (vec & 1) sum ^= *mat;
+    return sum;
+}
+
+static inline void crc32c_gf2_square_(uint32_t *sq, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) sq[n] = crc32c_gf2_times_(mat, mat[n]);
+}
+
+// Tables for the operator "append len zero bytes" applied to a raw CRC register.
+static inline void crc32c_zeros_(uint32_t zeros[4][256], size_t len) {
+    uint32_t odd[32], even[32];
+    odd[0] = CRC32C_POLY;                       // one zero bit
+    for (int n = 1; n < 32; n++) odd[n] = 1u << (n - 1);
+    crc32c_gf2_square_(even, odd);              // two zero bits
+    crc32c_gf2_square_(odd, even);              // four zero bits
+    crc32c_gf2_square_(even, odd);              // one zero byte
+    // Each squaring doubles it; len is a power of two here.
+    uint32_t *op = even, *spare = odd;
+    for (; len > 1; len >>= 1) {
+        crc32c_gf2_square_(spare, op);
+        uint32_t *t = op;
+        op = spare;
+        spare = t;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        zeros[0][n] = crc32c_gf2_times_(op, n);
+        zeros[1][n] = crc32c_gf2_times_(op, n << 8);
+        zeros[2][n] = crc32c_gf2_times_(op, n << 16);
+        zeros[3][n] = crc32c_gf2_times_(op, n << 24);
+    }
+}
+
+static inline uint32_t crc32c_shift_(uint32_t zeros[4][256], uint32_t crc) {
+    return zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^
+           zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24];
+}
+
+static void crc32c_build_tables_(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        crc32c_table_[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; n++)
+        for (int k = 1; k < 8; k++)
+            crc32c_table_[k][n] = (crc32c_table_[k - 1][n] >> 8) ^ crc32c_table_[0][crc32c_table_[k - 1][n] & 0xFF];
+    crc32c_zeros_(crc32c_long_, CRC32C_LONG);
+    crc32c_zeros_(crc32c_short_, CRC32C_SHORT);
+}
+
+static inline void crc32c_init_tables_(void) {
+    pthread_once(&crc32c_tables_once_, crc32c_build_tables_);
+}
+
+static inline uint32_t crc32c_scalar_(uint32_t crc, const void *p, size_t n) {
+    const unsigned char *b = (const unsigned char *)p;
+    crc32c_init_tables_();
+    crc = ~crc;
+    for (; n >= 8; n -= 8, b += 8) {
+        uint64_t w;
+        memcpy(&w, b, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        w = __builtin_bswap64(w);
+#endif
+        w ^= crc;
+        crc = crc32c_table_[7][w & 0xFF] ^ crc32c_table_[6][(w >> 8) & 0xFF] ^
+              crc32c_table_[5][(w >> 16) & 0xFF] ^ crc32c_table_[4][(w >> 24) & 0xFF] ^
+              crc32c_table_[3][(w >> 32) & 0xFF] ^ crc32c_table_[2][(w >> 40) & 0xFF] ^
+              crc32c_table_[1][(w >> 48) & 0xFF] ^ crc32c_table_[0][w >> 56];
+    }
+    while (n--) crc = (crc >> 8) ^ crc32c_table_[0][(crc ^ *b++) & 0xFF];
+    return ~crc;
+}
+
+/* ============================= Hardware kernels ============================ */
+// One template, two instruction sets: U64(crc, word), U32/U16 for the tail
+// and U8(crc, byte). A 20-byte line is mostly tail: 4 + 2 + 1 bytes take
+// three dependent steps instead of seven.
+#define CRC32C_HW_TAIL_(c, b, n, U32, U16, U8)                                             \
+    if (n & 4) { uint32_t w; memcpy(&w, b, 4); c = U32(c, w); b += 4; }                     \
+    if (n & 2) { uint16_t w; memcpy(&w, b, 2); c = U16(c, w); b += 2; }                     \
+    if (n & 1) c = U8(c, *b);
+#define CRC32C_HW_KERNELS(isa, TGT, U64, U32, U16, U8)                                    \
+static TGT uint32_t crc32c_##isa##_(uint32_t crc, const void *p, size_t n) {              \
+    const unsigned char *b = (const unsigned char *)p;                                    \
+    uint64_t c = ~crc;                                                                     \
+    for (; n >= 8; n -= 8, b += 8) { uint64_t w; memcpy(&w, b, 8); c = U64(c, w); }       \
+    CRC32C_HW_TAIL_(c, b, n, U32, U16, U8)                                                 \
+    return ~(uint32_t)c;                                                                   \
+}                                                                                          \
+static TGT uint32_t crc32c_##isa##x3_(uint32_t crc, const void *p, size_t n) {            \
+    const unsigned char *b = (const unsigned char *)p;                                    \
+    if (n >= 3 * CRC32C_SHORT) crc32c_init_tables_();     /* short lines need no tables */  \
+    uint64_t c0 = ~crc;                                                                    \
+    for (size_t blk = CRC32C_LONG; blk >= CRC32C_SHORT; blk = CRC32C_SHORT) {             \
+        uint32_t (*zeros)[256] = blk == CRC32C_LONG ? crc32c_long_ : crc32c_short_;        \
+        for (; n >= 3 * blk; n -= 3 * blk, b += 3 * blk) {                                 \
+            uint64_t c1 = 0, c2 = 0;                                                       \
+            for (size_t i = 0; i < blk; i += 8) {                                          \
+                uint64_t w0, w1, w2;                                                       \
+                memcpy(&w0, b + i, 8);                                                     \
+                memcpy(&w1, b + blk + i, 8);                                               \
+                memcpy(&w2, b + 2 * blk + i, 8);                                           \
+                c0 = U64(c0, w0);                                                          \
+                c1 = U64(c1, w1);                                                          \
+                c2 = U64(c2, w2);                                                          \
+            }                                                                              \
+            c0 = crc32c_shift_(zeros, (uint32_t)c0) ^ c1;                                  \
+            c0 = crc32c_shift_(zeros, (uint32_t)c0) ^ c2;                                  \
+        }                                                                                  \
+        if (blk == CRC32C_SHORT) break;                                                    \
+    }                                                                                      \
+    for (; n >= 8; n -= 8, b += 8) { uint64_t w; memcpy(&w, b, 8); c0 = U64(c0, w); }    \
+    CRC32C_HW_TAIL_(c0, b, n, U32, U16, U8)                                                \
+    return ~(uint32_t)c0;                                                                  \
+}
+
+#ifdef CRC32C_X86
+#define CRC32C_X86_U64(c, w) _mm_crc32_u64((c), (w))
+#define CRC32C_X86_U32(c, w) _mm_crc32_u32((uint32_t)(c), (w))
+#define CRC32C_X86_U16(c, w) _mm_crc32_u16((uint32_t)(c), (w))
+#define CRC32C_X86_U8(c, b)  _mm_crc32_u8((uint32_t)(c), (b))
+CRC32C_HW_KERNELS(sse42, __attribute__((target("sse4.2"))), CRC32C_X86_U64, CRC32C_X86_U32, CRC32C_X86_U16,
+                  CRC32C_X86_U8)
+#endif
+#ifdef CRC32C_ARM
+#define CRC32C_ARM_U64(c, w) __crc32cd((uint32_t)(c), (w))
+#define CRC32C_ARM_U32(c, w) __crc32cw((uint32_t)(c), (w))
+#define CRC32C_ARM_U16(c, w) __crc32ch((uint32_t)(c), (w))
+#define CRC32C_ARM_U8(c, b)  __crc32cb((uint32_t)(c), (b))
+CRC32C_HW_KERNELS(armv8, , CRC32C_ARM_U64, CRC32C_ARM_U32, CRC32C_ARM_U16, CRC32C_ARM_U8)
+#endif
+
+/* ================================ Dispatch ================================ */
+typedef struct {
+    const char *name;
+    uint32_t (*fn)(uint32_t, const void *, size_t);
+} crc32c_impl_t;
+
+static const crc32c_impl_t crc32c_impls_[] = {
+    { "scalar",  crc32c_scalar_ },
+#ifdef CRC32C_X86
+    { "sse42",   crc32c_sse42_ },
+    { "sse42x3", crc32c_sse42x3_ },
+#endif
+#ifdef CRC32C_ARM
+    { "armv8",   crc32c_armv8_ },
+    { "armv8x3", crc32c_armv8x3_ },
+#endif
+};
+#define CRC32C_NIMPLS (sizeof(crc32c_impls_) / sizeof(crc32c_impls_[0]))
+
+static const crc32c_impl_t *crc32c_active_;
+static pthread_once_t crc32c_pick_once_ = PTHREAD_ONCE_INIT;
+
+static inline int crc32c_supported_(size_t idx) {
+#ifdef CRC32C_X86
+    __builtin_cpu_init();
+    if (idx > 0) return __builtin_cpu_supports("sse4.2");
+#endif
+    return idx < CRC32C_NIMPLS;                 // arm64 kernels are compiled in only when usable
+}
+
+static inline int crc32c_use(const char *name) {
+    for (size_t i = 0; i < CRC32C_NIMPLS; i++) {
+        if (strcmp(crc32c_impls_[i].name, name) != 0) continue;
+        if (!crc32c_supported_(i)) return -1;
+        crc32c_active_ = &crc32c_impls_[i];
+        return 0;
+    }
+    return -1;
+}
+
+static void crc32c_pick_(void) {
+    if (crc32c_active_) return;                 // crc32c_use() already chose
+    const char *env = getenv("CRC32C_ISA");
+    if (env && crc32c_use(env) == 0) return;
+    for (size_t i = CRC32C_NIMPLS; i-- > 0;)        // interleaved kernel first
+        if (crc32c_supported_(i)) { crc32c_active_ = &crc32c_impls_[i]; break; }
+}
+
+static inline const crc32c_impl_t *crc32c_impl_(void) {
+    pthread_once(&crc32c_pick_once_, crc32c_pick_);
+    return crc32c_active_;
+}
+
+static inline const char *crc32c_isa(void) { return crc32c_impl_()->name; }
+
+static inline uint32_t crc32c(uint32_t crc, const void *p, size_t n) {
+    return crc32c_impl_()->fn(crc, p, n);
+}
+
+#endif /* COMMON_CRC32C_H */
@@ -0,0 +1,143 @@
+// fmt.h — bounded formatting into fixed buffers without a format string
+//
+// Header-only, always compiled in. A format is a sequence of typed calls
+// instead of "TAG:%s": the compiler sees every piece, nothing is parsed at
+// run time, and each piece has a maximum width that is a constant
+// expression, so a buffer can be proven big enough before the program runs.
+// Truncation is still reported exactly like snprintf: fmt_end() returns the
+// length the whole output wanted, and the buffer holds as much of it as
+// fits, always '\0'-terminated.
+//
+// API:
+//   fmt_t f = FMT_BEGIN(arr)      start writing into a char array (GCC/clang:
+//                                 rejects a pointer at compile time)
+//   fmt_begin(buf, cap)           the same for a pointer + capacity (cap >= 1)
+//   fmt_lit(&f, "TAG:")           a string literal; length known at compile time
+//   fmt_str(&f, s)                a C string (one strlen)
+//   fmt_strn(&f, s, n)            n bytes you already measured
+//   fmt_char(&f, c)
+//   fmt_u64(&f, v), fmt_i64(&f, v)  decimal, two digits per step from a
+//                                 200-byte digit-pair table
+//   fmt_end(&f)                   terminate; returns the wanted length, so
+//                                 fmt_end(&f) >= sizeof(arr) means truncated
+//
+// Maximum lengths (constant expressions, '\0' not included):
+//   FMT_LIT_MAX("TAG:")  FMT_STR_MAX(char_array)  FMT_U64_MAX  FMT_I64_MAX
+//   FMT_FITS(arr, max)   static assertion that arr holds max chars + '\0'
+//
+//   char tag[20];
+//   FMT_FITS(tag, FMT_LIT_MAX("TAG:") + FMT_STR_MAX(label));
+//   fmt_t f = FMT_BEGIN(tag);
+//   fmt_lit(&f, "TAG:");
+//   fmt_str(&f, label);
+//   if (fmt_end(&f) >= sizeof(tag)) ...   // cannot happen, and says so
+
+#ifndef COMMON_FMT_H
+#define COMMON_FMT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    char *buf;
+    size_t cap;                 // bytes in buf, '\0' included
+    size_t len;                 // bytes wanted so far; > cap - 1 once truncated
+} fmt_t;
+
+#define FMT_LIT_MAX(s) (sizeof("" s "") - 1)
+#define FMT_STR_MAX(arr) (sizeof(arr) - 1)
+#define FMT_U64_MAX 20          // 18446744073709551615
+#define FMT_I64_MAX 20          // -9223372036854775808
+#define FMT_FITS(arr, max) _Static_assert(sizeof(arr) > (max), #arr " is too small for its format")
+
+#if defined(__GNUC__) || defined(__clang__)
+// sizeof(char[-1]) if arr is a pointer: FMT_BEGIN(ptr) would format into 8 bytes.
+#define FMT_ARRAY_SIZE_(arr) \
+    (sizeof(arr) + 0 * sizeof(char[__builtin_types_compatible_p(__typeof__(arr), __typeof__(&(arr)[0])) ? -1 : 1]))
+#else
+#define FMT_ARRAY_SIZE_(arr) sizeof(arr)
+#endif
+#define FMT_BEGIN(arr) fmt_begin((arr), FMT_ARRAY_SIZE_(arr))
+
+static const char fmt_digits2_[201] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+static inline fmt_t fmt_begin(char *buf, size_t cap) {
+    fmt_t f = { buf, cap, 0 };
+    return f;
+}
+
+static inline void fmt_strn(fmt_t *f, const char *s, size_t n) {
+    if (f->len < f->cap - 1) {
+        size_t room = f->cap - 1 - f->len;
+        memcpy(f->buf + f->len, s, n < room ? n : room);
+    }
+    f->len += n;
+}
+
+#define fmt_lit(f, s) fmt_strn((f), "" s "", FMT_LIT_MAX(s))
+
+static inline void fmt_str(fmt_t *f, const char *s) {
+    fmt_strn(f, s, strlen(s));
+}
+
+static inline void fmt_char(fmt_t *f, char c) {
+    if (f->len < f->cap - 1) f->buf[f->len] = c;
+    f->len++;
+}
+
+static inline unsigned fmt_digits_(uint64_t v) {
+    unsigned n = 1;
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+// Write the digits of v so they end just before `end`.
+static inline void fmt_u64_back_(char *end, uint64_t v) {
+    while (v >= 100) {
+        unsigned r = (unsigned)(v % 100);
+        v /= 100;
+        end -= 2;
+        memcpy(end, fmt_digits2_ + 2 * r, 2);
+    }
+    if (v >= 10) memcpy(end - 2, fmt_digits2_ + 2 * v, 2);
+    else end[-1] = (char)('0' + v);
+}
+
+static inline void fmt_u64(fmt_t *f, uint64_t v) {
+    unsigned n = fmt_digits_(v);
+    if (f->len + n < f->cap) {                      // fits: straight into the buffer
+        fmt_u64_back_(f->buf + f->len + n, v);
+        f->len += n;
+    } else {
+        char tmp[FMT_U64_MAX];
+        fmt_u64_back_(tmp + n, v);
+        fmt_strn(f, tmp, n);
+    }
+}
+
+static inline void fmt_i64(fmt_t *f, int64_t v) {
+    if (v < 0) {
+        fmt_char(f, '-');
+        fmt_u64(f, 0 - (uint64_t)v);                // INT64_MIN too
+    } else {
+        fmt_u64(f, (uint64_t)v);
+    }
+}
+
+static inline size_t fmt_end(fmt_t *f) {
+    f->buf[f->len < f->cap ? f->len : f->cap - 1] = '\0';
+    return f->len;
+}
+
+#endif /* COMMON_FMT_H */
@@ -0,0 +1,149 @@
+// part_stats.h — per-Part CPU time, context switches, faults and run-queue wait
+//
+// Header-only. Compiled out unless the demo is built with -DPART_STATS
+// (`make stats` in w3/w5/w6). Reports go to stderr so demo output is unchanged.
+//
+// API (all no-ops without -DPART_STATS):
+//   PART_STATS_BEGIN("Part 1")  snapshot getrusage(RUSAGE_SELF) + schedstat
+//   PART_STATS_THREAD()         last line of a worker: record its own
+//                               getrusage(RUSAGE_THREAD) + /proc/thread-self/schedstat
+//   PART_STATS_END()            print the Part's deltas and one row per worker
+//
+// Columns:
+//   user/sys   CPU time in user and kernel mode (sys ≈ futex, sched_yield, ...)
+//   vcsw       voluntary context switches (blocked: lock/cond wait, I/O)
+//   ivcsw      involuntary context switches (preempted: time slice ran out)
+//   minflt/majflt  page faults without / with disk I/O
+//   runq       time spent runnable but waiting for a CPU (schedstat field 2)
+//
+// Linux gives all columns; elsewhere per-thread rows and runq are omitted.
+
+#ifndef COMMON_PART_STATS_H
+#define COMMON_PART_STATS_H
+
+#ifdef PART_STATS
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+
+#if defined(__linux__) && !defined(RUSAGE_THREAD)
+#define RUSAGE_THREAD 1     // hidden by strict _POSIX_C_SOURCE; value is fixed ABI
+#endif
+
+#ifndef PART_STATS_MAX_THREADS
+#define PART_STATS_MAX_THREADS 64
+#endif
+
+typedef struct {
+    double user_s, sys_s;
+    long vcsw, ivcsw, minflt, majflt;
+    double runq_ms;         // < 0 when schedstat is unavailable
+} part_sample_t;
+
+static struct {
+    const char *name;
+    struct timespec t0;
+    part_sample_t self0;
+    pthread_mutex_t mu;
+    int nthreads;
+    part_sample_t threads[PART_STATS_MAX_THREADS];
+} part_stats_ = { .mu = PTHREAD_MUTEX_INITIALIZER };
+
+static double part_tv_s_(struct timeval tv) { return (double)tv.tv_sec + (double)tv.tv_usec / 1e6; }
+
+// /proc/.../schedstat: "<ns on cpu> <ns waiting on runqueue> <timeslices>"
+static double part_runq_ms_(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1.0;
+    unsigned long long run = 0, wait = 0;
+    int ok = fscanf(f, "%llu %llu", &run, &wait) == 2;
+    fclose(f);
+    return ok ? (double)wait / 1e6 : -1.0;
+}
+
+static part_sample_t part_sample_(int who, const char *schedstat) {
+    struct rusage ru;
+    part_sample_t s;
+    memset(&s, 0, sizeof(s));
+    s.runq_ms = -1.0;
+    if (getrusage(who, &ru) != 0) return s;
+    s.user_s = part_tv_s_(ru.ru_utime);
+    s.sys_s = part_tv_s_(ru.ru_stime);
+    s.vcsw = ru.ru_nvcsw;
+    s.ivcsw = ru.ru_nivcsw;
+    s.minflt = ru.ru_minflt;
+    s.majflt = ru.ru_majflt;
+    s.runq_ms = part_runq_ms_(schedstat);
+    return s;
+}
+
+static void part_print_row_(const char *label, const part_sample_t *s) {
+    fprintf(stderr, "[stats] %-10s user %8.3fs  sys %8.3fs  vcsw %7ld  ivcsw %7ld  minflt %6ld  majflt %4ld",
+            label, s->user_s, s->sys_s, s->vcsw, s->ivcsw, s->minflt, s->majflt);
+    if (s->runq_ms >= 0) fprintf(stderr, "  runq %9.3fms", s->runq_ms);
+    fprintf(stderr, "\n");
+}
+
+static void part_stats_begin_(const char *name) {
+    part_stats_.name = name;
+    part_stats_.nthreads = 0;
+    clock_gettime(CLOCK_MONOTONIC, &part_stats_.t0);
+    part_stats_.self0 = part_sample_(RUSAGE_SELF, "/proc/self/schedstat");
+}
+
+static inline void part_stats_thread_(void) {
+#ifdef RUSAGE_THREAD
+    // Workers are created per Part, so "since thread start" == "this Part".
+    part_sample_t s = part_sample_(RUSAGE_THREAD, "/proc/thread-self/schedstat");
+    pthread_mutex_lock(&part_stats_.mu);
+    if (part_stats_.nthreads < PART_STATS_MAX_THREADS) part_stats_.threads[part_stats_.nthreads++] = s;
+    pthread_mutex_unlock(&part_stats_.mu);
+#endif
+}
+
+static void part_stats_end_(void) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    part_sample_t a = part_stats_.self0;
+    part_sample_t b = part_sample_(RUSAGE_SELF, "/proc/self/schedstat");
+    part_sample_t d = {
+        b.user_s - a.user_s, b.sys_s - a.sys_s, b.vcsw - a.vcsw, b.ivcsw - a.ivcsw,
+        b.minflt - a.minflt, b.majflt - a.majflt,
+        (a.runq_ms >= 0 && b.runq_ms >= 0) ? b.runq_ms - a.runq_ms : -1.0,
+    };
+    // RUSAGE_SELF covers every thread; schedstat of /proc/self is the main
+    // thread only, so add the workers' run-queue wait on top.
+    pthread_mutex_lock(&part_stats_.mu);
+    for (int i = 0; i < part_stats_.nthreads && d.runq_ms >= 0; i++)
+        if (part_stats_.threads[i].runq_ms >= 0) d.runq_ms += part_stats_.threads[i].runq_ms;
+
+    double wall = (double)(t1.tv_sec - part_stats_.t0.tv_sec) +
+                  (double)(t1.tv_nsec - part_stats_.t0.tv_nsec) / 1e9;
+    fprintf(stderr, "[stats] ---- %s: wall %.3fs, %d worker thread(s) ----\n",
+            part_stats_.name, wall, part_stats_.nthreads);
+    part_print_row_("process", &d);
+    char label[24];
+    for (int i = 0; i < part_stats_.nthreads; i++) {
+        snprintf(label, sizeof(label), "thread %d", i);
+        part_print_row_(label, &part_stats_.threads[i]);
+    }
+    part_stats_.nthreads = 0;
+    pthread_mutex_unlock(&part_stats_.mu);
+}
+
+#define PART_STATS_BEGIN(name)  part_stats_begin_(name)
+#define PART_STATS_THREAD()     part_stats_thread_()
+#define PART_STATS_END()        part_stats_end_()
+
+#else  /* !PART_STATS */
+
+#define PART_STATS_BEGIN(name)  ((void)0)
+#define PART_STATS_THREAD()     ((void)0)
+#define PART_STATS_END()        ((void)0)
+
+#endif /* PART_STATS */
+#endif /* COMMON_PART_STATS_H */
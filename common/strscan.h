@@ -0,0 +1,198 @@
+// strscan.h — bounded byte scans (strnlen / memchr / find-any-of-set) with
+// SSE2, AVX2 and AVX-512BW kernels picked at runtime
+//
+// Header-only, always compiled in. Every scan is bounded by an explicit
+// length, so it never depends on a '\0' being present.
+//
+// API:
+//   strscan_strnlen(s, max)              like strnlen
+//   strscan_memchr(p, c, n)              like memchr
+//   strscan_find_any(p, n, set, setlen)  index of the first byte of p[0..n)
+//                                        that occurs in set[0..setlen), or n
+//                                        (a bounded strcspn)
+//   strscan_isa()                        name of the active kernel
+//   strscan_use("avx2")                  force a kernel (0 ok, -1 unsupported);
+//                                        STRSCAN_ISA=scalar|sse2|avx2|avx512
+//                                        does the same from the environment
+//
+// Page safety: the SIMD kernels only issue ALIGNED vector loads. An aligned
+// 16/32/64-byte block never straddles a page, so reading the bytes before
+// the start or after the end inside that block cannot fault, even when the
+// string ends right at an unmapped page. Bytes outside [p, p+n) are masked
+// off before they can produce a match. ASan is told not to instrument these
+// loads (the over-read is deliberate and stays inside the block).
+//
+// Non-x86 builds get the scalar kernel only.
+
+#ifndef COMMON_STRSCAN_H
+#define COMMON_STRSCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STRSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+#define STRSCAN_SET_MAX 16      // larger sets use the scalar bitmap path
+
+#if defined(__clang__) || defined(__GNUC__)
+#define STRSCAN_NOASAN __attribute__((no_sanitize_address))
+#else
+#define STRSCAN_NOASAN
+#endif
+
+/* ============================= Scalar kernels ============================= */
+static inline size_t strscan_strnlen_scalar_(const char *s, size_t n) {
+    size_t i = 0;
+    while (i < n && s[i]) i++;
+    return i;
+}
+
+static inline const void *strscan_memchr_scalar_(const void *p, int c, size_t n) {
+    const unsigned char *b = (const unsigned char *)p;
+    for (size_t i = 0; i < n; i++)
+        if (b[i] == (unsigned char)c) return b + i;
+    return NULL;
+}
+
+static inline size_t strscan_find_any_scalar_(const char *p, size_t n, const char *set, size_t setlen) {
+    uint8_t in_set[256] = { 0 };
+    for (size_t j = 0; j < setlen; j++) in_set[(unsigned char)set[j]] = 1;
+    for (size_t i = 0; i < n; i++)
+        if (in_set[(unsigned char)p[i]]) return i;
+    return n;
+}
+
+/* ============================== SIMD kernels ============================== */
+#ifdef STRSCAN_X86
+// One template, three widths. W = vector bytes; MASK(b, v) returns a bitmask
+// with bit i set where byte i of block b equals byte i of v.
+#define STRSCAN_KERNELS(isa, W, TGT, VEC, LOAD, SET1, MASK)                              \
+static TGT STRSCAN_NOASAN size_t strscan_strnlen_##isa##_(const char *s, size_t n) {     \
+    if (!n) return 0;                                                                     \
+    const char *blk = (const char *)((uintptr_t)s & ~(uintptr_t)(W - 1));                \
+    const VEC zero = SET1(0);                                                             \
+    uint64_t m = MASK(LOAD((const VEC *)blk), zero) >> (s - blk);                        \
+    if (m) { size_t i = (size_t)__builtin_ctzll(m); return i < n ? i : n; }              \
+    for (blk += W; (size_t)(blk - s) < n; blk += W) {                                     \
+        m = MASK(LOAD((const VEC *)blk), zero);                                           \
+        if (m) { size_t i = (size_t)(blk - s) + (size_t)__builtin_ctzll(m); return i < n ? i : n; } \
+    }                                                                                     \
+    return n;                                                                             \
+}                                                                                         \
+static TGT STRSCAN_NOASAN const void *strscan_memchr_##isa##_(const void *p, int c, size_t n) { \
+    if (!n) return NULL;                                                                  \
+    const char *s = (const char *)p;                                                      \
+    const char *blk = (const char *)((uintptr_t)s & ~(uintptr_t)(W - 1));                \
+    const VEC v = SET1((char)c);                                                          \
+    uint64_t m = MASK(LOAD((const VEC *)blk), v) >> (s - blk);                           \
+    if (m) { size_t i = (size_t)__builtin_ctzll(m); return i < n ? s + i : NULL; }       \
+    for (blk += W; (size_t)(blk - s) < n; blk += W) {                                     \
+        m = MASK(LOAD((const VEC *)blk), v);                                              \
+        if (m) { size_t i = (size_t)(blk - s) + (size_t)__builtin_ctzll(m); return i < n ? s + i : NULL; } \
+    }                                                                                     \
+    return NULL;                                                                          \
+}                                                                                         \
+static TGT STRSCAN_NOASAN size_t strscan_find_any_##isa##_(const char *s, size_t n,       \
+                                                          const char *set, size_t setlen) { \
+    if (setlen > STRSCAN_SET_MAX) return strscan_find_any_scalar_(s, n, set, setlen);    \
+    if (!n || !setlen) return n;                                                          \
+    VEC sv[STRSCAN_SET_MAX];                                                              \
+    for (size_t j = 0; j < setlen; j++) sv[j] = SET1(set[j]);                             \
+    const char *blk = (const char *)((uintptr_t)s & ~(uintptr_t)(W - 1));                \
+    for (size_t skip = (size_t)(s - blk);; blk += W, skip = 0) {                          \
+        VEC b = LOAD((const VEC *)blk);                                                   \
+        uint64_t m = 0;                                                                   \
+        for (size_t j = 0; j < setlen; j++) m |= MASK(b, sv[j]);                          \
+        m >>= skip;                                                                       \
+        if (m) {                                                                          \
+            size_t i = (size_t)(blk + skip - s) + (size_t)__builtin_ctzll(m);             \
+            return i < n ? i : n;                                                         \
+        }                                                                                 \
+        if ((size_t)(blk + W - s) >= n) return n;                                         \
+    }                                                                                     \
+}
+
+#define STRSCAN_M128(b, v) ((uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8((b), (v))))
+#define STRSCAN_M256(b, v) ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8((b), (v))))
+#define STRSCAN_M512(b, v) ((uint64_t)_mm512_cmpeq_epi8_mask((b), (v)))
+
+STRSCAN_KERNELS(sse2,   16, __attribute__((target("sse2"))),
+                __m128i, _mm_load_si128, _mm_set1_epi8, STRSCAN_M128)
+STRSCAN_KERNELS(avx2,   32, __attribute__((target("avx2"))),
+                __m256i, _mm256_load_si256, _mm256_set1_epi8, STRSCAN_M256)
+STRSCAN_KERNELS(avx512, 64, __attribute__((target("avx512f,avx512bw"))),
+                __m512i, _mm512_load_si512, _mm512_set1_epi8, STRSCAN_M512)
+#endif /* STRSCAN_X86 */
+
+/* ================================ Dispatch ================================ */
+typedef struct {
+    const char *name;
+    size_t (*strnlen)(const char *, size_t);
+    const void *(*memchr)(const void *, int, size_t);
+    size_t (*find_any)(const char *, size_t, const char *, size_t);
+} strscan_impl_t;
+
+static const strscan_impl_t strscan_impls_[] = {
+    { "scalar", strscan_strnlen_scalar_, strscan_memchr_scalar_, strscan_find_any_scalar_ },
+#ifdef STRSCAN_X86
+    { "sse2",   strscan_strnlen_sse2_,   strscan_memchr_sse2_,   strscan_find_any_sse2_ },
+    { "avx2",   strscan_strnlen_avx2_,   strscan_memchr_avx2_,   strscan_find_any_avx2_ },
+    { "avx512", strscan_strnlen_avx512_, strscan_memchr_avx512_, strscan_find_any_avx512_ },
+#endif
+};
+#define STRSCAN_NIMPLS (sizeof(strscan_impls_) / sizeof(strscan_impls_[0]))
+
+static const strscan_impl_t *strscan_active_;
+
+static inline int strscan_supported_(size_t idx) {
+#ifdef STRSCAN_X86
+    __builtin_cpu_init();
+    switch (idx) {
+        case 1: return __builtin_cpu_supports("sse2");
+        case 2: return __builtin_cpu_supports("avx2");
+        case 3: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        default: break;
+    }
+#endif
+    return idx == 0;
+}
+
+static inline int strscan_use(const char *name) {
+    for (size_t i = 0; i < STRSCAN_NIMPLS; i++) {
+        if (strcmp(strscan_impls_[i].name, name) != 0) continue;
+        if (!strscan_supported_(i)) return -1;
+        strscan_active_ = &strscan_impls_[i];
+        return 0;
+    }
+    return -1;
+}
+
+static inline const strscan_impl_t *strscan_impl_(void) {
+    if (__builtin_expect(strscan_active_ != NULL, 1)) return strscan_active_;
+    const char *env = getenv("STRSCAN_ISA");
+    if (env && strscan_use(env) == 0) return strscan_active_;
+    for (size_t i = STRSCAN_NIMPLS; i-- > 0;)       // widest supported first
+        if (strscan_supported_(i)) { strscan_active_ = &strscan_impls_[i]; break; }
+    return strscan_active_;
+}
+
+static inline const char *strscan_isa(void) { return strscan_impl_()->name; }
+
+static inline size_t strscan_strnlen(const char *s, size_t max) {
+    return strscan_impl_()->strnlen(s, max);
+}
+
+static inline const void *strscan_memchr(const void *p, int c, size_t n) {
+    return strscan_impl_()->memchr(p, c, n);
+}
+
+static inline size_t strscan_find_any(const char *p, size_t n, const char *set, size_t setlen) {
+    return strscan_impl_()->find_any(p, n, set, setlen);
+}
+
+#endif /* COMMON_STRSCAN_H */
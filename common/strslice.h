@@ -0,0 +1,94 @@
+// strslice.h — (ptr, len) string views that never rescan for '\0'
+//
+// Header-only, always compiled in. A slice_t points into a buffer you own;
+// the length travels with the pointer, so chomp/trim/split are O(1) or one
+// pass over exactly the bytes involved, and nothing calls strlen twice.
+//
+// API:
+//   slice_from_cstr(s)        wrap a C string (the one and only strlen)
+//   slice_from(p, n)          wrap n bytes you already measured
+//   slice_chomp(s)            drop one trailing '\n'
+//   slice_trim(s)             drop leading/trailing isspace() — no memmove,
+//                             the view just moves
+//   slice_split(&rest, d, &tok)  next token separated by d (runs of d are
+//                             collapsed, like strtok); false when done
+//   slice_reverse(s)          reverse the bytes in place
+//   slice_upper(s)            toupper() in place
+//   slice_add(s, delta)       add delta to every byte (demo.c's scramble)
+//   slice_cstr(s)             write '\0' at s.ptr[s.len] and return s.ptr;
+//                             the byte after the view must be yours
+//
+// Print without terminating:  printf("%.*s", SLICE_FMT(s)).
+
+#ifndef COMMON_STRSLICE_H
+#define COMMON_STRSLICE_H
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    char *ptr;
+    size_t len;
+} slice_t;
+
+#define SLICE_FMT(s) (int)(s).len, (s).ptr
+
+static inline slice_t slice_from(char *p, size_t n) {
+    slice_t s = { p, n };
+    return s;
+}
+
+static inline slice_t slice_from_cstr(char *s) {
+    return slice_from(s, strlen(s));
+}
+
+static inline slice_t slice_chomp(slice_t s) {
+    if (s.len && s.ptr[s.len - 1] == '\n') s.len--;
+    return s;
+}
+
+static inline slice_t slice_trim(slice_t s) {
+    while (s.len && isspace((unsigned char)s.ptr[0])) { s.ptr++; s.len--; }
+    while (s.len && isspace((unsigned char)s.ptr[s.len - 1])) s.len--;
+    return s;
+}
+
+// Consumes the token and ONE delimiter after it from *rest, so the caller may
+// slice_cstr() the token (overwriting that delimiter) and keep splitting.
+static inline bool slice_split(slice_t *rest, char delim, slice_t *tok) {
+    while (rest->len && rest->ptr[0] == delim) { rest->ptr++; rest->len--; }
+    if (!rest->len) return false;
+    char *end = memchr(rest->ptr, delim, rest->len);
+    size_t n = end ? (size_t)(end - rest->ptr) : rest->len;
+    *tok = slice_from(rest->ptr, n);
+    size_t used = end ? n + 1 : n;
+    rest->ptr += used;
+    rest->len -= used;
+    return true;
+}
+
+static inline void slice_reverse(slice_t s) {
+    if (s.len < 2) return;
+    for (char *i = s.ptr, *j = s.ptr + s.len - 1; i < j; i++, j--) {
+        char tmp = *i;
+        *i = *j;
+        *j = tmp;
+    }
+}
+
+static inline void slice_upper(slice_t s) {
+    for (size_t i = 0; i < s.len; i++) s.ptr[i] = (char)toupper((unsigned char)s.ptr[i]);
+}
+
+static inline void slice_add(slice_t s, int delta) {
+    for (size_t i = 0; i < s.len; i++) s.ptr[i] = (char)(s.ptr[i] + delta);
+}
+
+static inline char *slice_cstr(slice_t s) {
+    s.ptr[s.len] = '\0';
+    return s.ptr;
+}
+
+#endif /* COMMON_STRSLICE_H */
@@ -0,0 +1,137 @@
+// timing.h — fast timestamps for the demos and benchmarks
+//
+// Header-only and always compiled in (unlike trace.h / part_stats.h): the
+// benchmarks need a clock whether or not anything else is switched on.
+//
+// API:
+//   timing_now_ns()          CLOCK_MONOTONIC_RAW via the vDSO — no syscall,
+//                            not slewed by NTP; the default for measuring
+//   timing_coarse_ns()       CLOCK_MONOTONIC_COARSE: last scheduler tick
+//                            (1–4 ms resolution) but only a memory load
+//   timing_cycles()          rdtscp (x86) / cntvct_el0 (arm64) raw counter,
+//                            for sub-100 ns regions
+//   timing_cycles_to_ns(c)   convert a cycles delta; calibrated against
+//                            CLOCK_MONOTONIC_RAW on first use (~10 ms)
+//   timing_tsc_invariant()   1 if the counter ticks at a constant rate across
+//                            frequency changes and idle states (CPUID 80000007h
+//                            EDX[8]); without it, use timing_now_ns()
+//   timing_report(f)         per-call overhead and resolution of every source
+//
+// Build `tools/timing_overhead` to print the report for the current machine.
+
+#ifndef COMMON_TIMING_H
+#define COMMON_TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#if defined(CLOCK_MONOTONIC_RAW)
+#define TIMING_CLOCK_RAW CLOCK_MONOTONIC_RAW
+#else
+#define TIMING_CLOCK_RAW CLOCK_MONOTONIC
+#endif
+
+#if defined(CLOCK_MONOTONIC_COARSE)
+#define TIMING_CLOCK_COARSE CLOCK_MONOTONIC_COARSE
+#elif defined(CLOCK_MONOTONIC_RAW_APPROX)      // macOS equivalent
+#define TIMING_CLOCK_COARSE CLOCK_MONOTONIC_RAW_APPROX
+#else
+#define TIMING_CLOCK_COARSE TIMING_CLOCK_RAW
+#endif
+
+static inline uint64_t timing_clock_ns_(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t timing_now_ns(void)    { return timing_clock_ns_(TIMING_CLOCK_RAW); }
+static inline uint64_t timing_coarse_ns(void) { return timing_clock_ns_(TIMING_CLOCK_COARSE); }
+
+static inline uint64_t timing_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned aux;
+    return __rdtscp(&aux);      // waits for earlier instructions to finish
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(v) :: "memory");
+    return v;
+#else
+    return timing_now_ns();     // "cycles" are nanoseconds here
+#endif
+}
+
+static inline int timing_tsc_invariant(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (__get_cpuid_max(0x80000000u, NULL) < 0x80000007u) return 0;
+    __cpuid(0x80000007u, a, b, c, d);
+    (void)a; (void)b; (void)c;
+    return (d >> 8) & 1;
+#elif defined(__aarch64__)
+    return 1;                   // the generic timer runs at a fixed frequency
+#else
+    return 1;
+#endif
+}
+
+static double timing_ns_per_cycle_;
+
+static inline void timing_calibrate(void) {
+    // Spin ~10 ms and compare both clocks; bracketing with two raw reads
+    // bounds the error to the cost of one clock_gettime.
+    uint64_t n0 = timing_now_ns(), c0 = timing_cycles();
+    uint64_t n1, c1;
+    do { c1 = timing_cycles(); n1 = timing_now_ns(); } while (n1 - n0 < 10000000ull);
+    timing_ns_per_cycle_ = (c1 > c0) ? (double)(n1 - n0) / (double)(c1 - c0) : 1.0;
+}
+
+static inline double timing_cycles_to_ns(uint64_t cycles) {
+    if (__builtin_expect(timing_ns_per_cycle_ == 0.0, 0)) timing_calibrate();
+    return (double)cycles * timing_ns_per_cycle_;
+}
+
+/* -------------------------- Overhead report ---------------------------- */
+// Cost per call (back-to-back reads) and resolution (smallest non-zero step).
+static inline void timing_measure_(uint64_t (*fn)(void), int is_cycles, double *cost_ns, double *res_ns) {
+    enum { N = 200000 };
+    uint64_t t0 = timing_now_ns();
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < N; i++) sink += fn();
+    *cost_ns = (double)(timing_now_ns() - t0) / N;
+    (void)sink;
+
+    uint64_t best = UINT64_MAX, prev = fn();
+    for (int i = 0; i < N; i++) {
+        uint64_t v = fn();
+        if (v != prev && v - prev < best) best = v - prev;
+        prev = v;
+    }
+    *res_ns = best == UINT64_MAX ? 0.0 : (is_cycles ? timing_cycles_to_ns(best) : (double)best);
+}
+
+static inline void timing_report(FILE *f) {
+    static const struct { const char *name; uint64_t (*fn)(void); int is_cycles; clockid_t id; } src[] = {
+        { "timing_now_ns    (MONOTONIC_RAW)", timing_now_ns,    0, TIMING_CLOCK_RAW },
+        { "timing_coarse_ns (COARSE)",        timing_coarse_ns, 0, TIMING_CLOCK_COARSE },
+        { "timing_cycles    (rdtscp/cntvct)", timing_cycles,    1, TIMING_CLOCK_RAW },
+    };
+    timing_calibrate();
+    fprintf(f, "%-34s %12s %14s\n", "source", "ns/call", "resolution ns");
+    for (size_t i = 0; i < sizeof(src) / sizeof(src[0]); i++) {
+        double cost, res;
+        timing_measure_(src[i].fn, src[i].is_cycles, &cost, &res);
+        struct timespec r;      // coarse clocks may not tick during the probe
+        if (res == 0.0 && clock_getres(src[i].id, &r) == 0) res = (double)r.tv_sec * 1e9 + (double)r.tv_nsec;
+        fprintf(f, "%-34s %12.1f %14.1f\n", src[i].name, cost, res);
+    }
+    fprintf(f, "counter: %.3f GHz, invariant: %s\n", 1.0 / timing_ns_per_cycle_,
+            timing_tsc_invariant() ? "yes" : "NO (prefer timing_now_ns)");
+}
+
+#endif /* COMMON_TIMING_H */
@@ -0,0 +1,171 @@
+// trace.h — low-overhead timeline tracing → Chrome trace JSON (Perfetto / chrome://tracing)
+//
+// Header-only. Compiled out unless the demo is built with -DTRACE:
+//   gcc -pthread -O2 -DTRACE -o thread_demo thread_demo.c
+//   TRACE_OUT=trace.json ./thread_demo        (default: trace.<pid>.json)
+//   open https://ui.perfetto.dev and load trace.json
+//
+// API (all no-ops without -DTRACE; names must be string literals):
+//   TRACE_BEGIN("name")    open a slice on the calling thread
+//   TRACE_END("name")      close the innermost slice
+//   TRACE_INSTANT("name")  zero-length marker
+//   TRACE_THREAD_NAME("n") label the calling thread's track
+//
+// Design:
+//   • One buffer per thread (thread-local pointer, registered once under a
+//     mutex); recording an event is a timestamp read + three stores.
+//   • Timestamps are raw cycle counters (rdtsc / cntvct_el0), converted to µs
+//     at exit against CLOCK_MONOTONIC, so the hot path never makes a syscall.
+//   • Full buffers drop new B/I events but keep a small reserve so every
+//     recorded B still gets its E; drops are reported on stderr.
+//   • The JSON is written from an atexit() handler.
+
+#ifndef COMMON_TRACE_H
+#define COMMON_TRACE_H
+
+#ifdef TRACE
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef TRACE_EVENTS_PER_THREAD
+#define TRACE_EVENTS_PER_THREAD (1u << 16)
+#endif
+#define TRACE_RESERVE 16    // slots kept for E events of already-open slices
+
+typedef struct {
+    uint64_t ts;
+    const char *name;
+    char ph;                // 'B', 'E', 'i', 'M'
+} trace_event_t;
+
+typedef struct trace_buf {
+    struct trace_buf *next;
+    long tid;
+    unsigned n, depth, skipped;
+    unsigned long dropped;
+    trace_event_t ev[TRACE_EVENTS_PER_THREAD];
+} trace_buf_t;
+
+static trace_buf_t *trace_bufs_;
+static pthread_mutex_t trace_mu_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once_ = PTHREAD_ONCE_INIT;
+static __thread trace_buf_t *trace_tb_;
+static uint64_t trace_tick0_;
+static struct timespec trace_mono0_;
+
+static inline uint64_t trace_ticks_(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v; __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v)); return v;
+#else
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void trace_flush_(void) {
+    struct timespec mono1; clock_gettime(CLOCK_MONOTONIC, &mono1);
+    uint64_t tick1 = trace_ticks_();
+    double ns = (double)(mono1.tv_sec - trace_mono0_.tv_sec) * 1e9 +
+                (double)(mono1.tv_nsec - trace_mono0_.tv_nsec);
+    double us_per_tick = (tick1 > trace_tick0_) ? ns / 1e3 / (double)(tick1 - trace_tick0_) : 0.0;
+
+    const char *path = getenv("TRACE_OUT");
+    char def[64];
+    if (!path || !*path) { snprintf(def, sizeof(def), "trace.%d.json", (int)getpid()); path = def; }
+    FILE *f = fopen(path, "w");
+    if (!f) { perror("trace: fopen"); return; }
+
+    pthread_mutex_lock(&trace_mu_);
+    unsigned long total = 0, dropped = 0;
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (trace_buf_t *b = trace_bufs_; b; b = b->next) {
+        for (unsigned i = 0; i < b->n; i++) {
+            const trace_event_t *e = &b->ev[i];
+            fprintf(f, "%s", first ? "" : ",\n");
+            first = 0;
+            if (e->ph == 'M') {
+                fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,"
+                           "\"args\":{\"name\":\"%s\"}}", (int)getpid(), b->tid, e->name);
+                continue;
+            }
+            double us = (double)(e->ts - trace_tick0_) * us_per_tick;
+            fprintf(f, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld%s}",
+                    e->name, e->ph, us, (int)getpid(), b->tid, e->ph == 'i' ? ",\"s\":\"t\"" : "");
+        }
+        total += b->n;
+        dropped += b->dropped;
+    }
+    fprintf(f, "\n]}\n");
+    pthread_mutex_unlock(&trace_mu_);
+    fclose(f);
+    fprintf(stderr, "[trace] wrote %lu events to %s", total, path);
+    if (dropped) fprintf(stderr, " (%lu dropped; raise TRACE_EVENTS_PER_THREAD)", dropped);
+    fprintf(stderr, "\n");
+}
+
+static void trace_init_(void) {
+    clock_gettime(CLOCK_MONOTONIC, &trace_mono0_);
+    trace_tick0_ = trace_ticks_();
+    atexit(trace_flush_);
+}
+
+static trace_buf_t *trace_buf_slow_(void) {
+    pthread_once(&trace_once_, trace_init_);
+    trace_buf_t *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    static long next_tid = 1;   // track ids in order of first event (main thread first)
+    pthread_mutex_lock(&trace_mu_);
+    b->tid = next_tid++;
+    b->next = trace_bufs_;
+    trace_bufs_ = b;
+    pthread_mutex_unlock(&trace_mu_);
+    return trace_tb_ = b;
+}
+
+static inline void trace_event_(const char *name, char ph) {
+    trace_buf_t *b = trace_tb_;
+    if (__builtin_expect(!b, 0) && !(b = trace_buf_slow_())) return;
+    if (ph == 'E') {
+        if (b->skipped) { b->skipped--; return; }   // its B was dropped
+        if (!b->depth) return;
+        b->depth--;                                 // reserve guarantees a slot
+    } else if (__builtin_expect(b->n >= TRACE_EVENTS_PER_THREAD - TRACE_RESERVE ||
+                                (ph == 'B' && b->depth >= TRACE_RESERVE), 0)) {
+        if (ph == 'B') b->skipped++;
+        b->dropped++;
+        return;
+    } else if (ph == 'B') {
+        b->depth++;
+    }
+    trace_event_t *e = &b->ev[b->n++];
+    e->ts = trace_ticks_();
+    e->name = name;
+    e->ph = ph;
+}
+
+#define TRACE_BEGIN(name)        trace_event_((name), 'B')
+#define TRACE_END(name)          trace_event_((name), 'E')
+#define TRACE_INSTANT(name)      trace_event_((name), 'i')
+#define TRACE_THREAD_NAME(name)  trace_event_((name), 'M')
+
+#else  /* !TRACE */
+
+#define TRACE_BEGIN(name)        ((void)0)
+#define TRACE_END(name)          ((void)0)
+#define TRACE_INSTANT(name)      ((void)0)
+#define TRACE_THREAD_NAME(name)  ((void)0)
+
+#endif /* TRACE */
+#endif /* COMMON_TRACE_H */
@@ -0,0 +1,363 @@
+// utf8.h — UTF-8 validation (Keiser & Lemire's lookup algorithm) with
+// SSSE3, AVX2 and AVX-512BW kernels picked at runtime, plus a sanitizer
+//
+// Header-only, always compiled in. "Valid" means well-formed per Unicode
+// Table 3-7: no overlong forms, no surrogates (ED A0..BF), nothing above
+// U+10FFFF, no C0/C1/F5..FF bytes, no sequence cut off by the end.
+//
+// API:
+//   utf8_valid(p, n)                    1 if p[0..n) is valid UTF-8 (SIMD)
+//   utf8_error_at(p, n)                 offset of the first ill-formed byte, or n
+//   utf8_replace(in, n, out, cap, &bad) copy in -> out, replacing each maximal
+//                                       ill-formed subpart with U+FFFD (the
+//                                       Unicode / WHATWG rule, what Python's
+//                                       errors="replace" does); returns bytes
+//                                       written. cap >= 3 * n always suffices.
+//   utf8_complete_len(p, n)             n without a trailing sequence that
+//                                       was cut off (e.g. by a full fgets buffer)
+//   utf8_policy_parse("replace")        reject | replace | pass, -1 if unknown
+//   utf8_isa() / utf8_use("avx2")       like strscan.h; UTF8_ISA=scalar|ssse3|
+//                                       avx2|avx512 does the same from the env
+//
+// The SIMD kernels look at every byte together with the 1, 2 and 3 bytes
+// before it. Three 16-entry table lookups (high nibble of the previous byte,
+// low nibble of the previous byte, high nibble of this byte) each return a
+// bitmask of error classes that pair *could* be in; their AND is non-zero
+// exactly when the pair is an error (ASCII then continuation, lead then
+// non-continuation, overlong, surrogate, too large, ...). The 3rd/4th bytes
+// of a sequence are checked by requiring "two continuations in a row" to
+// occur exactly where a lead two or three bytes back says it must.
+// A block that is all ASCII skips the lookups entirely. Loads are unaligned
+// and stay inside [p, p+n); the tail goes through a zero-padded copy.
+//
+// Non-x86 builds get the scalar kernel only. The kernel is picked once under
+// pthread_once, so batch workers can validate concurrently; utf8_use() is
+// for start-up, before any thread is running.
+
+#ifndef COMMON_UTF8_H
+#define COMMON_UTF8_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define UTF8_X86 1
+#include <immintrin.h>
+#endif
+
+typedef enum { UTF8_REJECT, UTF8_REPLACE, UTF8_PASS } utf8_policy_t;
+
+#define UTF8_REPLACE_CHUNK (64u << 10)   // utf8_replace validates this much at a time
+
+static inline int utf8_policy_parse(const char *name) {
+    if (!name) return -1;
+    if (strcmp(name, "reject") == 0) return UTF8_REJECT;
+    if (strcmp(name, "replace") == 0) return UTF8_REPLACE;
+    if (strcmp(name, "pass") == 0) return UTF8_PASS;
+    return -1;
+}
+
+/* ================================ Scalar ================================= */
+// Length of the sequence at p[0..n). *ok = 1: a valid character of that
+// length. *ok = 0: a maximal ill-formed subpart of that length (1..3 bytes).
+static inline size_t utf8_seq_(const unsigned char *p, size_t n, int *ok) {
+    unsigned c = p[0], lo = 0x80, hi = 0xBF;
+    size_t need;
+    *ok = 1;
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) need = 2;
+    else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        if (c == 0xE0) lo = 0xA0;               // overlong
+        if (c == 0xED) hi = 0x9F;               // surrogates
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        if (c == 0xF0) lo = 0x90;               // overlong
+        if (c == 0xF4) hi = 0x8F;               // above U+10FFFF
+    } else {
+        *ok = 0;
+        return 1;
+    }
+    for (size_t i = 1; i < need; i++, lo = 0x80, hi = 0xBF) {
+        if (i >= n || p[i] < lo || p[i] > hi) { *ok = 0; return i; }
+    }
+    return need;
+}
+
+static inline size_t utf8_error_at(const char *s, size_t n) {
+    const unsigned char *p = (const unsigned char *)s;
+    size_t i = 0;
+    while (i < n) {
+        if (i + 8 <= n) {                       // eight ASCII bytes at a time
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if (!(w & 0x8080808080808080ull)) { i += 8; continue; }
+        }
+        int ok;
+        size_t len = utf8_seq_(p + i, n - i, &ok);
+        if (!ok) return i;
+        i += len;
+    }
+    return n;
+}
+
+static inline int utf8_valid_scalar_(const char *s, size_t n) {
+    return utf8_error_at(s, n) == n;
+}
+
+static inline size_t utf8_complete_len(const char *s, size_t n) {
+    const unsigned char *p = (const unsigned char *)s;
+    // A cut-off sequence is a lead byte followed by fewer continuations
+    // than it announces; look back at most three bytes for it.
+    for (size_t k = 1; k <= 3 && k <= n; k++) {
+        unsigned c = p[n - k];
+        if ((c & 0xC0) == 0x80) continue;       // continuation: keep looking
+        size_t need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        return need > k ? n - k : n;
+    }
+    return n;
+}
+
+/* ============================== SIMD kernels ============================== */
+#ifdef UTF8_X86
+// Error classes, one bit each (first byte / second byte of a pair).
+#define UTF8_TOO_SHORT  (1 << 0)   // 11______ 0_______  or  11______ 11______
+#define UTF8_TOO_LONG   (1 << 1)   // 0_______ 10______
+#define UTF8_OVERLONG_3 (1 << 2)   // 11100000 100_____
+#define UTF8_TOO_LARGE  (1 << 3)   // 11110100 1001____ and above
+#define UTF8_SURROGATE  (1 << 4)   // 11101101 101_____
+#define UTF8_OVERLONG_2 (1 << 5)   // 1100000_ 10______
+#define UTF8_TOO_LARGE_1000 (1 << 6) // 11110101+ 1000____
+#define UTF8_OVERLONG_4 (1 << 6)   // 11110000 1000____
+#define UTF8_TWO_CONTS  (1 << 7)   // 10______ 10______
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+#define UTF8_TL (UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)
+#define UTF8_C2 (UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS)
+
+// High nibble of the previous byte.
+#define UTF8_BYTE1_HIGH                                                          \
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,                   \
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,                   \
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,               \
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,                                            \
+    UTF8_TOO_SHORT,                                                              \
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,                           \
+    UTF8_TOO_SHORT | UTF8_TL | UTF8_OVERLONG_4
+// Low nibble of the previous byte.
+#define UTF8_BYTE1_LOW                                                           \
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,            \
+    UTF8_CARRY | UTF8_OVERLONG_2,                                                \
+    UTF8_CARRY, UTF8_CARRY,                                                      \
+    UTF8_CARRY | UTF8_TOO_LARGE,                                                 \
+    UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL,            \
+    UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL,            \
+    UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL,                                  \
+    UTF8_CARRY | UTF8_TL | UTF8_SURROGATE,                                       \
+    UTF8_CARRY | UTF8_TL, UTF8_CARRY | UTF8_TL
+// High nibble of this byte.
+#define UTF8_BYTE2_HIGH                                                          \
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,              \
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,              \
+    UTF8_C2 | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,           \
+    UTF8_C2 | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,                                  \
+    UTF8_C2 | UTF8_SURROGATE | UTF8_TOO_LARGE,                                   \
+    UTF8_C2 | UTF8_SURROGATE | UTF8_TOO_LARGE,                                   \
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+
+// Per-ISA operations, pasted together by UTF8_KERNEL below.
+#define UTF8_ssse3_V            __m128i
+#define UTF8_ssse3_LOADU(p)     _mm_loadu_si128((const __m128i *)(p))
+#define UTF8_ssse3_SET1(c)      _mm_set1_epi8((char)(c))
+#define UTF8_ssse3_TABLE(...)   _mm_setr_epi8(__VA_ARGS__)
+#define UTF8_ssse3_LOOKUP(t, i) _mm_shuffle_epi8((t), (i))
+#define UTF8_ssse3_AND          _mm_and_si128
+#define UTF8_ssse3_OR           _mm_or_si128
+#define UTF8_ssse3_XOR          _mm_xor_si128
+#define UTF8_ssse3_SUBS         _mm_subs_epu8
+#define UTF8_ssse3_SRL4(v)      _mm_srli_epi16((v), 4)
+#define UTF8_ssse3_PREV(in, prev, k) _mm_alignr_epi8((in), (prev), 16 - (k))
+#define UTF8_ssse3_HIGH(v)      (_mm_movemask_epi8(v) != 0)
+#define UTF8_ssse3_ANY(v)       UTF8_SSE_NONZERO_(v)
+
+#define UTF8_avx2_V             __m256i
+#define UTF8_avx2_LOADU(p)      _mm256_loadu_si256((const __m256i *)(p))
+#define UTF8_avx2_SET1(c)       _mm256_set1_epi8((char)(c))
+#define UTF8_avx2_TABLE(...)    _mm256_broadcastsi128_si256(_mm_setr_epi8(__VA_ARGS__))
+#define UTF8_avx2_LOOKUP(t, i)  _mm256_shuffle_epi8((t), (i))
+#define UTF8_avx2_AND           _mm256_and_si256
+#define UTF8_avx2_OR            _mm256_or_si256
+#define UTF8_avx2_XOR           _mm256_xor_si256
+#define UTF8_avx2_SUBS          _mm256_subs_epu8
+#define UTF8_avx2_SRL4(v)       _mm256_srli_epi16((v), 4)
+#define UTF8_avx2_PREV(in, prev, k) \
+    _mm256_alignr_epi8((in), _mm256_permute2x128_si256((prev), (in), 0x21), 16 - (k))
+#define UTF8_avx2_HIGH(v)       (_mm256_movemask_epi8(v) != 0)
+#define UTF8_avx2_ANY(v)        (!_mm256_testz_si256((v), (v)))
+
+#define UTF8_avx512_V           __m512i
+#define UTF8_avx512_LOADU(p)    _mm512_loadu_si512((const void *)(p))
+#define UTF8_avx512_SET1(c)     _mm512_set1_epi8((char)(c))
+#define UTF8_avx512_TABLE(...)  _mm512_broadcast_i32x4(_mm_setr_epi8(__VA_ARGS__))
+#define UTF8_avx512_LOOKUP(t, i) _mm512_shuffle_epi8((t), (i))
+#define UTF8_avx512_AND         _mm512_and_si512
+#define UTF8_avx512_OR          _mm512_or_si512
+#define UTF8_avx512_XOR         _mm512_xor_si512
+#define UTF8_avx512_SUBS        _mm512_subs_epu8
+#define UTF8_avx512_SRL4(v)     _mm512_srli_epi16((v), 4)
+#define UTF8_avx512_PREV(in, prev, k) \
+    _mm512_alignr_epi8((in), _mm512_alignr_epi64((in), (prev), 6), 16 - (k))
+#define UTF8_avx512_HIGH(v)     (_mm512_movepi8_mask(v) != 0)
+#define UTF8_avx512_ANY(v)      (_mm512_test_epi8_mask((v), (v)) != 0)
+
+// SSSE3 has no ptest; look at the two halves instead.
+#define UTF8_SSE_NONZERO_(v) \
+    ((_mm_cvtsi128_si64(v) | _mm_cvtsi128_si64(_mm_unpackhi_epi64((v), (v)))) != 0)
+
+#define UTF8_OP(isa, op) UTF8_##isa##_##op
+
+#define UTF8_KERNEL(isa, W, TGT)                                                          \
+static TGT int utf8_valid_##isa##_(const char *s, size_t n) {                            \
+    typedef UTF8_OP(isa, V) V;                                                            \
+    const V b1h = UTF8_OP(isa, TABLE)(UTF8_BYTE1_HIGH);                                  \
+    const V b1l = UTF8_OP(isa, TABLE)(UTF8_BYTE1_LOW);                                   \
+    const V b2h = UTF8_OP(isa, TABLE)(UTF8_BYTE2_HIGH);                                  \
+    const V nib = UTF8_OP(isa, SET1)(0x0F), hi80 = UTF8_OP(isa, SET1)(0x80);             \
+    const V sub3 = UTF8_OP(isa, SET1)(0xE0 - 0x80), sub4 = UTF8_OP(isa, SET1)(0xF0 - 0x80); \
+    /* A lead in the last 1/2/3 bytes of a block needs the next block. */                 \
+    uint8_t maxv[W];                                                                      \
+    memset(maxv, 0xFF, W);                                                                \
+    maxv[W - 3] = 0xF0 - 1; maxv[W - 2] = 0xE0 - 1; maxv[W - 1] = 0xC0 - 1;               \
+    const V incomplete_max = UTF8_OP(isa, LOADU)(maxv);                                   \
+    V prev = UTF8_OP(isa, SET1)(0), err = prev, incomplete = prev;                        \
+    unsigned char tail[W];                                                                \
+    for (size_t i = 0; i < n; i += W) {                                                   \
+        V in;                                                                             \
+        if (i + W <= n) {                                                                 \
+            in = UTF8_OP(isa, LOADU)(s + i);                                              \
+        } else {                                                                          \
+            memset(tail, 0, W);                                                           \
+            memcpy(tail, s + i, n - i);                                                   \
+            in = UTF8_OP(isa, LOADU)(tail);                                               \
+        }                                                                                 \
+        if (!UTF8_OP(isa, HIGH)(in)) {          /* all ASCII */                           \
+            err = UTF8_OP(isa, OR)(err, incomplete);                                      \
+            incomplete = UTF8_OP(isa, SET1)(0);                                           \
+            prev = in;                                                                    \
+            continue;                                                                     \
+        }                                                                                 \
+        V p1 = UTF8_OP(isa, PREV)(in, prev, 1);                                           \
+        V sc = UTF8_OP(isa, AND)(                                                         \
+            UTF8_OP(isa, AND)(                                                            \
+                UTF8_OP(isa, LOOKUP)(b1h, UTF8_OP(isa, AND)(UTF8_OP(isa, SRL4)(p1), nib)), \
+                UTF8_OP(isa, LOOKUP)(b1l, UTF8_OP(isa, AND)(p1, nib))),                  \
+            UTF8_OP(isa, LOOKUP)(b2h, UTF8_OP(isa, AND)(UTF8_OP(isa, SRL4)(in), nib)));  \
+        V must23 = UTF8_OP(isa, OR)(                                                      \
+            UTF8_OP(isa, SUBS)(UTF8_OP(isa, PREV)(in, prev, 2), sub3),                    \
+            UTF8_OP(isa, SUBS)(UTF8_OP(isa, PREV)(in, prev, 3), sub4));                   \
+        err = UTF8_OP(isa, OR)(err, UTF8_OP(isa, XOR)(UTF8_OP(isa, AND)(must23, hi80), sc)); \
+        incomplete = UTF8_OP(isa, SUBS)(in, incomplete_max);                              \
+        prev = in;                                                                        \
+    }                                                                                     \
+    err = UTF8_OP(isa, OR)(err, incomplete);                                              \
+    return !UTF8_OP(isa, ANY)(err);                                                       \
+}
+
+UTF8_KERNEL(ssse3,  16, __attribute__((target("ssse3"))))
+UTF8_KERNEL(avx2,   32, __attribute__((target("avx2"))))
+UTF8_KERNEL(avx512, 64, __attribute__((target("avx512f,avx512bw"))))
+#endif /* UTF8_X86 */
+
+/* ================================ Dispatch ================================ */
+typedef struct {
+    const char *name;
+    int (*valid)(const char *, size_t);
+} utf8_impl_t;
+
+static const utf8_impl_t utf8_impls_[] = {
+    { "scalar", utf8_valid_scalar_ },
+#ifdef UTF8_X86
+    { "ssse3",  utf8_valid_ssse3_ },
+    { "avx2",   utf8_valid_avx2_ },
+    { "avx512", utf8_valid_avx512_ },
+#endif
+};
+#define UTF8_NIMPLS (sizeof(utf8_impls_) / sizeof(utf8_impls_[0]))
+
+static const utf8_impl_t *utf8_active_;
+static pthread_once_t utf8_pick_once_ = PTHREAD_ONCE_INIT;
+
+static inline int utf8_supported_(size_t idx) {
+#ifdef UTF8_X86
+    __builtin_cpu_init();
+    switch (idx) {
+        case 1: return __builtin_cpu_supports("ssse3");
+        case 2: return __builtin_cpu_supports("avx2");
+        case 3: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        default: break;
+    }
+#endif
+    return idx == 0;
+}
+
+static inline int utf8_use(const char *name) {
+    for (size_t i = 0; i < UTF8_NIMPLS; i++) {
+        if (strcmp(utf8_impls_[i].name, name) != 0) continue;
+        if (!utf8_supported_(i)) return -1;
+        utf8_active_ = &utf8_impls_[i];
+        return 0;
+    }
+    return -1;
+}
+
+static void utf8_pick_(void) {
+    if (utf8_active_) return;                   // utf8_use() already chose
+    const char *env = getenv("UTF8_ISA");
+    if (env && utf8_use(env) == 0) return;
+    for (size_t i = UTF8_NIMPLS; i-- > 0;)          // widest supported first
+        if (utf8_supported_(i)) { utf8_active_ = &utf8_impls_[i]; break; }
+}
+
+static inline const utf8_impl_t *utf8_impl_(void) {
+    pthread_once(&utf8_pick_once_, utf8_pick_);
+    return utf8_active_;
+}
+
+static inline const char *utf8_isa(void) { return utf8_impl_()->name; }
+
+static inline int utf8_valid(const char *p, size_t n) {
+    return utf8_impl_()->valid(p, n);
+}
+
+static inline size_t utf8_replace(const char *in, size_t n, char *out, size_t cap, size_t *bad) {
+    const unsigned char *p = (const unsigned char *)in;
+    size_t o = 0;
+    *bad = 0;
+    for (size_t i = 0; i < n;) {
+        // Valid chunks (the common case) are one SIMD pass and a memcpy;
+        // only a chunk with an error is walked a character at a time.
+        size_t j = n - i > UTF8_REPLACE_CHUNK ? i + utf8_complete_len(in + i, UTF8_REPLACE_CHUNK) : n;
+        if (o + (j - i) <= cap && utf8_valid(in + i, j - i)) {
+            memcpy(out + o, in + i, j - i);
+            o += j - i;
+            i = j;
+            continue;
+        }
+        do {
+            int ok;
+            size_t len = utf8_seq_(p + i, n - i, &ok);
+            size_t w = ok ? len : 3;
+            if (o + w > cap) return o;          // out of room: stop at a character boundary
+            if (ok) memcpy(out + o, in + i, len);
+            else { memcpy(out + o, "\xEF\xBF\xBD", 3); (*bad)++; }
+            o += w;
+            i += len;
+        } while (i < j);
+    }
+    return o;
+}
+
+#endif /* COMMON_UTF8_H */
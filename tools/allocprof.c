@@ -0,0 +1,354 @@
+// allocprof.c — LD_PRELOAD malloc/free interposer for allocation hot spots
+//
+// Build:  make -C tools            (produces tools/liballocprof.so)
+// Run:    LD_PRELOAD=./tools/liballocprof.so ./w6/dns_demo
+//         ALLOCPROF_OUT=alloc.txt ALLOCPROF_DEPTH=6 LD_PRELOAD=... ./w4/io_demo
+//
+// Environment:
+//   ALLOCPROF_OUT    report path (default: stderr)
+//   ALLOCPROF_DEPTH  frames captured per allocation, 0–16 (default 8; 0 = counts only)
+//   ALLOCPROF_TOP    call stacks listed in the report (default 10)
+//
+// What it records, per thread:
+//   • malloc/calloc/realloc/aligned counts, frees, requested bytes
+//   • a power-of-two size-class histogram
+//   • call sites keyed by a hash of the captured stack (count + bytes)
+// and globally: live bytes, peak live bytes, peak RSS (ru_maxrss / VmHWM).
+//
+// Locking: each thread owns its stats block (mmap'd, so it survives thread
+// exit for the final report). The only lock is taken once per thread to link
+// that block into the global list; live/peak bytes use relaxed atomics.
+// Allocations made by the profiler itself (dlsym, backtrace, reporting) are
+// not counted thanks to a thread-local re-entrancy guard.
+//
+// Linux / glibc only (dlsym(RTLD_NEXT), malloc_usable_size).
+
+#define _GNU_SOURCE
+#include <execinfo.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "elfsym.h"
+
+#define AP_MAX_DEPTH   16
+#define AP_SITES       4096         // per-thread call-site slots (power of two)
+#define AP_CLASSES     48           // size classes: [0], [1], [2,3], [4,7], ...
+#define AP_TLS         __attribute__((tls_model("initial-exec")))
+
+/* ============================== Real allocator ============================ */
+static void *(*real_malloc)(size_t);
+static void *(*real_calloc)(size_t, size_t);
+static void *(*real_realloc)(void *, size_t);
+static void  (*real_free)(void *);
+static int   (*real_posix_memalign)(void **, size_t, size_t);
+static void *(*real_aligned_alloc)(size_t, size_t);
+static void *(*real_memalign)(size_t, size_t);
+
+// dlsym() itself may calloc before real_calloc is known: serve it from here.
+static char boot_heap[16384] __attribute__((aligned(16)));
+static size_t boot_used;
+static int resolving;
+
+static int from_boot(const void *p) {
+    return (const char *)p >= boot_heap && (const char *)p < boot_heap + sizeof(boot_heap);
+}
+
+static void *boot_alloc(size_t n) {
+    n = (n + 15) & ~(size_t)15;
+    if (boot_used + n > sizeof(boot_heap)) return NULL;
+    void *p = boot_heap + boot_used;
+    boot_used += n;
+    return p;
+}
+
+static void resolve_real(void) {
+    if (real_malloc || resolving) return;
+    resolving = 1;
+    real_calloc         = dlsym(RTLD_NEXT, "calloc");
+    real_realloc        = dlsym(RTLD_NEXT, "realloc");
+    real_free           = dlsym(RTLD_NEXT, "free");
+    real_posix_memalign = dlsym(RTLD_NEXT, "posix_memalign");
+    real_aligned_alloc  = dlsym(RTLD_NEXT, "aligned_alloc");
+    real_memalign       = dlsym(RTLD_NEXT, "memalign");
+    real_malloc         = dlsym(RTLD_NEXT, "malloc");
+    resolving = 0;
+}
+
+/* ============================== Per-thread stats ========================== */
+typedef struct {
+    uint64_t hash;
+    unsigned long count, bytes;
+    int depth;
+    void *pc[AP_MAX_DEPTH];
+} site_t;
+
+typedef struct thread_stats {
+    struct thread_stats *next;
+    long tid;
+    unsigned long mallocs, callocs, reallocs, aligned, frees;
+    unsigned long bytes;
+    unsigned long classes[AP_CLASSES];
+    unsigned long sites_overflow;
+    site_t sites[AP_SITES];
+} thread_stats_t;
+
+static thread_stats_t *all_threads;
+static pthread_mutex_t all_mu = PTHREAD_MUTEX_INITIALIZER;
+static AP_TLS __thread thread_stats_t *my_stats;
+static AP_TLS __thread int in_hook;
+static _Atomic long live_bytes, peak_bytes;
+static int depth = 8;
+static int enabled;
+
+static thread_stats_t *stats_self(void) {
+    if (my_stats) return my_stats;
+    thread_stats_t *t = mmap(NULL, sizeof(*t), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (t == MAP_FAILED) return NULL;
+    t->tid = (long)syscall(SYS_gettid);
+    pthread_mutex_lock(&all_mu);
+    t->next = all_threads;
+    all_threads = t;
+    pthread_mutex_unlock(&all_mu);
+    return my_stats = t;
+}
+
+static int size_class(size_t n) {
+    int c = n ? 64 - __builtin_clzll((unsigned long long)n) : 0;
+    return c < AP_CLASSES ? c : AP_CLASSES - 1;
+}
+
+static void live_add(long delta) {
+    long now = atomic_fetch_add_explicit(&live_bytes, delta, memory_order_relaxed) + delta;
+    long peak = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    while (now > peak &&
+           !atomic_compare_exchange_weak_explicit(&peak_bytes, &peak, now,
+                                                  memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+// kind: offsetof(thread_stats_t, <counter>); caller: the hook's return address.
+static void record_alloc(void *p, size_t req, size_t kind, void *caller) {
+    if (!p || !enabled || in_hook) return;
+    in_hook = 1;
+    thread_stats_t *t = stats_self();
+    if (t) {
+        (*(unsigned long *)((char *)t + kind))++;
+        t->bytes += req;
+        t->classes[size_class(req)]++;
+
+        void *raw[AP_MAX_DEPTH + 2], **pc = raw;
+        int n = 1;
+        raw[0] = caller;
+        if (depth > 0) {
+            n = backtrace(raw, depth + 2) - 2;      // drop record_alloc + the hook
+            pc = raw + 2;
+            if (n < 0) n = 0;
+        }
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < n; i++) { h ^= (uint64_t)(uintptr_t)pc[i]; h *= 0x100000001b3ULL; }
+        if (!h) h = 1;
+        size_t j = h & (AP_SITES - 1);
+        for (size_t probe = 0; probe < 32; probe++, j = (j + 1) & (AP_SITES - 1)) {
+            site_t *s = &t->sites[j];
+            if (s->hash == h) { s->count++; s->bytes += req; goto done; }
+            if (!s->hash) {
+                s->hash = h; s->count = 1; s->bytes = req; s->depth = n;
+                memcpy(s->pc, pc, (size_t)n * sizeof(void *));
+                goto done;
+            }
+        }
+        t->sites_overflow++;
+    }
+done:
+    live_add((long)malloc_usable_size(p));
+    in_hook = 0;
+}
+
+#define KIND(field) offsetof(thread_stats_t, field), __builtin_return_address(0)
+
+// usable: malloc_usable_size of the block, taken before it was released;
+// counted: 0 when realloc resized the block in place (live bytes only).
+static void record_free(size_t usable, int counted) {
+    if (!enabled || in_hook) return;
+    in_hook = 1;
+    thread_stats_t *t = stats_self();
+    if (t && counted) t->frees++;
+    live_add(-(long)usable);
+    in_hook = 0;
+}
+
+/* ================================ Hooks =================================== */
+void *malloc(size_t n) {
+    resolve_real();
+    if (!real_malloc) return boot_alloc(n);
+    void *p = real_malloc(n);
+    record_alloc(p, n, KIND(mallocs));
+    return p;
+}
+
+void *calloc(size_t n, size_t sz) {
+    resolve_real();
+    if (!real_calloc) return boot_alloc(n * sz);    // boot_heap is zeroed
+    void *p = real_calloc(n, sz);
+    record_alloc(p, n * sz, KIND(callocs));
+    return p;
+}
+
+void *realloc(void *old, size_t n) {
+    resolve_real();
+    if (from_boot(old)) {
+        void *p = malloc(n);
+        size_t avail = (size_t)(boot_heap + sizeof(boot_heap) - (char *)old);
+        if (p) memcpy(p, old, n < avail ? n : avail);
+        return p;
+    }
+    size_t old_size = old ? malloc_usable_size(old) : 0;
+    void *p = real_realloc(old, n);
+    if (p) {
+        if (old) record_free(old_size, p != old);   // a move frees old; in place does not
+        record_alloc(p, n, KIND(reallocs));
+    } else if (old && !n) {
+        record_free(old_size, 1);                   // realloc(p, 0) released the block
+    }
+    return p;
+}
+
+void free(void *p) {
+    if (!p || from_boot(p)) return;
+    resolve_real();
+    record_free(malloc_usable_size(p), 1);
+    real_free(p);
+}
+
+int posix_memalign(void **out, size_t align, size_t n) {
+    resolve_real();
+    int rc = real_posix_memalign(out, align, n);
+    if (rc == 0) record_alloc(*out, n, KIND(aligned));
+    return rc;
+}
+
+void *aligned_alloc(size_t align, size_t n) {
+    resolve_real();
+    void *p = real_aligned_alloc(align, n);
+    record_alloc(p, n, KIND(aligned));
+    return p;
+}
+
+void *memalign(size_t align, size_t n) {
+    resolve_real();
+    void *p = real_memalign(align, n);
+    record_alloc(p, n, KIND(aligned));
+    return p;
+}
+
+/* =============================== Reporting ================================ */
+static int by_bytes(const void *a, const void *b) {
+    const site_t *x = *(site_t *const *)a, *y = *(site_t *const *)b;
+    return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+static long vm_hwm_kb(void) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f))
+        if (strncmp(line, "VmHWM:", 6) == 0) { kb = atol(line + 6); break; }
+    fclose(f);
+    return kb;
+}
+
+__attribute__((constructor))
+static void allocprof_start(void) {
+    resolve_real();
+    const char *d = getenv("ALLOCPROF_DEPTH");
+    if (d) { depth = atoi(d); if (depth < 0) depth = 0; if (depth > AP_MAX_DEPTH) depth = AP_MAX_DEPTH; }
+    in_hook = 1;
+    void *warm[4];
+    backtrace(warm, 4);                 // loads libgcc_s before we start counting
+    in_hook = 0;
+    enabled = 1;
+}
+
+__attribute__((destructor))
+static void allocprof_report(void) {
+    in_hook = 1;
+    enabled = 0;
+    const char *path = getenv("ALLOCPROF_OUT");
+    FILE *f = path && *path ? fopen(path, "w") : stderr;
+    if (!f) f = stderr;
+    int top = getenv("ALLOCPROF_TOP") ? atoi(getenv("ALLOCPROF_TOP")) : 10;
+
+    // Merge per-thread call sites by stack hash (open addressing, 2x slack).
+    size_t cap = 2, nthreads = 0;
+    for (thread_stats_t *t = all_threads; t; t = t->next) { cap += 2 * AP_SITES; nthreads++; }
+    while (cap & (cap - 1)) cap += cap & -cap;      // round up to a power of two
+    site_t *merged = calloc(cap, sizeof(site_t));
+    site_t **order = calloc(cap, sizeof(site_t *));
+    size_t nmerged = 0;
+    unsigned long classes[AP_CLASSES] = {0}, overflow = 0;
+    unsigned long tot_alloc = 0, tot_free = 0, tot_bytes = 0;
+
+    fprintf(f, "==== allocprof: pid %d, %zu thread(s) ====\n", (int)getpid(), nthreads);
+    fprintf(f, "%8s %10s %10s %10s %10s %10s %14s\n",
+            "tid", "malloc", "calloc", "realloc", "aligned", "free", "bytes");
+    for (thread_stats_t *t = all_threads; t; t = t->next) {
+        fprintf(f, "%8ld %10lu %10lu %10lu %10lu %10lu %14lu\n", t->tid, t->mallocs,
+                t->callocs, t->reallocs, t->aligned, t->frees, t->bytes);
+        tot_alloc += t->mallocs + t->callocs + t->reallocs + t->aligned;
+        tot_free += t->frees;
+        tot_bytes += t->bytes;
+        overflow += t->sites_overflow;
+        for (int c = 0; c < AP_CLASSES; c++) classes[c] += t->classes[c];
+        for (size_t i = 0; merged && order && i < AP_SITES; i++) {
+            const site_t *s = &t->sites[i];
+            if (!s->hash) continue;
+            size_t k = s->hash & (cap - 1);
+            while (merged[k].hash && merged[k].hash != s->hash) k = (k + 1) & (cap - 1);
+            if (!merged[k].hash) { merged[k] = *s; order[nmerged++] = &merged[k]; }
+            else { merged[k].count += s->count; merged[k].bytes += s->bytes; }
+        }
+    }
+    fprintf(f, "total: %lu allocations, %lu frees, %lu bytes requested\n", tot_alloc, tot_free, tot_bytes);
+    fprintf(f, "live at exit: %ld bytes   peak live: %ld bytes\n",
+            atomic_load(&live_bytes), atomic_load(&peak_bytes));
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    fprintf(f, "peak RSS: %ld KiB (ru_maxrss), %ld KiB (VmHWM)\n", ru.ru_maxrss, vm_hwm_kb());
+
+    fprintf(f, "\nsize classes (requested bytes):\n");
+    for (int c = 0; c < AP_CLASSES; c++) {
+        if (!classes[c]) continue;
+        unsigned long lo = c ? 1ul << (c - 1) : 0, hi = c ? (1ul << c) - 1 : 0;
+        fprintf(f, "  [%10lu, %10lu] %10lu\n", lo, hi, classes[c]);
+    }
+
+    if (merged && order) {
+        qsort(order, nmerged, sizeof(*order), by_bytes);
+        fprintf(f, "\ntop %d call stacks by bytes (%zu unique%s):\n", top, nmerged,
+                overflow ? ", some sites dropped: table full" : "");
+        char name[256];
+        for (size_t i = 0; i < nmerged && (int)i < top; i++) {
+            const site_t *s = order[i];
+            fprintf(f, "#%zu  %lu bytes in %lu allocations  [%016llx]\n", i + 1, s->bytes,
+                    s->count, (unsigned long long)s->hash);
+            for (int d = 0; d < s->depth; d++) {
+                elfsym_name((void *)((uintptr_t)s->pc[d] - 1), name, sizeof(name));
+                fprintf(f, "      %s\n", name);
+            }
+        }
+    }
+    if (f != stderr) fclose(f);
+    free(order);
+    free(merged);
+}
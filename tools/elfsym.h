@@ -0,0 +1,119 @@
+// elfsym.h — PC → function name for the preloadable tools (sprof, allocprof)
+//
+// Reads STT_FUNC symbols from each module's ELF .symtab (falling back to
+// .dynsym), so static functions in the demos resolve even though dladdr()
+// cannot see them. Modules are found with dladdr() and loaded lazily.
+// Not thread-safe and allocates: call only from exit-time reporting.
+//
+// Linux / ELF64 only. Needs _GNU_SOURCE (dladdr) before the first include.
+
+#ifndef TOOLS_ELFSYM_H
+#define TOOLS_ELFSYM_H
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct { uintptr_t lo, hi; const char *name; } elfsym_t;
+typedef struct {
+    char path[256];
+    uintptr_t bias;         // runtime address - link-time address
+    elfsym_t *syms;
+    size_t nsyms;
+    int loaded;
+} elfsym_module_t;
+
+static elfsym_module_t elfsym_modules_[64];
+static size_t elfsym_nmodules_;
+
+static int elfsym_cmp_(const void *a, const void *b) {
+    const elfsym_t *x = a, *y = b;
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+// Load STT_FUNC symbols from .symtab (or .dynsym when stripped).
+static void elfsym_load_(elfsym_module_t *m) {
+    m->loaded = 1;
+    int fd = open(m->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Elf64_Ehdr)) { close(fd); return; }
+    const unsigned char *img = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (img == MAP_FAILED) return;
+
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)img;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf64_Shdr) > (size_t)st.st_size) {
+        munmap((void *)img, (size_t)st.st_size);
+        return;
+    }
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(img + eh->e_shoff);
+    const Elf64_Shdr *symtab = NULL;
+    for (int i = 0; i < eh->e_shnum; i++)
+        if (sh[i].sh_type == SHT_SYMTAB) symtab = &sh[i];
+    if (!symtab)
+        for (int i = 0; i < eh->e_shnum; i++)
+            if (sh[i].sh_type == SHT_DYNSYM) symtab = &sh[i];
+    if (!symtab || symtab->sh_link >= eh->e_shnum) { munmap((void *)img, (size_t)st.st_size); return; }
+
+    const Elf64_Shdr *strtab = &sh[symtab->sh_link];
+    size_t n = symtab->sh_size / sizeof(Elf64_Sym);
+    const Elf64_Sym *sym = (const Elf64_Sym *)(img + symtab->sh_offset);
+    m->syms = calloc(n ? n : 1, sizeof(elfsym_t));
+    if (!m->syms) { munmap((void *)img, (size_t)st.st_size); return; }
+    for (size_t i = 0; i < n; i++) {
+        if (ELF64_ST_TYPE(sym[i].st_info) != STT_FUNC || sym[i].st_value == 0) continue;
+        if (sym[i].st_name >= strtab->sh_size) continue;
+        elfsym_t *d = &m->syms[m->nsyms++];
+        d->lo = (uintptr_t)sym[i].st_value;
+        d->hi = d->lo + (sym[i].st_size ? sym[i].st_size : 1);
+        d->name = strdup((const char *)img + strtab->sh_offset + sym[i].st_name);
+    }
+    qsort(m->syms, m->nsyms, sizeof(elfsym_t), elfsym_cmp_);
+    munmap((void *)img, (size_t)st.st_size);
+}
+
+static elfsym_module_t *elfsym_module_for_(const Dl_info *di) {
+    for (size_t i = 0; i < elfsym_nmodules_; i++)
+        if (strcmp(elfsym_modules_[i].path, di->dli_fname) == 0) return &elfsym_modules_[i];
+    if (elfsym_nmodules_ == sizeof(elfsym_modules_) / sizeof(elfsym_modules_[0])) return NULL;
+    elfsym_module_t *m = &elfsym_modules_[elfsym_nmodules_++];
+    snprintf(m->path, sizeof(m->path), "%s", di->dli_fname);
+    // Main executable shows up under its argv[0] name; read it via /proc.
+    if (!strchr(m->path, '/') || access(m->path, R_OK) != 0)
+        snprintf(m->path, sizeof(m->path), "/proc/self/exe");
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)di->dli_fbase;
+    m->bias = (eh->e_type == ET_DYN) ? (uintptr_t)di->dli_fbase : 0;
+    return m;
+}
+
+// Write "name" for pc into out; falls back to module+offset.
+static void elfsym_name(void *pc, char *out, size_t cap) {
+    Dl_info di;
+    if (!dladdr(pc, &di) || !di.dli_fname) { snprintf(out, cap, "[unknown]"); return; }
+    elfsym_module_t *m = elfsym_module_for_(&di);
+    if (m) {
+        if (!m->loaded) elfsym_load_(m);
+        uintptr_t a = (uintptr_t)pc - m->bias;
+        size_t lo = 0, hi = m->nsyms;
+        while (lo < hi) {               // last symbol with start <= a
+            size_t mid = (lo + hi) / 2;
+            if (m->syms[mid].lo <= a) lo = mid + 1; else hi = mid;
+        }
+        if (lo > 0 && a < m->syms[lo - 1].hi) { snprintf(out, cap, "%s", m->syms[lo - 1].name); return; }
+    }
+    if (di.dli_sname) { snprintf(out, cap, "%s", di.dli_sname); return; }
+    const char *base = strrchr(di.dli_fname, '/');
+    snprintf(out, cap, "%s+0x%lx", base ? base + 1 : di.dli_fname,
+             (unsigned long)((uintptr_t)pc - (uintptr_t)di.dli_fbase));
+}
+
+#endif /* TOOLS_ELFSYM_H */
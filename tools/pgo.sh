@@ -0,0 +1,177 @@
+#!/usr/bin/env bash
+# pgo.sh — Profile-guided + link-time optimized builds of every week's demo
+#
+# Run:  ./tools/pgo.sh            (or: make pgo from the repo root)
+#
+# For each demo and each available compiler (gcc, clang) this:
+#   1) builds a baseline with the same flags as the week's Makefile,
+#   2) builds an instrumented binary and runs it on a fixed training input
+#      (stdin is scripted, so no ENTER presses are needed),
+#   3) rebuilds with -fprofile-use -flto,
+#   4) times baseline vs PGO+LTO (median of PGO_RUNS runs) and prints a speedup.
+#
+# Knobs (environment):
+#   PGO_DEMOS      space-separated subset of: demo syscall_demo copy_sim thread_demo
+#                  io_demo thread_recitation dns_demo   (default: all)
+#   PGO_COMPILERS  default "gcc clang"; missing compilers are skipped
+#   PGO_RUNS       timed runs per binary (default 5)
+#   PGO_OUT        work directory (default _pgo/ in the repo root)
+#   LLVM_PROFDATA  llvm-profdata binary matching your clang (default: llvm-profdata)
+#
+# Notes:
+#   • Every source is compiled as "-c src.c -o src.o" in the same directory for
+#     the generate and use steps, so gcc finds src.gcda without path mangling.
+#   • -fprofile-update=prefer-atomic keeps counters sane in the threaded demos.
+#   • dns_demo is network-bound; its "speedup" mostly measures the resolver.
+
+set -u
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${PGO_OUT:-$ROOT/_pgo}
+RUNS=${PGO_RUNS:-5}
+COMPILERS=${PGO_COMPILERS:-gcc clang}
+DEMOS=${PGO_DEMOS:-demo syscall_demo copy_sim thread_demo io_demo thread_recitation dns_demo}
+LLVM_PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+
+# ---------------------------- Demo table ---------------------------------
+# name -> sources, compile flags (mirroring the week Makefile), libs, stdin, args
+demo_src() {
+    case $1 in
+        demo)              echo w0/demo.c ;;
+        syscall_demo)      echo w1/syscall_demo.c ;;
+        copy_sim)          echo w2/copy_sim.c w2/copy_user.c ;;
+        thread_demo)       echo w3/thread_demo.c ;;
+        io_demo)           echo w4/io_demo.c w4/tokstats.c w4/checkpoint.c w4/fparse.c w4/reportsum.c \
+                                w4/lzblock.c w4/batch.c w4/passthru.c w4/toksort.c ;;
+        thread_recitation) echo w5/thread_recitation.c ;;
+        dns_demo)          echo w6/dns_demo.c ;;
+        *)                 return 1 ;;
+    esac
+}
+
+demo_cflags() {
+    case $1 in
+        demo)              echo "-std=c17 -O2 -DNDEBUG" ;;
+        thread_demo)       echo "-O2 -pthread -DTHREADS=8 -DITERATIONS=200000" ;;
+        thread_recitation|dns_demo)
+                           echo "-O2 -pthread -DTHREADS=8 -DITERATIONS=100000" ;;
+        copy_sim|io_demo)  echo "-O2 -pthread" ;;
+        *)                 echo "-O2" ;;
+    esac
+}
+
+demo_libs() {
+    case $1 in
+        copy_sim|thread_demo|thread_recitation) echo "-pthread" ;;
+        dns_demo)                      echo "-pthread -lresolv" ;;
+        io_demo)                       echo "-pthread -lm" ;;
+        *)                             echo "" ;;
+    esac
+}
+
+# Scripted answers to every wait_for_enter()/fgets() prompt.
+demo_stdin() {
+    case $1 in
+        io_demo)
+            printf '\nthe quick brown fox 12 jumps over 34 lazy dogs -5 times 99\n\n\n\n\nlabel\n' ;;
+        thread_recitation)
+            printf '\n\n\n\n\nlabel\n\n\n\n' ;;
+        dns_demo)
+            printf '\n\n\n\n\n\n\n' ;;
+        *)
+            : ;;
+    esac
+}
+
+demo_args() {
+    case $1 in
+        io_demo) echo "$2/report.txt" ;;
+        *)       echo "" ;;
+    esac
+}
+
+# ---------------------------- Helpers ------------------------------------
+now_ns() { date +%s%N; }
+
+# Median wall time (ns) of RUNS executions of $1 on the demo's training input.
+time_median() {
+    local bin=$1 name=$2 dir=$3 i t0 t1
+    local -a samples=()
+    for ((i = 0; i < RUNS; i++)); do
+        t0=$(now_ns)
+        demo_stdin "$name" | "$bin" $(demo_args "$name" "$dir") > /dev/null 2>&1
+        t1=$(now_ns)
+        samples+=($((t1 - t0)))
+    done
+    printf '%s\n' "${samples[@]}" | sort -n | sed -n "$(((RUNS + 1) / 2))p"
+}
+
+build() { # build <name> <cc> <dir> <out> <extra cflags> <extra ldflags>
+    local name=$1 cc=$2 dir=$3 out=$4 extra_c=$5 extra_ld=$6 src
+    local -a objs=()
+    for src in $(demo_src "$name"); do
+        objs+=("$(basename "$src" .c).o")
+        ( cd "$dir" && $cc $(demo_cflags "$name") $extra_c -c "$ROOT/$src" -o "${objs[-1]}" ) || return 1
+    done
+    ( cd "$dir" && $cc $(demo_cflags "$name") $extra_c "${objs[@]}" -o "$out" $extra_ld $(demo_libs "$name") )
+}
+
+# ---------------------------- Pipeline -----------------------------------
+printf '%-18s %-6s %12s %12s %9s\n' demo cc base_ms pgo_ms speedup
+printf '%-18s %-6s %12s %12s %9s\n' ------------------ ------ ------------ ------------ ---------
+
+status=0
+for cc in $COMPILERS; do
+    if ! command -v "$cc" > /dev/null 2>&1; then
+        echo "[pgo] $cc not found; skipping" >&2
+        continue
+    fi
+    if [ "$cc" = clang ] && ! command -v "$LLVM_PROFDATA" > /dev/null 2>&1; then
+        echo "[pgo] $LLVM_PROFDATA not found; skipping clang" >&2
+        continue
+    fi
+
+    for name in $DEMOS; do
+        if ! demo_src "$name" > /dev/null; then
+            echo "[pgo] unknown demo '$name'" >&2
+            status=1
+            continue
+        fi
+        dir=$OUT/$cc/$name
+        rm -rf "$dir" && mkdir -p "$dir"
+
+        if [ "$cc" = clang ]; then
+            gen_c="-fprofile-instr-generate=$dir/%p.profraw"
+            gen_ld="-fprofile-instr-generate=$dir/%p.profraw"
+            use_c="-fprofile-instr-use=$dir/$name.profdata -flto"
+            use_ld="-flto -fuse-ld=lld"
+        else
+            gen_c="-fprofile-generate -fprofile-update=prefer-atomic"
+            gen_ld="-fprofile-generate"
+            use_c="-fprofile-use -fprofile-correction -Wno-missing-profile -flto=auto"
+            use_ld="-flto=auto"
+        fi
+
+        # 1) baseline (same flags as the week Makefile)
+        build "$name" "$cc" "$dir" "$name.base" "" "" || { status=1; continue; }
+
+        # 2) instrumented build + training run
+        build "$name" "$cc" "$dir" "$name.gen" "$gen_c" "$gen_ld" || { status=1; continue; }
+        demo_stdin "$name" | ( cd "$dir" && "./$name.gen" $(demo_args "$name" "$dir") ) > /dev/null 2>&1
+        if [ "$cc" = clang ]; then
+            "$LLVM_PROFDATA" merge -output="$dir/$name.profdata" "$dir"/*.profraw || { status=1; continue; }
+        fi
+
+        # 3) profile-guided + LTO rebuild (same object names, so each .gcda matches)
+        build "$name" "$cc" "$dir" "$name.pgo" "$use_c" "$use_ld" || { status=1; continue; }
+
+        # 4) report
+        base=$(time_median "$dir/$name.base" "$name" "$dir")
+        pgo=$(time_median "$dir/$name.pgo" "$name" "$dir")
+        awk -v n="$name" -v c="$cc" -v b="$base" -v p="$pgo" 'BEGIN {
+            printf "%-18s %-6s %12.2f %12.2f %8.2fx\n", n, c, b / 1e6, p / 1e6, (p > 0 ? b / p : 0)
+        }'
+    done
+done
+
+exit $status
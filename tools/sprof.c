@@ -0,0 +1,249 @@
+// sprof.c — tiny in-process SIGPROF sampling profiler (folded-stack output)
+//
+// Build:  make -C tools            (produces tools/libsprof.so)
+// Run:    SPROF=out.folded LD_PRELOAD=./tools/libsprof.so ./w3/thread_demo
+//         ./flamegraph.pl out.folded > out.svg
+//
+// Environment:
+//   SPROF      output path ("1" → sprof.<pid>.folded); unset = profiler stays off
+//   SPROF_HZ   sampling rate in Hz of consumed CPU time (default 1000)
+//
+// How it works:
+//   • setitimer(ITIMER_PROF) delivers SIGPROF to whichever thread is burning CPU.
+//   • The handler grabs the stack with backtrace() and pushes it into a bounded
+//     lock-free MPSC ring (per-slot sequence numbers; full ring → sample dropped).
+//     backtrace() is warmed up once at startup so libgcc is already loaded and
+//     the handler never allocates.
+//   • A drain thread folds samples into a stack→count table every few ms.
+//   • At exit, PCs are symbolized via elfsym.h (ELF .symtab, so static
+//     functions in the demos resolve too), falling back to dladdr, and written
+//     as Brendan Gregg "frame;frame;frame count" lines that flamegraph.pl reads.
+//
+// Linux only (ITIMER_PROF semantics, /proc/self/exe, ELF).
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "elfsym.h"
+
+#define SPROF_MAX_DEPTH   48
+#define SPROF_RING_SLOTS  4096          // power of two
+#define SPROF_SKIP        2             // handler + signal trampoline
+#define SPROF_DRAIN_NS    20000000L     // 20 ms
+
+/* ========================== Lock-free sample ring ========================= */
+typedef struct {
+    _Atomic size_t seq;
+    int depth;
+    void *pc[SPROF_MAX_DEPTH];
+} slot_t;
+
+static slot_t ring[SPROF_RING_SLOTS];
+static _Atomic size_t ring_tail;        // producers (signal handlers)
+static size_t ring_head;                // single consumer (drain thread / exit)
+static _Atomic unsigned long dropped;
+static _Atomic int sampling;
+
+static void on_sigprof(int sig, siginfo_t *si, void *uc) {
+    (void)sig; (void)si; (void)uc;
+    if (!atomic_load_explicit(&sampling, memory_order_relaxed)) return;
+    int saved_errno = errno;
+
+    size_t pos = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    slot_t *s;
+    for (;;) {
+        s = &ring[pos & (SPROF_RING_SLOTS - 1)];
+        size_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(&ring_tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (seq < pos) {         // consumer has not freed this slot yet
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            errno = saved_errno;
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+        }
+    }
+    void *tmp[SPROF_MAX_DEPTH + SPROF_SKIP];
+    int n = backtrace(tmp, SPROF_MAX_DEPTH + SPROF_SKIP) - SPROF_SKIP;
+    if (n < 0) n = 0;
+    memcpy(s->pc, tmp + SPROF_SKIP, (size_t)n * sizeof(void *));
+    s->depth = n;
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+    errno = saved_errno;
+}
+
+/* ======================= Aggregated stacks (consumer) ===================== */
+typedef struct {
+    uint64_t hash;
+    unsigned long count;
+    int depth;
+    void **pc;
+} folded_t;
+
+static folded_t *stacks;
+static size_t stacks_cap, stacks_len;
+static unsigned long total_samples;
+
+static uint64_t hash_pcs(void *const *pc, int n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < n; i++) { h ^= (uint64_t)(uintptr_t)pc[i]; h *= 0x100000001b3ULL; }
+    return h ? h : 1;
+}
+
+static void stacks_grow(void) {
+    size_t ncap = stacks_cap ? stacks_cap * 2 : 1024;
+    folded_t *n = calloc(ncap, sizeof(*n));
+    if (!n) return;
+    for (size_t i = 0; i < stacks_cap; i++) {
+        if (!stacks[i].hash) continue;
+        size_t j = stacks[i].hash & (ncap - 1);
+        while (n[j].hash) j = (j + 1) & (ncap - 1);
+        n[j] = stacks[i];
+    }
+    free(stacks);
+    stacks = n;
+    stacks_cap = ncap;
+}
+
+static void stacks_add(void *const *pc, int depth) {
+    if (stacks_len * 2 >= stacks_cap) stacks_grow();
+    if (!stacks_cap) return;
+    uint64_t h = hash_pcs(pc, depth);
+    size_t j = h & (stacks_cap - 1);
+    while (stacks[j].hash) {
+        if (stacks[j].hash == h && stacks[j].depth == depth &&
+            memcmp(stacks[j].pc, pc, (size_t)depth * sizeof(void *)) == 0) {
+            stacks[j].count++;
+            return;
+        }
+        j = (j + 1) & (stacks_cap - 1);
+    }
+    void **copy = malloc((size_t)(depth ? depth : 1) * sizeof(void *));
+    if (!copy) return;
+    memcpy(copy, pc, (size_t)depth * sizeof(void *));
+    stacks[j] = (folded_t){ .hash = h, .count = 1, .depth = depth, .pc = copy };
+    stacks_len++;
+}
+
+static void drain_ring(void) {
+    for (;;) {
+        slot_t *s = &ring[ring_head & (SPROF_RING_SLOTS - 1)];
+        if (atomic_load_explicit(&s->seq, memory_order_acquire) != ring_head + 1) return;
+        stacks_add(s->pc, s->depth);
+        total_samples++;
+        atomic_store_explicit(&s->seq, ring_head + SPROF_RING_SLOTS, memory_order_release);
+        ring_head++;
+    }
+}
+
+static pthread_t drain_tid;
+static _Atomic int drain_stop;
+
+static void *drain_main(void *arg) {
+    (void)arg;
+    // The drain thread never needs a sample of its own.
+    sigset_t set; sigemptyset(&set); sigaddset(&set, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    struct timespec ts = { 0, SPROF_DRAIN_NS };
+    while (!atomic_load(&drain_stop)) {
+        drain_ring();
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+/* ============================== Lifecycle ================================ */
+static char out_path[512];
+static int active;
+static pid_t owner;                     // the process that started profiling
+
+static void write_folded(void) {
+    FILE *f = fopen(out_path, "w");
+    if (!f) { fprintf(stderr, "[sprof] cannot open '%s' (%s)\n", out_path, strerror(errno)); return; }
+
+    char comm[64] = "process";
+    FILE *cf = fopen("/proc/self/comm", "r");
+    if (cf) { if (fgets(comm, sizeof(comm), cf)) comm[strcspn(comm, "\n")] = '\0'; fclose(cf); }
+
+    char name[256];
+    for (size_t i = 0; i < stacks_cap; i++) {
+        folded_t *s = &stacks[i];
+        if (!s->hash) continue;
+        fputs(comm, f);
+        for (int d = s->depth - 1; d >= 0; d--) {   // root first
+            // Return addresses point after the call; look up the call itself.
+            void *pc = (d == 0) ? s->pc[d] : (void *)((uintptr_t)s->pc[d] - 1);
+            elfsym_name(pc, name, sizeof(name));
+            for (char *c = name; *c; c++) if (*c == ';' || *c == ' ') *c = '_';
+            fputc(';', f);
+            fputs(name, f);
+        }
+        fprintf(f, " %lu\n", s->count);
+    }
+    fclose(f);
+    fprintf(stderr, "[sprof] %lu samples (%lu dropped), %zu unique stacks -> %s\n",
+            total_samples, atomic_load(&dropped), stacks_len, out_path);
+}
+
+__attribute__((constructor))
+static void sprof_start(void) {
+    const char *env = getenv("SPROF");
+    if (!env || !*env) return;
+    if (strcmp(env, "1") == 0) snprintf(out_path, sizeof(out_path), "sprof.%d.folded", (int)getpid());
+    else snprintf(out_path, sizeof(out_path), "%s", env);
+    // An exec'd child must not start its own profiler on our path; a forked
+    // one is stopped by the pid check in sprof_stop.
+    unsetenv("SPROF");
+    owner = getpid();
+
+    long hz = 1000;
+    const char *hz_env = getenv("SPROF_HZ");
+    if (hz_env && atol(hz_env) > 0) hz = atol(hz_env);
+
+    for (size_t i = 0; i < SPROF_RING_SLOTS; i++) atomic_init(&ring[i].seq, i);
+    void *warm[4];
+    backtrace(warm, 4);                 // loads libgcc_s outside signal context
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = on_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0) { perror("[sprof] sigaction"); return; }
+    if (pthread_create(&drain_tid, NULL, drain_main, NULL) != 0) return;
+
+    atomic_store(&sampling, 1);
+    long usec = 1000000L / hz;
+    struct itimerval it = { { 0, usec ? usec : 1 }, { 0, usec ? usec : 1 } };
+    if (setitimer(ITIMER_PROF, &it, NULL) != 0) { perror("[sprof] setitimer"); return; }
+    active = 1;
+}
+
+__attribute__((destructor))
+static void sprof_stop(void) {
+    // A forked child inherits `active` but not the drain thread or the
+    // itimer: joining would fail and its exit() would overwrite our profile.
+    if (!active || getpid() != owner) return;
+    active = 0;
+    struct itimerval off = { { 0, 0 }, { 0, 0 } };
+    setitimer(ITIMER_PROF, &off, NULL);
+    atomic_store(&sampling, 0);
+    atomic_store(&drain_stop, 1);
+    pthread_join(drain_tid, NULL);
+    drain_ring();
+    write_folded();
+}
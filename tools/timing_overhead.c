@@ -0,0 +1,16 @@
+// timing_overhead.c — print the cost and resolution of every common/timing.h clock
+//
+// Build:  make -C tools            (produces tools/timing_overhead)
+// Run:    ./tools/timing_overhead
+//
+// Use it to pick a source: timing_cycles() for sub-100 ns regions when the
+// counter is invariant, timing_now_ns() otherwise, timing_coarse_ns() for
+// cheap "roughly when" stamps in hot loops.
+
+#include "../common/timing.h"
+
+int main(void) {
+    printf("=== Timestamp sources on this machine ===\n\n");
+    timing_report(stdout);
+    return 0;
+}
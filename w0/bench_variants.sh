@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+# bench_variants.sh — slowdown and memory overhead of every w0 build variant
+#
+# Usage (normally via `make bench`, which passes the Makefile's flags):
+#   BENCH_RUNS=5 ./bench_variants.sh
+#
+# Builds scramble_bench.c with each flag set from w0/Makefile into _bench/,
+# runs every binary BENCH_RUNS times, and reports the median wall time and
+# median peak RSS relative to the release build. Variants whose compiler is
+# missing are listed as skipped.
+
+set -u
+cd "$(dirname "$0")"
+
+CC=${CC:-gcc}
+CFLAGS_DEBUG=${CFLAGS_DEBUG:--std=c17 -Wall -Wextra -pedantic -O0 -g}
+CFLAGS_SAN=${CFLAGS_SAN:--std=c17 -O1 -g -fno-omit-frame-pointer -fsanitize=address,undefined -fno-sanitize-recover=all}
+CFLAGS_REL=${CFLAGS_REL:--std=c17 -O2 -DNDEBUG}
+RUNS=${BENCH_RUNS:-5}
+OUT=_bench
+SRC=scramble_bench.c
+
+# name|compiler|flags   (release first: it is the baseline)
+VARIANTS=(
+    "release|$CC|$CFLAGS_REL"
+    "debug|$CC|$CFLAGS_DEBUG"
+    "asan+ubsan|$CC|$CFLAGS_SAN"
+    "clang-debug|clang|$CFLAGS_DEBUG"
+    "clang-asan+ubsan|clang|$CFLAGS_SAN"
+)
+
+median() { sort -n | awk '{ v[NR] = $1 } END { print (NR % 2) ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2 }'; }
+
+mkdir -p "$OUT"
+echo "=== w0 build variants: $SRC, median of $RUNS runs ==="
+echo
+printf "%-18s %10s %9s %11s %9s\n" "variant" "time ms" "slowdown" "maxrss MiB" "memory"
+
+base_ms="" base_kb=""
+for v in "${VARIANTS[@]}"; do
+    IFS='|' read -r name cc flags <<<"$v"
+    if ! command -v "$cc" >/dev/null 2>&1; then
+        printf "%-18s   skipped: %s not found\n" "$name" "$cc"
+        continue
+    fi
+    bin="$OUT/scramble_$name"
+    # shellcheck disable=SC2086  # flags are intentionally word-split
+    if ! "$cc" $flags "$SRC" -o "$bin" 2>"$bin.log"; then
+        printf "%-18s   skipped: build failed (see %s.log)\n" "$name" "$bin"
+        continue
+    fi
+    times=() rss=() sum=""
+    for ((i = 0; i < RUNS; i++)); do
+        line=$("./$bin") || { echo "$name: run failed" >&2; exit 1; }
+        t=${line#time_ms=}; t=${t%% *}
+        k=${line#*maxrss_kb=}; k=${k%% *}
+        s=${line#*sum=}
+        [ -n "$sum" ] && [ "$s" != "$sum" ] && { echo "$name: checksum changed between runs" >&2; exit 1; }
+        sum=$s
+        times+=("$t") rss+=("$k")
+    done
+    ms=$(printf "%s\n" "${times[@]}" | median)
+    kb=$(printf "%s\n" "${rss[@]}" | median)
+    if [ -z "$base_ms" ]; then base_ms=$ms base_kb=$kb base_sum=$sum; fi
+    [ "$sum" != "$base_sum" ] && echo "$name: result differs from release!" >&2
+    awk -v n="$name" -v ms="$ms" -v kb="$kb" -v bms="$base_ms" -v bkb="$base_kb" \
+        'BEGIN { printf "%-18s %10.1f %8.2fx %11.1f %8.2fx\n", n, ms, ms / bms, kb / 1024, kb / bkb }'
+done
+
+echo
+echo "Rule of thumb: a variant is staging-worthy if its slowdown and memory"
+echo "overhead both fit the headroom of the box it will run on."
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../common/strslice.h"   // slice_t: (ptr, len) view, no rescans
+
 /*
 TODO - C-Strings
 ? A C-string is an array of chars terminated by a null byte '\0'.
@@ -106,20 +108,18 @@ int main(void) {
     printf("[demo_info] sizeof(s)=%zu, strlen(s)=%zu\n", sizeof(s), strlen(s));
 
     printf("[demo_scramble] Original: %s\n", s);
-    // Scramble the string (increment each char, stop at '\0')
-    for (char *p = s; *p; ++p) {
-        *p += 1;
-    }
+    // Measure once (strlen, not sizeof: with `char *s` sizeof is the pointer's
+    // size) and let the length travel with the view, so neither pass needs to
+    // hunt for the terminator.
+    slice_t sv = slice_from_cstr(s);
+
+    // Scramble the string (increment each char)
+    slice_add(sv, +1);
     printf("[demo_scramble] Scrambled: %s\n", s);
 
-    // Unscramble the string safely (guard empty string; avoid pointer underflow)
-    size_t n = strlen(s);
-    if (n > 0) {
-        for (char *p = s + n - 1; ; --p) {
-            *p -= 1;
-            if (p == s) break;
-        }
-    }
+    // Unscramble: the length travels with the view, so an empty string is
+    // just len == 0 — no pointer underflow to guard against
+    slice_add(sv, -1);
     printf("[demo_scramble] Unscrambled: %s\n", s);
 
     demo_decay(); // shows sizeof array vs pointer and indexing equivalence
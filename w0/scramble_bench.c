@@ -0,0 +1,73 @@
+// scramble_bench.c — demo.c's scramble/unscramble as a timed workload
+//
+// Built once per w0 Makefile variant (debug, asan/ubsan, release, clang-*)
+// by `make bench`; see bench_variants.sh. Can also run alone:
+//   gcc -std=c17 -O2 -DNDEBUG scramble_bench.c -o scramble_bench && ./scramble_bench
+//
+// Two phases, both the same string work demo.c does:
+//   big    scramble (+1) / unscramble (-1) a large heap buffer, then strlen it
+//   lines  many short heap strings: malloc, copy, scramble, unscramble, free
+//          (this is where ASan's allocator and redzones show up)
+//
+// Prints one machine-readable line:  time_ms=<wall> maxrss_kb=<peak RSS> sum=<checksum>
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "../common/strslice.h"
+#include "../common/timing.h"
+
+#define BIG_BYTES   (32u << 20)
+#define BIG_ROUNDS  8
+#define LINE_BYTES  80
+#define LINES       400000
+
+int main(void) {
+    unsigned long sum = 0;
+    uint64_t t0 = timing_now_ns();
+
+    // ---- big: one large buffer, like demo.c's s[] but 32 MiB ----
+    char *big = malloc(BIG_BYTES + 1);
+    if (!big) { perror("malloc"); return 1; }
+    for (size_t i = 0; i < BIG_BYTES; i++) big[i] = (char)('a' + i % 26);
+    big[BIG_BYTES] = '\0';
+    slice_t sv = slice_from(big, BIG_BYTES);
+    for (int r = 0; r < BIG_ROUNDS; r++) {
+        slice_add(sv, +1);
+        sum += (unsigned char)big[r];
+        slice_add(sv, -1);
+        sum += strlen(big);
+    }
+    free(big);
+
+    // ---- lines: short-lived heap strings ----
+    char tmpl[LINE_BYTES + 1];
+    memset(tmpl, 'x', LINE_BYTES);
+    tmpl[LINE_BYTES] = '\0';
+    for (int i = 0; i < LINES; i++) {
+        size_t n = 16 + (size_t)i % (LINE_BYTES - 16);
+        char *s = malloc(n + 1);
+        if (!s) { perror("malloc"); return 1; }
+        memcpy(s, tmpl, n);
+        s[n] = '\0';
+        slice_t l = slice_from(s, n);
+        slice_add(l, +1);
+        sum += (unsigned char)s[n / 2];
+        slice_add(l, -1);
+        free(s);
+    }
+
+    double ms = (double)(timing_now_ns() - t0) / 1e6;
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    long rss_kb = (long)(ru.ru_maxrss / 1024);  // bytes on macOS
+#else
+    long rss_kb = ru.ru_maxrss;                 // KiB on Linux
+#endif
+    printf("time_ms=%.1f maxrss_kb=%ld sum=%lu\n", ms, rss_kb, sum);
+    return 0;
+}
@@ -0,0 +1,235 @@
+// fault_bench.c
+// Week 1 extension: "pure user space" work still traps into the kernel the
+// first time it touches a page. How much, and what can we do about it?
+//
+// Build: make fault_bench        (or: make)
+// Run:   ./fault_bench                 (1 GiB array, 5 steady-state passes)
+//        ./fault_bench -s 256M -p 20
+//
+// Variants (same sum_array loop from syscall_demo.c Part B on each):
+//   malloc          plain malloc: every 4 KiB page faults on first write
+//   MAP_POPULATE    mmap pre-faults everything inside the mmap() call
+//   MADV_HUGEPAGE   ask for transparent huge pages: one fault per 2 MiB
+//   MAP_HUGETLB     explicit hugetlbfs pages (needs vm.nr_hugepages > 0)
+//
+// Per variant we report:
+//   setup    time spent in malloc/mmap/madvise (MAP_POPULATE faults land here)
+//   minflt   minor faults taken during setup + first fill (getrusage)
+//   fault    first fill minus a second fill of the same memory = fault cost
+//   THP      AnonHugePages backing the process after the fill (smaps_rollup)
+//   sum GB/s steady-state sum_array throughput, best of -p passes
+// and finish with a recommendation table for one-shot vs long-lived arrays.
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+
+#define HUGE_2M (2u << 20)
+
+static long minflt(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt;
+}
+
+// Same loop as syscall_demo.c, with a 64-bit accumulator so a 1 GiB array
+// cannot overflow the sum.
+__attribute__((noinline))
+static long long sum_array(const int *a, size_t n) {
+    long long sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i];  // pure computation on our own memory
+    }
+    return sum;
+}
+
+__attribute__((noinline))
+static void fill(int *a, size_t n) {
+    for (size_t i = 0; i < n; i++) a[i] = (int)(i & 7);
+}
+
+static long anon_huge_kb(void) {
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    char line[128];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    fclose(f);
+    return kb;
+}
+
+/* ------------------------------ Allocators ------------------------------ */
+typedef enum { V_MALLOC, V_POPULATE, V_THP, V_HUGETLB, V_COUNT } variant_t;
+static const char *variant_name[V_COUNT] = { "malloc", "MAP_POPULATE", "MADV_HUGEPAGE", "MAP_HUGETLB" };
+
+static void *alloc_variant(variant_t v, size_t bytes, const char **why) {
+    void *p = NULL;
+    switch (v) {
+    case V_MALLOC:
+        p = malloc(bytes);
+        if (!p) *why = "malloc failed";
+        return p;
+    case V_POPULATE:
+#ifdef MAP_POPULATE
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (p == MAP_FAILED) { *why = "mmap failed"; return NULL; }
+        return p;
+#else
+        *why = "no MAP_POPULATE on this OS";
+        return NULL;
+#endif
+    case V_THP:
+#ifdef MADV_HUGEPAGE
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) { *why = "mmap failed"; return NULL; }
+        if (madvise(p, bytes, MADV_HUGEPAGE) != 0) {
+            munmap(p, bytes);
+            *why = "madvise refused (THP disabled?)";
+            return NULL;
+        }
+        return p;
+#else
+        *why = "no transparent huge pages on this OS";
+        return NULL;
+#endif
+    case V_HUGETLB:
+#ifdef MAP_HUGETLB
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) { *why = "no hugetlb pages (set vm.nr_hugepages)"; return NULL; }
+        return p;
+#else
+        *why = "no MAP_HUGETLB on this OS";
+        return NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static void free_variant(variant_t v, void *p, size_t bytes) {
+    if (v == V_MALLOC) free(p);
+    else munmap(p, bytes);
+}
+
+/* ------------------------------- Driver --------------------------------- */
+typedef struct {
+    int ok;
+    const char *why;
+    double setup_ms, first_ms, refill_ms, sum_ms;
+    long faults, huge_kb;
+} result_t;
+
+static result_t run_variant(variant_t v, size_t bytes, int passes) {
+    result_t r = { 0 };
+    size_t n = bytes / sizeof(int);
+    long f0 = minflt();
+    uint64_t t0 = timing_now_ns();
+    int *a = alloc_variant(v, bytes, &r.why);
+    uint64_t t1 = timing_now_ns();
+    if (!a) return r;
+    fill(a, n);                 // first touch: page faults happen here
+    uint64_t t2 = timing_now_ns();
+    r.faults = minflt() - f0;
+    fill(a, n);                 // same work, pages already present
+    uint64_t t3 = timing_now_ns();
+    r.huge_kb = anon_huge_kb();
+
+    r.sum_ms = 1e30;
+    volatile long long sink = 0;
+    for (int p = 0; p < passes; p++) {
+        uint64_t s = timing_now_ns();
+        sink += sum_array(a, n);
+        double ms = (double)(timing_now_ns() - s) / 1e6;
+        if (ms < r.sum_ms) r.sum_ms = ms;
+    }
+    (void)sink;
+    free_variant(v, a, bytes);
+
+    r.ok = 1;
+    r.setup_ms = (double)(t1 - t0) / 1e6;
+    r.first_ms = (double)(t2 - t1) / 1e6;
+    r.refill_ms = (double)(t3 - t2) / 1e6;
+    return r;
+}
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+int main(int argc, char **argv) {
+    size_t bytes = 1u << 30;
+    int passes = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:")) != -1) {
+        switch (opt) {
+            case 's': bytes = parse_size(optarg); break;
+            case 'p': passes = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s bytes (e.g. 1G)] [-p passes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (passes < 1) passes = 1;
+    bytes = (bytes + HUGE_2M - 1) / HUGE_2M * HUGE_2M;   // hugetlb needs whole pages
+    if (bytes == 0) bytes = HUGE_2M;
+    double gb = (double)bytes / 1e9;
+
+    printf("=== Page faults vs huge pages: %zu MiB array, %d sum passes ===\n\n", bytes >> 20, passes);
+    printf("%-14s %9s %9s %11s %9s %9s %9s\n",
+           "variant", "setup ms", "minflt", "fault ms", "ns/fault", "THP MiB", "sum GB/s");
+
+    result_t r[V_COUNT];
+    for (int v = 0; v < V_COUNT; v++) {
+        r[v] = run_variant((variant_t)v, bytes, passes);
+        if (!r[v].ok) { printf("%-14s   unavailable: %s\n", variant_name[v], r[v].why); continue; }
+        // Fault cost = first fill - refill, plus setup when the kernel pre-faulted inside mmap.
+        double fault_ms = r[v].first_ms - r[v].refill_ms + (v == V_POPULATE ? r[v].setup_ms : 0.0);
+        if (fault_ms < 0) fault_ms = 0;
+        printf("%-14s %9.1f %9ld %11.1f %9.0f %9ld %9.2f\n", variant_name[v], r[v].setup_ms, r[v].faults,
+               fault_ms, r[v].faults ? fault_ms * 1e6 / (double)r[v].faults : 0.0,
+               r[v].huge_kb >= 0 ? r[v].huge_kb / 1024 : -1L, gb / (r[v].sum_ms / 1e3));
+    }
+
+    // Recommendation: total = setup + first fill + k passes of sum_array.
+    static const int job_passes[] = { 1, 10, 100 };
+    printf("\nRecommendation (projected ms for alloc + fill + N sums; * = best):\n");
+    printf("%-14s", "variant");
+    for (size_t j = 0; j < sizeof(job_passes) / sizeof(job_passes[0]); j++) printf("   N=%-7d", job_passes[j]);
+    printf("\n");
+    int best[3] = { -1, -1, -1 };
+    double cost[V_COUNT][3];
+    for (int v = 0; v < V_COUNT; v++)
+        for (int j = 0; j < 3; j++) {
+            cost[v][j] = r[v].ok ? r[v].setup_ms + r[v].first_ms + job_passes[j] * r[v].sum_ms : 0;
+            if (r[v].ok && (best[j] < 0 || cost[v][j] < cost[best[j]][j])) best[j] = v;
+        }
+    for (int v = 0; v < V_COUNT; v++) {
+        if (!r[v].ok) continue;
+        printf("%-14s", variant_name[v]);
+        for (int j = 0; j < 3; j++) printf(" %10.1f%c", cost[v][j], best[j] == v ? '*' : ' ');
+        printf("\n");
+    }
+    if (best[0] >= 0)
+        printf("\n-> one-shot scans: %s;  long-lived arrays: %s\n",
+               variant_name[best[0]], variant_name[best[2]]);
+    printf("   (MAP_POPULATE moves faults out of the hot loop; huge pages cut their number by 512x\n"
+           "    and shrink TLB pressure — the sum loop itself is pure user space either way.)\n");
+    return 0;
+}
@@ -0,0 +1,339 @@
+// proc_sampler.c
+// Week 1 extension: Part C of syscall_demo does open/read/close for every
+// read. Fine once — wasteful when an agent polls /proc thousands of times.
+//
+// Build: make proc_sampler       (or: make)
+// Run:   ./proc_sampler                 (samples /proc/stat, /proc/meminfo, ourselves)
+//        ./proc_sampler -a -n 2000      (every PID in /proc, 2000 rounds)
+//        ./proc_sampler 1 $$            (explicit PIDs)
+//
+// The fast path:
+//   • open every file ONCE, keep the fd
+//   • re-read with pread(fd, buf, cap, 0): /proc regenerates the text on each
+//     read at offset 0, so no lseek and no re-open (path lookup, fd alloc)
+//   • buffers are allocated up front; parsers walk the text in place with no
+//     malloc, no sscanf and no copies, filling a plain struct
+//
+// The benchmark runs the same parsers behind open/read/close and reports
+// rounds/sec plus user+sys CPU per round for both patterns.
+//
+// Linux only (/proc).
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+
+#define STAT_BUF    (32 * 1024)   // /proc/stat: "intr" line grows with IRQ count (start size)
+#define MEMINFO_BUF (8 * 1024)    // start size
+#define STATUS_BUF  (4 * 1024)
+#define MAX_PIDS    4096
+
+/* ------------------------------ Samples --------------------------------- */
+typedef struct {
+    uint64_t user, nice, system, idle, iowait, irq, softirq, steal;  // jiffies, all CPUs
+    uint64_t ctxt, procs_running, procs_blocked;
+    uint64_t mem_total_kb, mem_free_kb, mem_avail_kb, cached_kb;
+} sys_sample_t;
+
+typedef struct {
+    int pid;
+    int alive;
+    char state;
+    uint64_t threads, vm_rss_kb, vm_hwm_kb, vol_ctxt, nonvol_ctxt;
+} pid_sample_t;
+
+/* ------------------------- Allocation-free parsing ---------------------- */
+// All parsers take [p, end) and never read past end.
+static const char *skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+static const char *parse_u64(const char *p, const char *end, uint64_t *out) {
+    uint64_t v = 0;
+    p = skip_ws(p, end);
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (uint64_t)(*p++ - '0');
+    *out = v;
+    return p;
+}
+
+static const char *next_line(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
+}
+
+// Does the line at p start with key (key includes its ':' or trailing space)?
+static int starts(const char *p, const char *end, const char *key, size_t klen) {
+    return (size_t)(end - p) >= klen && memcmp(p, key, klen) == 0;
+}
+#define STARTS(p, end, lit) starts((p), (end), lit, sizeof(lit) - 1)
+
+static void parse_stat(const char *p, const char *end, sys_sample_t *s) {
+    for (; p < end; p = next_line(p, end)) {
+        if (STARTS(p, end, "cpu ")) {
+            uint64_t *f[] = { &s->user, &s->nice, &s->system, &s->idle,
+                              &s->iowait, &s->irq, &s->softirq, &s->steal };
+            const char *q = p + 4;
+            for (size_t i = 0; i < sizeof(f) / sizeof(f[0]); i++) q = parse_u64(q, end, f[i]);
+        } else if (STARTS(p, end, "ctxt ")) {
+            parse_u64(p + 5, end, &s->ctxt);
+        } else if (STARTS(p, end, "procs_running ")) {
+            parse_u64(p + 14, end, &s->procs_running);
+        } else if (STARTS(p, end, "procs_blocked ")) {
+            parse_u64(p + 14, end, &s->procs_blocked);
+        }
+    }
+}
+
+static void parse_meminfo(const char *p, const char *end, sys_sample_t *s) {
+    int found = 0;
+    for (; p < end && found < 4; p = next_line(p, end)) {
+        if (STARTS(p, end, "MemTotal:"))          { parse_u64(p + 9, end, &s->mem_total_kb); found++; }
+        else if (STARTS(p, end, "MemFree:"))      { parse_u64(p + 8, end, &s->mem_free_kb); found++; }
+        else if (STARTS(p, end, "MemAvailable:")) { parse_u64(p + 13, end, &s->mem_avail_kb); found++; }
+        else if (STARTS(p, end, "Cached:"))       { parse_u64(p + 7, end, &s->cached_kb); found++; }
+    }
+}
+
+static void parse_status(const char *p, const char *end, pid_sample_t *s) {
+    for (; p < end; p = next_line(p, end)) {
+        if (STARTS(p, end, "State:")) {
+            const char *q = skip_ws(p + 6, end);
+            s->state = q < end ? *q : '?';
+        }
+        else if (STARTS(p, end, "Threads:"))    parse_u64(p + 8, end, &s->threads);
+        else if (STARTS(p, end, "VmRSS:"))      parse_u64(p + 6, end, &s->vm_rss_kb);
+        else if (STARTS(p, end, "VmHWM:"))      parse_u64(p + 6, end, &s->vm_hwm_kb);
+        else if (STARTS(p, end, "voluntary_ctxt_switches:"))
+            parse_u64(p + 24, end, &s->vol_ctxt);
+        else if (STARTS(p, end, "nonvoluntary_ctxt_switches:"))
+            parse_u64(p + 27, end, &s->nonvol_ctxt);
+    }
+}
+
+/* --------------------------- Kept-open sampler --------------------------- */
+typedef struct {
+    int stat_fd, meminfo_fd;
+    char *stat_buf, *meminfo_buf;
+    size_t stat_cap, meminfo_cap;
+    int npids;
+    int pid[MAX_PIDS];
+    int status_fd[MAX_PIDS];
+    char *status_buf;           // npids × STATUS_BUF, one slab
+    int exited;                 // PIDs gone before we opened them (ENOENT)
+    int open_failed, open_errno;    // PIDs we could not open for another reason (first errno)
+    uint64_t truncated;         // reads that filled the whole buffer
+} sampler_t;
+
+// A read that fills the buffer may have cut the file short, and /proc/stat
+// keeps ctxt and procs_* after the long "intr" line. Double the buffer until
+// one pread comes back short: once, here, not in the sampling loop.
+static int fit_buffer(int fd, char **buf, size_t *cap) {
+    for (;;) {
+        ssize_t n = pread(fd, *buf, *cap, 0);
+        if (n < 0) return -1;
+        if ((size_t)n < *cap) return 0;
+        char *nb = realloc(*buf, 2 * *cap);
+        if (!nb) return -1;
+        *buf = nb;
+        *cap *= 2;
+    }
+}
+
+static int sampler_open(sampler_t *s, const int *pids, int npids) {
+    memset(s, 0, sizeof(*s));
+    s->stat_cap = STAT_BUF;
+    s->meminfo_cap = MEMINFO_BUF;
+    // Stop at the first failure so errno still describes it for the caller.
+    if ((s->stat_fd = open("/proc/stat", O_RDONLY | O_CLOEXEC)) < 0 ||
+        (s->meminfo_fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC)) < 0 ||
+        !(s->stat_buf = malloc(s->stat_cap)) ||
+        !(s->meminfo_buf = malloc(s->meminfo_cap)) ||
+        !(s->status_buf = malloc((size_t)(npids ? npids : 1) * STATUS_BUF))) return -1;
+    if (fit_buffer(s->stat_fd, &s->stat_buf, &s->stat_cap) != 0 ||
+        fit_buffer(s->meminfo_fd, &s->meminfo_buf, &s->meminfo_cap) != 0) return -1;
+    char path[64];
+    for (int i = 0; i < npids; i++) {
+        snprintf(path, sizeof(path), "/proc/%d/status", pids[i]);
+        s->pid[s->npids] = pids[i];
+        s->status_fd[s->npids] = open(path, O_RDONLY | O_CLOEXEC);
+        if (s->status_fd[s->npids] >= 0) {
+            s->npids++;
+        } else if (errno == ENOENT) {
+            s->exited++;                        // raced with exit: just skip it
+        } else if (s->open_failed++ == 0) {
+            s->open_errno = errno;              // e.g. EMFILE with -a: not an exit
+        }
+    }
+    return 0;
+}
+
+static void sampler_close(sampler_t *s) {
+    close(s->stat_fd);
+    close(s->meminfo_fd);
+    for (int i = 0; i < s->npids; i++) close(s->status_fd[i]);
+    free(s->stat_buf);
+    free(s->meminfo_buf);
+    free(s->status_buf);
+}
+
+// pread at offset 0; returns bytes read (0 on error).
+static size_t reread(int fd, char *buf, size_t cap) {
+    ssize_t n = pread(fd, buf, cap, 0);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static void sampler_read(sampler_t *s, sys_sample_t *sys, pid_sample_t *out) {
+    memset(sys, 0, sizeof(*sys));
+    size_t n = reread(s->stat_fd, s->stat_buf, s->stat_cap);
+    s->truncated += n == s->stat_cap;           // grew since sampler_open (CPU hotplug)
+    parse_stat(s->stat_buf, s->stat_buf + n, sys);
+    n = reread(s->meminfo_fd, s->meminfo_buf, s->meminfo_cap);
+    s->truncated += n == s->meminfo_cap;
+    parse_meminfo(s->meminfo_buf, s->meminfo_buf + n, sys);
+    for (int i = 0; i < s->npids; i++) {
+        char *b = s->status_buf + (size_t)i * STATUS_BUF;
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].pid = s->pid[i];
+        n = reread(s->status_fd[i], b, STATUS_BUF);   // ESRCH once the process is gone
+        s->truncated += n == STATUS_BUF;              // fixed size: not fitted at open
+        out[i].alive = n > 0;
+        parse_status(b, b + n, &out[i]);
+    }
+}
+
+/* ----------------------- Baseline: open/read/close ----------------------- */
+static size_t read_once(const char *path, char *buf, size_t cap) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, cap);
+    close(fd);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// scratch holds at least max(stat_cap, meminfo_cap, STATUS_BUF) bytes.
+static void naive_read(const sampler_t *s, char *scratch, sys_sample_t *sys, pid_sample_t *out) {
+    memset(sys, 0, sizeof(*sys));
+    size_t n = read_once("/proc/stat", scratch, s->stat_cap);
+    parse_stat(scratch, scratch + n, sys);
+    n = read_once("/proc/meminfo", scratch, s->meminfo_cap);
+    parse_meminfo(scratch, scratch + n, sys);
+    char path[64];
+    for (int i = 0; i < s->npids; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].pid = s->pid[i];
+        snprintf(path, sizeof(path), "/proc/%d/status", s->pid[i]);
+        n = read_once(path, scratch, STATUS_BUF);
+        out[i].alive = n > 0;
+        parse_status(scratch, scratch + n, &out[i]);
+    }
+}
+
+/* ------------------------------- Driver --------------------------------- */
+static double cpu_s(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static int all_pids(int *pids, int cap) {
+    DIR *d = opendir("/proc");
+    if (!d) return 0;
+    int n = 0;
+    struct dirent *e;
+    while (n < cap && (e = readdir(d)))
+        if (isdigit((unsigned char)e->d_name[0])) pids[n++] = atoi(e->d_name);
+    closedir(d);
+    return n;
+}
+
+int main(int argc, char **argv) {
+    int rounds = 1000, all = 0, opt;
+    while ((opt = getopt(argc, argv, "an:")) != -1) {
+        switch (opt) {
+            case 'a': all = 1; break;
+            case 'n': rounds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-a] [-n rounds] [pid ...]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (rounds < 1) rounds = 1;
+
+    static int pids[MAX_PIDS];
+    int npids = 0;
+    if (all) npids = all_pids(pids, MAX_PIDS);
+    for (int i = optind; i < argc && npids < MAX_PIDS; i++) pids[npids++] = atoi(argv[i]);
+    if (npids == 0) pids[npids++] = (int)getpid();
+
+    sampler_t s;
+    if (sampler_open(&s, pids, npids) != 0) { perror("sampler_open"); return 1; }
+    static pid_sample_t out[MAX_PIDS];
+    sys_sample_t sys;
+    size_t scratch_cap = s.stat_cap > s.meminfo_cap ? s.stat_cap : s.meminfo_cap;
+    char *scratch = malloc(scratch_cap > STATUS_BUF ? scratch_cap : STATUS_BUF);
+    if (!scratch) { perror("malloc"); return 1; }
+
+    sampler_read(&s, &sys, out);
+    printf("=== /proc sampler: %d PID(s), %d rounds per pattern ===\n", s.npids, rounds);
+    if (s.exited) printf("(%d PID(s) exited before they could be opened)\n", s.exited);
+    if (s.open_failed) {
+        fprintf(stderr, "warning: could not open /proc/<pid>/status for %d PID(s): %s%s\n", s.open_failed,
+                strerror(s.open_errno), s.open_errno == EMFILE ? " (raise ulimit -n)" : "");
+    }
+    printf("\n");
+    printf("cpu jiffies  user %llu  system %llu  idle %llu  iowait %llu\n",
+           (unsigned long long)sys.user, (unsigned long long)sys.system,
+           (unsigned long long)sys.idle, (unsigned long long)sys.iowait);
+    printf("ctxt %llu  running %llu  blocked %llu\n", (unsigned long long)sys.ctxt,
+           (unsigned long long)sys.procs_running, (unsigned long long)sys.procs_blocked);
+    printf("mem  total %llu kB  free %llu kB  available %llu kB  cached %llu kB\n\n",
+           (unsigned long long)sys.mem_total_kb, (unsigned long long)sys.mem_free_kb,
+           (unsigned long long)sys.mem_avail_kb, (unsigned long long)sys.cached_kb);
+    printf("%8s %5s %7s %10s %10s %10s %10s\n", "pid", "state", "threads", "rss kB", "hwm kB", "vcsw", "ivcsw");
+    for (int i = 0; i < s.npids && i < 8; i++)
+        printf("%8d %5c %7llu %10llu %10llu %10llu %10llu\n", out[i].pid, out[i].state,
+               (unsigned long long)out[i].threads, (unsigned long long)out[i].vm_rss_kb,
+               (unsigned long long)out[i].vm_hwm_kb, (unsigned long long)out[i].vol_ctxt,
+               (unsigned long long)out[i].nonvol_ctxt);
+    if (s.npids > 8) printf("%8s (%d more)\n", "...", s.npids - 8);
+
+    // ---- Benchmark: same parsers, two I/O patterns ----
+    uint64_t w0 = timing_now_ns();
+    double c0 = cpu_s();
+    for (int r = 0; r < rounds; r++) naive_read(&s, scratch, &sys, out);
+    double naive_wall = (double)(timing_now_ns() - w0) / 1e9, naive_cpu = cpu_s() - c0;
+
+    w0 = timing_now_ns(); c0 = cpu_s();
+    for (int r = 0; r < rounds; r++) sampler_read(&s, &sys, out);
+    double kept_wall = (double)(timing_now_ns() - w0) / 1e9, kept_cpu = cpu_s() - c0;
+
+    int files = 2 + s.npids;
+    printf("\n%-22s %12s %12s %14s\n", "pattern", "rounds/s", "files/s", "CPU us/round");
+    printf("%-22s %12.0f %12.0f %14.1f\n", "open/read/close", rounds / naive_wall,
+           rounds * files / naive_wall, naive_cpu * 1e6 / rounds);
+    printf("%-22s %12.0f %12.0f %14.1f\n", "kept fd + pread(0)", rounds / kept_wall,
+           rounds * files / kept_wall, kept_cpu * 1e6 / rounds);
+    printf("\n-> kept fds are %.2fx faster: no path walk, no fd allocation, no close per sample.\n",
+           naive_wall / kept_wall);
+    if (s.truncated) {
+        fprintf(stderr, "warning: %llu read(s) filled the whole buffer (the file outgrew it); "
+                "their last lines were lost\n", (unsigned long long)s.truncated);
+    }
+
+    free(scratch);
+    sampler_close(&s);
+    return 0;
+}
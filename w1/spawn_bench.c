@@ -0,0 +1,187 @@
+// spawn_bench.c
+// Week 1 extension: what does it cost to ask the kernel for a new process?
+//
+// Build: make spawn_bench spawn_stub     (or: make; `make bench` runs it)
+// Run:   ./spawn_bench                          (default: 10M, 1G, 10G parent RSS)
+//        ./spawn_bench -n 2000 -s 10M,512M -t ./spawn_stub
+//
+// Methods (each launches the target, which exits immediately, then waitpid):
+//   fork+exec    copy the parent's page tables (COW), then exec
+//   vfork+exec   child borrows the parent's address space until exec
+//   posix_spawn  libc picks the cheapest path (clone(CLONE_VM|CLONE_VFORK) on glibc)
+//   clone        raw clone(CLONE_VM|CLONE_VFORK) with our own child stack
+//
+// The parent first maps and touches -s bytes so fork has real page tables
+// to copy: fork cost grows with parent RSS, the CLONE_VM variants do not.
+// Sizes that do not fit in MemAvailable are skipped instead of OOM-ing.
+//
+// Linux only (clone, /proc/meminfo).
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+
+extern char **environ;
+
+static const char *target = "/bin/true";
+static char *target_argv[] = { NULL, NULL };
+
+/* ------------------------------ Spawners ------------------------------- */
+static pid_t spawn_fork(void) {
+    pid_t pid = fork();
+    if (pid == 0) { execve(target, target_argv, environ); _exit(127); }
+    return pid;
+}
+
+static pid_t spawn_vfork(void) {
+    pid_t pid = vfork();
+    if (pid == 0) { execve(target, target_argv, environ); _exit(127); }
+    return pid;
+}
+
+static pid_t spawn_posix(void) {
+    pid_t pid;
+    int rc = posix_spawn(&pid, target, NULL, NULL, target_argv, environ);
+    if (rc != 0) { errno = rc; return -1; }
+    return pid;
+}
+
+static int clone_child(void *arg) {
+    (void)arg;
+    execve(target, target_argv, environ);
+    _exit(127);
+}
+
+static char *clone_stack;
+#define CLONE_STACK_SIZE (64 * 1024)
+
+static pid_t spawn_clone(void) {
+    // CLONE_VFORK: we are suspended until the child execs, so one stack is enough.
+    return clone(clone_child, clone_stack + CLONE_STACK_SIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, NULL);
+}
+
+typedef struct { const char *name; pid_t (*spawn)(void); } method_t;
+static const method_t methods[] = {
+    { "fork+exec",   spawn_fork  },
+    { "vfork+exec",  spawn_vfork },
+    { "posix_spawn", spawn_posix },
+    { "clone(VM|VFORK)", spawn_clone },
+};
+
+/* ------------------------------ Helpers -------------------------------- */
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+static size_t mem_available(void) {
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (!f) return SIZE_MAX;
+    char line[128];
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "MemAvailable: %zu kB", &kb) == 1) break;
+    fclose(f);
+    return kb ? kb * 1024 : SIZE_MAX;
+}
+
+static void run_method(const method_t *m, int iters, uint64_t *lat) {
+    int failed = 0;
+    uint64_t t0 = timing_now_ns();
+    for (int i = 0; i < iters; i++) {
+        uint64_t s = timing_now_ns();
+        pid_t pid = m->spawn();
+        int st = 0;
+        if (pid < 0 || waitpid(pid, &st, 0) < 0 || !WIFEXITED(st) || WEXITSTATUS(st) != 0) failed++;
+        lat[i] = timing_now_ns() - s;
+    }
+    double secs = (double)(timing_now_ns() - t0) / 1e9;
+    qsort(lat, (size_t)iters, sizeof(*lat), cmp_u64);
+#define PCT(p) ((double)lat[(size_t)((iters - 1) * (p))] / 1e3)
+    printf("  %-16s %10.0f %10.1f %10.1f %10.1f %10.1f%s\n", m->name, iters / secs,
+           PCT(0.50), PCT(0.90), PCT(0.99), (double)lat[iters - 1] / 1e3,
+           failed ? "  (some spawns failed)" : "");
+#undef PCT
+}
+
+int main(int argc, char **argv) {
+    int iters = 1000;
+    const char *sizes = "10M,1G,10G";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:t:")) != -1) {
+        switch (opt) {
+            case 'n': iters = atoi(optarg); break;
+            case 's': sizes = optarg; break;
+            case 't': target = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-s 10M,1G,...] [-t target]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (iters < 1) iters = 1;
+    target_argv[0] = (char *)target;
+    if (access(target, X_OK) != 0) {
+        fprintf(stderr, "error: target '%s' is not executable (%s)\n", target, strerror(errno));
+        return 2;
+    }
+    clone_stack = malloc(CLONE_STACK_SIZE);
+    uint64_t *lat = malloc((size_t)iters * sizeof(*lat));
+    if (!clone_stack || !lat) { perror("malloc"); return 1; }
+
+    printf("=== Spawn cost: %s, %d spawns per method ===\n", target, iters);
+    char *list = strdup(sizes);
+    for (char *save = NULL, *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        size_t rss = parse_size(tok);
+        if (rss > mem_available() / 10 * 8) {
+            printf("\n[parent RSS %s] skipped: exceeds 80%% of MemAvailable (%zu MiB)\n",
+                   tok, mem_available() >> 20);
+            continue;
+        }
+        // mmap + touch every page so the RSS (and page tables) really exist.
+        char *ballast = NULL;
+        if (rss) {
+            ballast = mmap(NULL, rss, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ballast == MAP_FAILED) { printf("\n[parent RSS %s] skipped: mmap failed\n", tok); continue; }
+            long page = sysconf(_SC_PAGESIZE);
+            for (size_t off = 0; off < rss; off += (size_t)page) ballast[off] = 1;
+        }
+        printf("\n[parent RSS %s]\n", tok);
+        printf("  %-16s %10s %10s %10s %10s %10s\n", "method", "spawns/s", "p50 us", "p90 us", "p99 us", "max us");
+        for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+            run_method(&methods[i], iters, lat);
+        if (ballast) munmap(ballast, rss);
+    }
+    free(list);
+    free(lat);
+    free(clone_stack);
+
+    printf("\nTakeaway:\n"
+           "  • fork copies page tables, so its cost scales with parent RSS.\n"
+           "  • vfork / posix_spawn / clone(CLONE_VM|CLONE_VFORK) share the address space\n"
+           "    until exec and stay flat — prefer posix_spawn for helpers.\n");
+    return 0;
+}
@@ -0,0 +1,9 @@
+// spawn_stub.c
+// Smallest useful exec target for spawn_bench: no libc start-up work to speak
+// of, so the numbers measure process creation rather than the child's main().
+//
+// Build: make spawn_stub      (linked -static: no dynamic loader at exec)
+
+int main(void) {
+    return 0;
+}
@@ -15,19 +15,14 @@
 #include <unistd.h>   // read, close
 #include <string.h>   // memcpy, strlen
 
+#include "../common/strslice.h"   // slice_t: (ptr, len) view, no rescans
+
 // ------------------ Part B Helpers: Pure user-space work (no syscalls inside) ------------------
 // NOTE: These functions only touches CPU registers and the program's own RAM.
 // It does not do I/O, allocate memory, or call the kernel.
-static void reverse_in_place(char *s) {
-    size_t i = 0, j = strlen(s);
-    if (j == 0) return;
-    j--; // point to last valid char
-    while (i < j) {
-        char tmp = s[i];
-        s[i] = s[j];
-        s[j] = tmp;
-        i++; j--;
-    }
+// Takes a slice: the caller already knows the length, so no strlen() here.
+static void reverse_in_place(slice_t s) {
+    slice_reverse(s);   // swap s.ptr[i] and s.ptr[len-1-i] until they meet
 }
 
 static int sum_array(const int *a, size_t n) {
@@ -66,7 +61,7 @@ int main(void) {
     int nums[] = {1, 2, 3, 4, 5};
 
     // These functions only read/write our process's own memory and use the CPU.
-    reverse_in_place(msg);
+    reverse_in_place(slice_from(msg, sizeof(msg) - 1));   // length known at compile time
     int s = sum_array(nums, sizeof(nums)/sizeof(nums[0]));
 
     // NOTE: The printf below is a syscall for output, but the *work above* did not cross into the kernel.
@@ -0,0 +1,113 @@
+// copy_bench.c
+// Week 2 extension: how fast can copy_from_user_sim move a BIG buffer, and
+// when does adding threads stop helping?
+//
+// Build:  make copy_bench         (links copy_user.c)
+// Run:    ./copy_bench                        (256 MiB, 1..nproc threads)
+//         ./copy_bench -s 1G -t 16 -r 3
+//
+// Big picture:
+//   - One core cannot saturate DRAM: a single memcpy is limited by how many
+//     cache misses that core can keep in flight.
+//   - copy_user_set_threads(n) splits copies >= 8 MiB into n slices; the
+//     caller and n-1 pinned pool workers copy in parallel, then meet at a
+//     spin barrier.
+//   - Streaming (non-temporal) stores skip the read-for-ownership of the
+//     destination, so each byte crosses the memory bus twice instead of three
+//     times.
+//   - Once the memory controllers are busy, more threads add nothing: that
+//     is the "saturated" row below.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "copy_user.h"
+#include "../common/timing.h"
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+// Best-of-reps GB/s for one copy_from_user_sim of len bytes.
+static double measure(const char *src, char *dst, size_t len, int reps) {
+    double best = 0;
+    for (int r = 0; r < reps; r++) {
+        uint64_t t0 = timing_now_ns();
+        if (copy_from_user_sim(src, len, dst, len) != len) return 0;
+        double gbps = (double)len / (double)(timing_now_ns() - t0);   // bytes/ns == GB/s
+        if (gbps > best) best = gbps;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    size_t len = 256u << 20;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int reps = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:t:r:")) != -1) {
+        switch (opt) {
+            case 's': len = parse_size(optarg); break;
+            case 't': max_threads = atoi(optarg); break;
+            case 'r': reps = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s bytes (e.g. 512M)] [-t max_threads] [-r reps]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (max_threads < 1) max_threads = 1;
+    if (reps < 1) reps = 1;
+    if (len < COPY_PARALLEL_MIN) len = COPY_PARALLEL_MIN;
+
+    char *src = malloc(len), *dst = malloc(len);
+    if (!src || !dst) { perror("malloc"); return 1; }
+    for (size_t i = 0; i < len; i++) src[i] = (char)(i * 131);
+    memset(dst, 0, len);        // fault both buffers in before timing
+
+    printf("=== Large copy_from_user_sim: %zu MiB, best of %d ===\n\n", len >> 20, reps);
+    copy_user_set_threads(1);
+    copy_user_set_streaming(0);
+    double base = measure(src, dst, len, reps);
+    printf("%-8s %12s %12s %10s\n", "threads", "memcpy GB/s", "stream GB/s", "speedup");
+    printf("%-8s %12.2f %12s %10s\n", "baseline", base, "-", "1.00x");
+
+    double prev = 0;
+    int saturated_at = 0;
+    for (int t = 1; t <= max_threads; t = (t < 4 || t * 2 > max_threads) ? t + 1 : t * 2) {
+        int got = copy_user_set_threads(t);
+        copy_user_set_streaming(0);
+        double plain = measure(src, dst, len, reps);
+        copy_user_set_streaming(1);
+        double nt = measure(src, dst, len, reps);
+        double best = plain > nt ? plain : nt;
+        printf("%-8d %12.2f %12.2f %9.2fx", got, plain, nt, best / base);
+        if (!saturated_at && prev > 0 && best < prev * 1.10) {
+            saturated_at = got;
+            printf("   <- saturated (<10%% gain)");
+        }
+        printf("\n");
+        if (best > prev) prev = best;
+    }
+    copy_user_set_threads(1);
+
+    if (memcmp(src, dst, len) != 0) { printf("\n❌ copy mismatch!\n"); return 1; }
+    printf("\n✅ destination verified\n");
+    printf("Takeaway:\n");
+    printf("  • Bandwidth grows with threads until the memory bus is full%s.\n",
+           saturated_at ? "" : " (not reached here: try -t with more threads)");
+    printf("  • Streaming stores help most when the copy is far larger than the LLC.\n\n");
+
+    free(src);
+    free(dst);
+    return 0;
+}
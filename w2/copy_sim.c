@@ -1,6 +1,6 @@
 // Simulating copy_from_user / copy_to_user (no kernel needed)
 //
-// Build:  gcc -O2 -Wall -Wextra -o copy_sim copy_sim.c
+// Build:  gcc -O2 -Wall -Wextra -o copy_sim copy_sim.c copy_user.c
 // Run:    ./copy_sim
 //
 // Big picture:
@@ -13,36 +13,11 @@
 #include <string.h>
 #include <ctype.h>
 
-#define KBUF_SIZE 32
+#include "copy_user.h"
 
-// Return number of bytes copied; 0 means "rejected" (like an EFAULT-style failure).
-size_t copy_from_user_sim(const char *user_src, size_t user_len,
-                          char *kernel_dst, size_t kernel_cap) {
-    if (user_src == NULL) {
-        printf("[KERNEL] Reject: user pointer is NULL.\n");
-        return 0;
-    }
-    if (user_len > kernel_cap) {
-        printf("[KERNEL] Reject: user_len (%zu) > kernel capacity (%zu).\n", user_len, kernel_cap);
-        return 0;
-    }
-    memcpy(kernel_dst, user_src, user_len);
-    return user_len;
-}
+#define KBUF_SIZE 32
 
-size_t copy_to_user_sim(const char *kernel_src, size_t kernel_len,
-                        char *user_dst, size_t user_cap) {
-    if (user_dst == NULL) {
-        printf("[KERNEL] Reject: user destination pointer is NULL.\n");
-        return 0;
-    }
-    if (kernel_len > user_cap) {
-        printf("[KERNEL] Reject: kernel_len (%zu) > user capacity (%zu).\n", kernel_len, user_cap);
-        return 0;
-    }
-    memcpy(user_dst, kernel_src, kernel_len);
-    return kernel_len;
-}
+// copy_from_user_sim / copy_to_user_sim live in copy_user.c
 
 // Three cases:
 // 1. Valid user -> kernel -> user round trip
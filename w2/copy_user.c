@@ -0,0 +1,202 @@
+// copy_user.c
+// Simulating copy_from_user / copy_to_user (no kernel needed).
+// See copy_user.h; used by copy_sim.c, page_cache_sim.c and copy_bench.c.
+
+#ifdef __linux__
+#define _GNU_SOURCE             // sched_setaffinity
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "copy_user.h"
+
+/* ======================= Parallel large-copy pool ======================= */
+#define COPY_MAX_THREADS 256
+#define COPY_SPINS       2000   // pause-spins before yielding in the barrier
+
+static struct {
+    pthread_mutex_t call_mu;    // one large copy at a time
+    pthread_mutex_t mu;         // guards gen/stop for sleeping workers
+    pthread_cond_t cv;
+    unsigned gen;               // bumped once per job
+    int stop;
+    int nthreads;               // including the caller
+    _Atomic int remaining;      // join barrier: workers still copying
+    char *dst;
+    const char *src;
+    size_t len;
+} pool = {
+    .call_mu = PTHREAD_MUTEX_INITIALIZER,
+    .mu = PTHREAD_MUTEX_INITIALIZER,
+    .cv = PTHREAD_COND_INITIALIZER,
+    .nthreads = 1,
+};
+static pthread_t pool_tids[COPY_MAX_THREADS];
+static int streaming = 1;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+// Copy one slice. Streaming stores bypass the cache for the destination:
+// a 100 MiB copy would otherwise evict everything else we had cached.
+static void copy_range(char *dst, const char *src, size_t len) {
+#if defined(__SSE2__)
+    if (streaming && len >= 256) {
+        size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+        memcpy(dst, src, head);
+        dst += head; src += head; len -= head;
+        for (size_t n = len / 64; n; n--, dst += 64, src += 64) {
+            __m128i a = _mm_loadu_si128((const __m128i *)src);
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+            _mm_stream_si128((__m128i *)dst, a);
+            _mm_stream_si128((__m128i *)(dst + 16), b);
+            _mm_stream_si128((__m128i *)(dst + 32), c);
+            _mm_stream_si128((__m128i *)(dst + 48), d);
+        }
+        memcpy(dst, src, len % 64);
+        _mm_sfence();           // make NT stores visible before the barrier
+        return;
+    }
+#endif
+    memcpy(dst, src, len);
+}
+
+// Slice idx of the current job: contiguous and 64-byte aligned, so a worker
+// always gets the same part of a reused buffer (first-touch keeps it local
+// to that worker's NUMA node) and no two threads share a cache line.
+static void copy_slice(int idx) {
+    size_t per = (pool.len / (size_t)pool.nthreads + 63) & ~(size_t)63;
+    size_t off = per * (size_t)idx;
+    if (off >= pool.len) return;
+    size_t n = pool.len - off < per ? pool.len - off : per;
+    copy_range(pool.dst + off, pool.src + off, n);
+}
+
+static void *pool_worker(void *arg) {
+    int idx = (int)(intptr_t)arg;
+#ifdef __linux__
+    // Pin worker i to CPU i: its slice's pages stay on its node and its
+    // caches stay warm between jobs.
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu > 1) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((int)(idx % ncpu), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    unsigned seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool.mu);
+        while (pool.gen == seen && !pool.stop) pthread_cond_wait(&pool.cv, &pool.mu);
+        if (pool.stop) { pthread_mutex_unlock(&pool.mu); return NULL; }
+        seen = pool.gen;
+        pthread_mutex_unlock(&pool.mu);
+
+        copy_slice(idx);
+        atomic_fetch_sub_explicit(&pool.remaining, 1, memory_order_release);
+    }
+}
+
+static void copy_parallel(char *dst, const char *src, size_t len) {
+    pthread_mutex_lock(&pool.call_mu);
+    pool.dst = dst;
+    pool.src = src;
+    pool.len = len;
+    atomic_store_explicit(&pool.remaining, pool.nthreads - 1, memory_order_relaxed);
+    pthread_mutex_lock(&pool.mu);
+    pool.gen++;
+    pthread_cond_broadcast(&pool.cv);
+    pthread_mutex_unlock(&pool.mu);
+
+    copy_slice(0);              // the caller works too
+
+    // Barrier: spin briefly (slices finish close together), then yield.
+    for (int spins = 0; atomic_load_explicit(&pool.remaining, memory_order_acquire) > 0; spins++) {
+        if (spins < COPY_SPINS) cpu_relax();
+        else sched_yield();
+    }
+    pthread_mutex_unlock(&pool.call_mu);
+}
+
+static void copy_bytes(char *dst, const char *src, size_t len) {
+    if (len < COPY_PARALLEL_MIN) memcpy(dst, src, len);
+    else if (pool.nthreads > 1) copy_parallel(dst, src, len);
+    else copy_range(dst, src, len);
+}
+
+int copy_user_set_threads(int n) {
+    if (n < 1) n = 1;
+    if (n > COPY_MAX_THREADS) n = COPY_MAX_THREADS;
+    pthread_mutex_lock(&pool.call_mu);
+    if (pool.nthreads > 1) {    // tear down the old pool
+        pthread_mutex_lock(&pool.mu);
+        pool.stop = 1;
+        pthread_cond_broadcast(&pool.cv);
+        pthread_mutex_unlock(&pool.mu);
+        for (int i = 1; i < pool.nthreads; i++) pthread_join(pool_tids[i], NULL);
+        pool.stop = 0;
+        pool.gen = 0;
+        pool.nthreads = 1;
+    }
+    for (int i = 1; i < n; i++) {
+        if (pthread_create(&pool_tids[i], NULL, pool_worker, (void *)(intptr_t)i) != 0) {
+            perror("copy_user_set_threads: pthread_create");
+            break;
+        }
+        pool.nthreads = i + 1;
+    }
+    int got = pool.nthreads;
+    pthread_mutex_unlock(&pool.call_mu);
+    return got;
+}
+
+void copy_user_set_streaming(int on) {
+    streaming = on;
+}
+
+/* ============================ Checked copies ============================ */
+// Return number of bytes copied; 0 means "rejected" (like an EFAULT-style failure).
+size_t copy_from_user_sim(const char *user_src, size_t user_len,
+                          char *kernel_dst, size_t kernel_cap) {
+    if (user_src == NULL) {
+        printf("[KERNEL] Reject: user pointer is NULL.\n");
+        return 0;
+    }
+    if (user_len > kernel_cap) {
+        printf("[KERNEL] Reject: user_len (%zu) > kernel capacity (%zu).\n", user_len, kernel_cap);
+        return 0;
+    }
+    copy_bytes(kernel_dst, user_src, user_len);
+    return user_len;
+}
+
+size_t copy_to_user_sim(const char *kernel_src, size_t kernel_len,
+                        char *user_dst, size_t user_cap) {
+    if (user_dst == NULL) {
+        printf("[KERNEL] Reject: user destination pointer is NULL.\n");
+        return 0;
+    }
+    if (kernel_len > user_cap) {
+        printf("[KERNEL] Reject: kernel_len (%zu) > user capacity (%zu).\n", kernel_len, user_cap);
+        return 0;
+    }
+    copy_bytes(user_dst, kernel_src, kernel_len);
+    return kernel_len;
+}
@@ -0,0 +1,34 @@
+// copy_user.h
+// Simulated copy_from_user / copy_to_user shared by the w2 demos.
+//
+// Both return the number of bytes copied; 0 means "rejected" (like an
+// EFAULT-style failure) and a [KERNEL] line explains why.
+//
+// Parallel mode: with copy_user_set_threads(n > 1), copies of at least
+// COPY_PARALLEL_MIN bytes are cut into one contiguous, cache-line aligned
+// slice per thread (the caller copies slice 0, pool workers the rest) and
+// joined with a spin barrier. Large copies use streaming (non-temporal)
+// stores when the CPU has them, so the destination does not evict the
+// cache. Only one large copy runs at a time; smaller ones are plain memcpy.
+
+#ifndef W2_COPY_USER_H
+#define W2_COPY_USER_H
+
+#include <stddef.h>
+
+#define COPY_PARALLEL_MIN (8u << 20)    // 8 MiB
+
+size_t copy_from_user_sim(const char *user_src, size_t user_len,
+                          char *kernel_dst, size_t kernel_cap);
+
+size_t copy_to_user_sim(const char *kernel_src, size_t kernel_len,
+                        char *user_dst, size_t user_cap);
+
+// Start/stop the pool: n threads in total including the caller (1 = off).
+// Returns the thread count now in use.
+int copy_user_set_threads(int n);
+
+// Non-temporal stores for large copies (default on).
+void copy_user_set_streaming(int on);
+
+#endif /* W2_COPY_USER_H */
@@ -0,0 +1,352 @@
+// page_cache_sim.c
+// Week 2 extension: copy_sim moves ONE buffer. Real read() latency is decided
+// one layer down, by whether the page is already in the page cache.
+//
+// Build:  make page_cache_sim     (links copy_user.c)
+// Run:    ./page_cache_sim                    (64 MiB file, 8 MiB cache)
+//         ./page_cache_sim -f 32768 -c 4096 -n 200000 -z 1.1
+//
+// Big picture:
+//   - A backing file on disk plays the role of the block device.
+//   - The "kernel" keeps a fixed set of 4 KiB frames (the page cache) plus a
+//     hash index (file, page) -> frame.
+//   - cache_read() serves a read() request: find or fill each page, then hand
+//     bytes out with copy_to_user_sim(), exactly like filemap_read() does.
+//   - Eviction is CLOCK (second chance): one reference bit per frame, a hand
+//     that sweeps and clears bits until it finds a frame nobody touched.
+//   - Readahead is adaptive, modelled on Linux ondemand readahead:
+//       • a miss right after the previous page starts a window (4 pages) and
+//         each further sequential miss doubles it, up to 32 pages (128 KiB)
+//       • every window carries a "readahead mark" (mid-window for the first,
+//         first page for the rest); hitting it starts the NEXT window early,
+//         so a streaming reader never stalls
+//       • a miss anywhere else is treated as random: read one page, reset
+//
+// Reported per trace (sequential, uniform random, Zipf), with readahead on/off:
+//   hit ratio, backing-file I/Os and pages read, readahead efficiency
+//   (prefetched pages later used / prefetched), readahead waste (prefetched
+//   pages evicted before anyone read them), and simulated throughput.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "copy_user.h"
+#include "../common/timing.h"
+
+#define PAGE_SIZE   4096
+#define RA_MIN      4       // pages in the first sequential window
+#define RA_MAX      32      // pages: 128 KiB, Linux's default read_ahead_kb
+#define NO_FRAME    (-1)
+
+/* ============================== Page cache ============================== */
+typedef struct {
+    int file;
+    uint32_t page;
+    int next;               // hash chain
+    unsigned valid : 1, ref : 1, ra_unused : 1, ra_mark : 1;
+} frame_t;
+
+typedef struct {
+    uint32_t prev_page;     // last page this reader touched
+    uint32_t window;        // current readahead window (0 = random mode)
+    uint32_t ra_end;        // first page after the last window issued
+} ra_state_t;
+
+typedef struct {
+    int nframes, hand;
+    frame_t *frames;
+    char *data;             // nframes * PAGE_SIZE
+    int *buckets;
+    uint32_t nbuckets;      // power of two
+    int readahead;          // 0 = off (every miss reads one page)
+    // stats
+    uint64_t hits, misses, ios, pages_read, ra_pages, ra_used, ra_wasted, evictions;
+} cache_t;
+
+typedef struct {
+    int fd;                 // backing file
+    int id;
+    uint32_t npages;
+    ra_state_t ra;
+} file_t;
+
+static uint32_t bucket_of(const cache_t *c, int file, uint32_t page) {
+    uint64_t k = ((uint64_t)(uint32_t)file << 32) | page;
+    k *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(k >> 32) & (c->nbuckets - 1);
+}
+
+static int cache_init(cache_t *c, int nframes, int readahead) {
+    memset(c, 0, sizeof(*c));
+    c->nframes = nframes;
+    c->readahead = readahead;
+    c->nbuckets = 1;
+    while (c->nbuckets < (uint32_t)nframes * 2) c->nbuckets <<= 1;
+    c->frames = calloc((size_t)nframes, sizeof(frame_t));
+    c->data = malloc((size_t)nframes * PAGE_SIZE);
+    c->buckets = malloc(c->nbuckets * sizeof(int));
+    if (!c->frames || !c->data || !c->buckets) return -1;
+    for (uint32_t i = 0; i < c->nbuckets; i++) c->buckets[i] = NO_FRAME;
+    return 0;
+}
+
+static void cache_free(cache_t *c) {
+    free(c->frames);
+    free(c->data);
+    free(c->buckets);
+}
+
+static int cache_lookup(const cache_t *c, int file, uint32_t page) {
+    for (int f = c->buckets[bucket_of(c, file, page)]; f != NO_FRAME; f = c->frames[f].next)
+        if (c->frames[f].file == file && c->frames[f].page == page) return f;
+    return NO_FRAME;
+}
+
+static void hash_remove(cache_t *c, int idx) {
+    frame_t *fr = &c->frames[idx];
+    int *link = &c->buckets[bucket_of(c, fr->file, fr->page)];
+    while (*link != idx) link = &c->frames[*link].next;
+    *link = fr->next;
+}
+
+// CLOCK: sweep the hand, giving referenced frames a second chance.
+static int cache_victim(cache_t *c) {
+    for (;;) {
+        int idx = c->hand;
+        frame_t *fr = &c->frames[idx];
+        c->hand = (c->hand + 1) % c->nframes;
+        if (!fr->valid) return idx;
+        if (fr->ref) { fr->ref = 0; continue; }
+        hash_remove(c, idx);
+        if (fr->ra_unused) c->ra_wasted++;  // prefetched, never read
+        fr->valid = 0;
+        c->evictions++;
+        return idx;
+    }
+}
+
+// Bring pages [first, first+count) of f into the cache with ONE backing read.
+// Pages already cached are skipped (their buffers are left alone).
+static void cache_fill(cache_t *c, file_t *f, uint32_t first, uint32_t count, uint32_t demand) {
+    if (first >= f->npages) return;
+    if (first + count > f->npages) count = f->npages - first;
+    static char io_buf[RA_MAX * PAGE_SIZE];
+    ssize_t got = pread(f->fd, io_buf, (size_t)count * PAGE_SIZE, (off_t)first * PAGE_SIZE);
+    if (got < 0) { fprintf(stderr, "pread: %s\n", strerror(errno)); exit(1); }
+    c->ios++;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t page = first + i;
+        if (cache_lookup(c, f->id, page) != NO_FRAME) continue;
+        int idx = cache_victim(c);
+        frame_t *fr = &c->frames[idx];
+        *fr = (frame_t){ .file = f->id, .page = page, .valid = 1, .ref = 0 };
+        fr->ra_unused = (page != demand);
+        fr->next = c->buckets[bucket_of(c, f->id, page)];
+        c->buckets[bucket_of(c, f->id, page)] = idx;
+        size_t have = (size_t)got > (size_t)i * PAGE_SIZE ? (size_t)got - (size_t)i * PAGE_SIZE : 0;
+        if (have > PAGE_SIZE) have = PAGE_SIZE;
+        memcpy(c->data + (size_t)idx * PAGE_SIZE, io_buf + (size_t)i * PAGE_SIZE, have);
+        c->pages_read++;
+        if (fr->ra_unused) c->ra_pages++;
+    }
+}
+
+// Issue a readahead window and place its mark (see header).
+static void readahead_window(cache_t *c, file_t *f, uint32_t start, uint32_t demand) {
+    ra_state_t *ra = &f->ra;
+    cache_fill(c, f, start, ra->window, demand);
+    ra->ra_end = start + ra->window;
+    int m = cache_lookup(c, f->id, start == demand ? start + ra->window / 2 : start);
+    if (m != NO_FRAME) c->frames[m].ra_mark = 1;
+}
+
+// Return the frame holding (f, page), filling it (and maybe more) on a miss.
+static int cache_get(cache_t *c, file_t *f, uint32_t page) {
+    ra_state_t *ra = &f->ra;
+    int sequential = (page == ra->prev_page + 1);   // prev_page starts at UINT32_MAX
+    ra->prev_page = page;
+    int idx = cache_lookup(c, f->id, page);
+
+    if (idx != NO_FRAME) {
+        c->hits++;
+        frame_t *fr = &c->frames[idx];
+        if (fr->ra_unused) { fr->ra_unused = 0; c->ra_used++; }
+        fr->ref = 1;            // before readahead, so the sweep cannot pick us
+        if (c->readahead && fr->ra_mark) {
+            // Async readahead: the reader reached the marked page, so fetch
+            // the next (bigger) window before it is needed.
+            fr->ra_mark = 0;
+            if (ra->window) {
+                ra->window = ra->window * 2 > RA_MAX ? RA_MAX : ra->window * 2;
+                readahead_window(c, f, ra->ra_end, UINT32_MAX);
+            }
+        }
+        return idx;
+    }
+
+    c->misses++;
+    if (!c->readahead) {
+        cache_fill(c, f, page, 1, page);
+    } else if (sequential) {
+        // Sync readahead: start (or grow) a window at the faulting page.
+        ra->window = ra->window ? (ra->window * 2 > RA_MAX ? RA_MAX : ra->window * 2) : RA_MIN;
+        readahead_window(c, f, page, page);
+    } else {
+        ra->window = 0;         // looks random: no speculation
+        cache_fill(c, f, page, 1, page);
+    }
+    idx = cache_lookup(c, f->id, page);
+    c->frames[idx].ref = 1;
+    return idx;
+}
+
+// read(): serve [off, off+len) of f into user_buf through copy_to_user_sim.
+static size_t cache_read(cache_t *c, file_t *f, uint64_t off, size_t len, char *user_buf, size_t user_cap) {
+    size_t done = 0;
+    uint64_t end = (uint64_t)f->npages * PAGE_SIZE;
+    if (off >= end) return 0;
+    if (off + len > end) len = (size_t)(end - off);
+    while (done < len) {
+        uint32_t page = (uint32_t)((off + done) / PAGE_SIZE);
+        size_t in_page = (size_t)((off + done) % PAGE_SIZE);
+        size_t chunk = PAGE_SIZE - in_page;
+        if (chunk > len - done) chunk = len - done;
+        int idx = cache_get(c, f, page);
+        size_t n = copy_to_user_sim(c->data + (size_t)idx * PAGE_SIZE + in_page, chunk,
+                                    user_buf + done, user_cap - done);
+        if (n == 0) break;      // rejected: stop like a short read
+        done += n;
+    }
+    return done;
+}
+
+/* ================================ Traces ================================ */
+static uint64_t rng_state = 0x2545F4914F6CDD1Dull;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+typedef enum { T_SEQ, T_RANDOM, T_ZIPF } trace_t;
+static const char *trace_name[] = { "sequential", "random", "zipf" };
+
+// Zipf(s) over npages via an inverted CDF; ranks are scattered over the file
+// with a multiplier coprime to npages so hot pages are not contiguous.
+typedef struct { double *cdf; uint32_t n, mult; } zipf_t;
+
+static uint32_t gcd32(uint32_t a, uint32_t b) { while (b) { uint32_t t = a % b; a = b; b = t; } return a; }
+
+static int zipf_init(zipf_t *z, uint32_t n, double s) {
+    z->n = n;
+    z->cdf = malloc(n * sizeof(double));
+    if (!z->cdf) return -1;
+    double sum = 0;
+    for (uint32_t i = 0; i < n; i++) { sum += 1.0 / pow((double)(i + 1), s); z->cdf[i] = sum; }
+    for (uint32_t i = 0; i < n; i++) z->cdf[i] /= sum;
+    z->mult = 2654435761u % n;
+    while (z->mult < 2 || gcd32(z->mult, n) != 1) z->mult++;
+    return 0;
+}
+
+static uint32_t zipf_next(const zipf_t *z) {
+    double u = (double)(rng_next() >> 11) / 9007199254740992.0;
+    uint32_t lo = 0, hi = z->n - 1;
+    while (lo < hi) { uint32_t mid = (lo + hi) / 2; if (z->cdf[mid] < u) lo = mid + 1; else hi = mid; }
+    return (uint32_t)(((uint64_t)lo * z->mult) % z->n);
+}
+
+static void run_trace(trace_t t, int readahead, file_t *f, int nframes, int nreq, const zipf_t *z) {
+    cache_t c;
+    if (cache_init(&c, nframes, readahead) != 0) { perror("cache_init"); exit(1); }
+    f->ra = (ra_state_t){ .prev_page = UINT32_MAX };
+    rng_state = 0x2545F4914F6CDD1Dull;
+    char user_buf[PAGE_SIZE];
+    uint64_t bytes = 0;
+
+    uint64_t t0 = timing_now_ns();
+    for (int i = 0; i < nreq; i++) {
+        uint32_t page;
+        switch (t) {
+            case T_SEQ:    page = (uint32_t)i % f->npages; break;
+            case T_RANDOM: page = (uint32_t)(rng_next() % f->npages); break;
+            default:       page = zipf_next(z); break;
+        }
+        size_t n = cache_read(&c, f, (uint64_t)page * PAGE_SIZE, PAGE_SIZE, user_buf, sizeof(user_buf));
+        bytes += n;
+    }
+    double secs = (double)(timing_now_ns() - t0) / 1e9;
+
+    uint64_t lookups = c.hits + c.misses;
+    printf("%-11s %-4s %7.2f%% %9llu %10llu %9llu %8.1f%% %9llu %9.0f\n", trace_name[t],
+           readahead ? "on" : "off", 100.0 * (double)c.hits / (double)(lookups ? lookups : 1),
+           (unsigned long long)c.ios, (unsigned long long)c.pages_read, (unsigned long long)c.ra_pages,
+           c.ra_pages ? 100.0 * (double)c.ra_used / (double)c.ra_pages : 0.0,
+           (unsigned long long)c.ra_wasted, (double)bytes / 1e6 / secs);
+    cache_free(&c);
+}
+
+/* ================================ Driver ================================ */
+int main(int argc, char **argv) {
+    uint32_t file_pages = 16384;    // 64 MiB
+    int nframes = 2048;             // 8 MiB cache
+    int nreq = 100000;
+    double zipf_s = 0.99;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:c:n:z:")) != -1) {
+        switch (opt) {
+            case 'f': file_pages = (uint32_t)atol(optarg); break;
+            case 'c': nframes = atoi(optarg); break;
+            case 'n': nreq = atoi(optarg); break;
+            case 'z': zipf_s = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f file_pages] [-c cache_frames] [-n requests] [-z zipf_s]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (file_pages < 1 || nframes < RA_MAX * 2 || nreq < 1) {
+        fprintf(stderr, "need file_pages >= 1, cache_frames >= %d, requests >= 1\n", RA_MAX * 2);
+        return 2;
+    }
+
+    // Backing "disk": a temp file where every page starts with its page number.
+    char path[] = "/tmp/page_cache_sim.XXXXXX";
+    file_t f = { .fd = mkstemp(path), .id = 1, .npages = file_pages };
+    if (f.fd < 0) { perror("mkstemp"); return 1; }
+    unlink(path);
+    char page[PAGE_SIZE];
+    for (uint32_t p = 0; p < file_pages; p++) {
+        memset(page, 'a' + (int)(p % 26), sizeof(page));
+        memcpy(page, &p, sizeof(p));
+        if (write(f.fd, page, sizeof(page)) != (ssize_t)sizeof(page)) { perror("write"); return 1; }
+    }
+
+    zipf_t z;
+    if (zipf_init(&z, file_pages, zipf_s) != 0) { perror("zipf_init"); return 1; }
+
+    printf("=== Page cache: %u-page file (%u MiB), %d frames (%d MiB), %d x 4 KiB reads, zipf s=%.2f ===\n\n",
+           file_pages, file_pages / 256, nframes, nframes / 256, nreq, zipf_s);
+    printf("%-11s %-4s %8s %9s %10s %9s %9s %9s %9s\n",
+           "trace", "RA", "hit", "I/Os", "pages in", "RA pages", "RA used", "RA wasted", "MB/s");
+    for (int t = T_SEQ; t <= T_ZIPF; t++) {
+        run_trace((trace_t)t, 0, &f, nframes, nreq, &z);
+        run_trace((trace_t)t, 1, &f, nframes, nreq, &z);
+    }
+
+    printf("\nTakeaway:\n");
+    printf("  • Sequential: readahead turns one I/O per page into one per window (up to %d pages).\n", RA_MAX);
+    printf("  • Random: the detector stays out of the way — a handful of speculative pages, not a window per miss.\n");
+    printf("  • Zipf: hit ratio comes from CLOCK keeping the hot set, not from readahead.\n\n");
+
+    free(z.cdf);
+    close(f.fd);
+    return 0;
+}
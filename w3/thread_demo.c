@@ -7,6 +7,11 @@
 // Run:
 //   ./thread_demo
 //
+// Timeline (Chrome trace JSON for ui.perfetto.dev; see ../common/trace.h):
+//   make trace && TRACE_OUT=trace.json ./thread_demo
+// Per-Part CPU / context-switch / run-queue report on stderr (../common/part_stats.h):
+//   make stats && ./thread_demo
+//
 // -------------------------------------------------------------------
 // Learning goals:
 //   1) See a race condition when many threads update a shared global.
@@ -25,9 +30,16 @@
 #include <ctype.h>
 #include <sched.h>   // sched_yield
 
-// Increase these to make races even more obvious
+#include "../common/trace.h"        // TRACE_* timeline events (no-ops unless -DTRACE)
+#include "../common/part_stats.h"   // PART_STATS_* CPU/ctx-switch accounting (-DPART_STATS)
+
+// Increase these to make races even more obvious (or override with -D at build time)
+#ifndef THREADS
 #define THREADS     15
+#endif
+#ifndef ITERATIONS
 #define ITERATIONS  10000000
+#endif
 
 /* ========================= Shared state for A/A2/B ========================= */
 long counter = 0;
@@ -36,34 +48,45 @@ pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 /* ---------------- Part A: naive increment (may look “fine” sometimes) ----- */
 // ❓ Why might this *sometimes* look correct? What hidden steps are in counter++?
 static void *increment_without_lock(void *arg) {
+    TRACE_BEGIN("increment_without_lock");
     for (int i = 0; i < ITERATIONS; i++) {
         counter++;  // data race: load, add, store (not atomic)
     }
+    TRACE_END("increment_without_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
 /* -------- Part A2: STRESSED race (widens window; almost always wrong) ------ */
 // ❓ How do yields/spin widen the race window to increase overlap?
 static void *increment_without_lock_stressed(void *arg) {
+    TRACE_BEGIN("increment_without_lock_stressed");
     for (int i = 0; i < ITERATIONS; i++) {
         long tmp = counter;          // read
-        if ((i & 0x3FF) == 0) sched_yield();       // invite interleaving
+        if ((i & 0x3FF) == 0) { TRACE_BEGIN("sched_yield"); sched_yield(); TRACE_END("sched_yield"); } // invite interleaving
         for (volatile int spin = 0; spin < 50; ++spin) { /* widen */ }
         tmp = tmp + 1;               // modify
-        if ((i & 0x7FF) == 0) sched_yield();       // invite collision
+        if ((i & 0x7FF) == 0) { TRACE_BEGIN("sched_yield"); sched_yield(); TRACE_END("sched_yield"); } // invite collision
         counter = tmp;               // write (may clobber another thread)
     }
+    TRACE_END("increment_without_lock_stressed");
+    PART_STATS_THREAD();
     return NULL;
 }
 
 /* ---------------- Part B: with lock (correct) ------------------------------ */
 // ❓ What property does the lock enforce around counter++?
 static void *increment_with_lock(void *arg) {
+    TRACE_BEGIN("increment_with_lock");
     for (int i = 0; i < ITERATIONS; i++) {
+        TRACE_BEGIN("lock_wait");
         pthread_mutex_lock(&lock);
+        TRACE_END("lock_wait");
         counter++;
         pthread_mutex_unlock(&lock);
     }
+    TRACE_END("increment_with_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -73,6 +96,7 @@ pair_t pair_vals = {0, 0};
 
 // ❓ Why can (a == b) break without a lock, even if each thread tries to keep them in sync?
 static void *touch_pair_without_lock(void *arg) {
+    TRACE_BEGIN("touch_pair_without_lock");
     for (int i = 0; i < ITERATIONS; i++) {
         long ta = pair_vals.a;
         long tb = pair_vals.b;
@@ -82,20 +106,30 @@ static void *touch_pair_without_lock(void *arg) {
         pair_vals.a = ta;
         pair_vals.b = tb;
         if (pair_vals.a != pair_vals.b) {
+            TRACE_INSTANT("invariant_broken");
+            TRACE_END("touch_pair_without_lock");
+            PART_STATS_THREAD();
             return (void*)1; // signal invariant broken
         }
     }
+    TRACE_END("touch_pair_without_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
 static void *touch_pair_with_lock(void *arg) {
+    TRACE_BEGIN("touch_pair_with_lock");
     for (int i = 0; i < ITERATIONS; i++) {
+        TRACE_BEGIN("lock_wait");
         pthread_mutex_lock(&lock);
+        TRACE_END("lock_wait");
         pair_vals.a++;
         if ((i & 0x3FF) == 0) { for (volatile int s = 0; s < 50; ++s) {} }
         pair_vals.b++;
         pthread_mutex_unlock(&lock);
     }
+    TRACE_END("touch_pair_with_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -127,22 +161,31 @@ static void reentrant_upper(const char *s, char *out, size_t outcap) {
 typedef struct { const char *in; const char **outptr; } nr_args_t;
 static void *call_not_reentrant(void *arg) {
     nr_args_t *a = (nr_args_t*)arg;
+    TRACE_BEGIN("call_not_reentrant");
     sched_yield();
     const char *p = not_reentrant_upper(a->in);
     sched_yield();
     *(a->outptr) = p;  // every thread “returns” the same static pointer
+    TRACE_END("call_not_reentrant");
+    PART_STATS_THREAD();
     return NULL;
 }
 
 /* ================================ Driver =================================== */
 int main(void) {
+    TRACE_THREAD_NAME("main");
+
     // ---- Part A: naive (may or may not show wrong) ----
     {
         pthread_t ts[THREADS];
         counter = 0;
         printf("=== Part A: Counter without lock (may look okay) ===\n");
+        TRACE_BEGIN("Part A");
+        PART_STATS_BEGIN("Part A");
         for (int i = 0; i < THREADS; i++) pthread_create(&ts[i], NULL, increment_without_lock, NULL);
         for (int i = 0; i < THREADS; i++) pthread_join(ts[i], NULL);
+        PART_STATS_END();
+        TRACE_END("Part A");
         printf("Expected %d, got %ld\n\n", THREADS * ITERATIONS, counter);
     }
 
@@ -151,8 +194,12 @@ int main(void) {
         pthread_t ts[THREADS];
         counter = 0;
         printf("=== Part A2: STRESSED counter without lock (should be wrong) ===\n");
+        TRACE_BEGIN("Part A2");
+        PART_STATS_BEGIN("Part A2");
         for (int i = 0; i < THREADS; i++) pthread_create(&ts[i], NULL, increment_without_lock_stressed, NULL);
         for (int i = 0; i < THREADS; i++) pthread_join(ts[i], NULL);
+        PART_STATS_END();
+        TRACE_END("Part A2");
         printf("Expected %d, got %ld  <-- race likely caused lost updates\n\n",
                THREADS * ITERATIONS, counter);
     }
@@ -162,8 +209,12 @@ int main(void) {
         pthread_t ts[THREADS];
         counter = 0;
         printf("=== Part B: Counter WITH lock (should be exact) ===\n");
+        TRACE_BEGIN("Part B");
+        PART_STATS_BEGIN("Part B");
         for (int i = 0; i < THREADS; i++) pthread_create(&ts[i], NULL, increment_with_lock, NULL);
         for (int i = 0; i < THREADS; i++) pthread_join(ts[i], NULL);
+        PART_STATS_END();
+        TRACE_END("Part B");
         printf("Expected %d, got %ld ✅\n\n", THREADS * ITERATIONS, counter);
     }
 
@@ -172,6 +223,8 @@ int main(void) {
         pthread_t ts[THREADS];
         pair_vals.a = pair_vals.b = 0;
         printf("=== Bonus A: Invariant (a==b) WITHOUT lock (should break) ===\n");
+        TRACE_BEGIN("Bonus A");
+        PART_STATS_BEGIN("Bonus A");
         int broke = 0;
         for (int i = 0; i < THREADS; i++) pthread_create(&ts[i], NULL, touch_pair_without_lock, NULL);
         for (int i = 0; i < THREADS; i++) {
@@ -179,13 +232,19 @@ int main(void) {
             pthread_join(ts[i], &ret);
             if ((long)ret == 1) broke = 1;
         }
+        PART_STATS_END();
+        TRACE_END("Bonus A");
         printf("Invariant a==b broken? %s (a=%ld, b=%ld)\n\n", broke ? "YES" : "NO",
                pair_vals.a, pair_vals.b);
 
         printf("=== Bonus B: Invariant WITH lock (should hold) ===\n");
         pair_vals.a = pair_vals.b = 0;
+        TRACE_BEGIN("Bonus B");
+        PART_STATS_BEGIN("Bonus B");
         for (int i = 0; i < THREADS; i++) pthread_create(&ts[i], NULL, touch_pair_with_lock, NULL);
         for (int i = 0; i < THREADS; i++) pthread_join(ts[i], NULL);
+        PART_STATS_END();
+        TRACE_END("Bonus B");
         printf("Invariant a==b holds?  %s (a=%ld, b=%ld) ✅\n\n",
                (pair_vals.a == pair_vals.b) ? "YES" : "NO",
                pair_vals.a, pair_vals.b);
@@ -203,6 +262,8 @@ int main(void) {
     printf("Reentrant calls preserved: \"%s\" and \"%s\"\n\n", r1, r2);
 
     printf("=== Part C2: THREADS race on non-reentrant function (garbled likely) ===\n");
+    TRACE_BEGIN("Part C2");
+    PART_STATS_BEGIN("Part C2");
     pthread_t tA, tB;
     const char *outA = NULL, *outB = NULL;
     nr_args_t a = {.in = "abcdef", .outptr = &outA};
@@ -211,6 +272,8 @@ int main(void) {
     pthread_create(&tB, NULL, call_not_reentrant, &b);
     pthread_join(tA, NULL);
     pthread_join(tB, NULL);
+    PART_STATS_END();
+    TRACE_END("Part C2");
     printf("Thread A saw: %s\n", outA);
     printf("Thread B saw: %s\n", outB);
     printf("(Both point to the same static buffer; last finisher “wins.”)\n\n");
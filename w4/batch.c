@@ -0,0 +1,433 @@
+// batch.c
+// Directory mode: walk a tree, run the token pipeline on every file in
+// parallel, merge the results. See batch.h; used by io_demo.c (-d) and
+// batch_bench.c.
+
+#ifdef __linux__
+#define _GNU_SOURCE             // syscall(SYS_getdents64), DT_* entry types
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "../common/strslice.h"
+#include "../common/utf8.h"
+#include "batch.h"
+#include "reportsum.h"
+
+/* ---------------------------------- Walk ---------------------------------- */
+#define DENTS_BUF (32u << 10)   // getdents64 buffer per directory level
+
+enum { ENT_OTHER, ENT_DIR, ENT_REG, ENT_UNKNOWN };
+
+#ifdef __linux__
+struct linux_dirent64_ {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+typedef struct {
+    batch_list_t *list;
+    uint64_t skipped;
+    size_t rel;
+    char path[4096];
+} walk_t;
+
+static int push_(batch_list_t *l, const char *path, size_t len, size_t rel, uint64_t size) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? 2 * l->cap : 1024;
+        batch_file_t *f = realloc(l->files, cap * sizeof(*f));
+        if (!f) return -1;
+        l->files = f;
+        l->cap = cap;
+    }
+    char *p = malloc(len + 1);
+    if (!p) return -1;
+    memcpy(p, path, len + 1);
+    l->files[l->n++] = (batch_file_t){ p, rel, size };
+    l->bytes += size;
+    return 0;
+}
+
+static int walk_dir_(walk_t *w, int dfd, size_t len);
+
+// One entry of the directory open as dfd, whose path is w->path[0..len).
+// Returns -1 only when out of memory; anything unreadable is skipped.
+static int entry_(walk_t *w, int dfd, const char *name, int type, size_t len) {
+    if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]))) return 0;
+    if (type == ENT_OTHER) return 0;
+    size_t nlen = strlen(name);
+    if (len + 1 + nlen >= sizeof(w->path)) { w->skipped++; return 0; }
+    w->path[len] = '/';
+    memcpy(w->path + len + 1, name, nlen + 1);
+    len += 1 + nlen;
+    if (type != ENT_DIR) {
+        struct stat st;
+        if (fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) { w->skipped++; return 0; }
+        if (S_ISREG(st.st_mode)) return push_(w->list, w->path, len, w->rel, (uint64_t)st.st_size);
+        if (!S_ISDIR(st.st_mode)) return 0;
+    }
+    int fd = openat(dfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) { w->skipped++; return 0; }
+    return walk_dir_(w, fd, len);
+}
+
+// List the directory open as fd (closed here) and recurse.
+static int walk_dir_(walk_t *w, int fd, size_t len) {
+    int rc = 0;
+    w->list->dirs++;
+#ifdef __linux__
+    // getdents64 is what readdir() does underneath: one call fills the
+    // buffer with as many entries as fit. Not a speed-up (glibc buffers the
+    // same way, and the fstatat per entry dominates); it shows the layout.
+    char *buf = malloc(DENTS_BUF);
+    if (!buf) { close(fd); return -1; }
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buf, DENTS_BUF);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) { w->skipped++; break; }
+        if (n == 0) break;
+        for (long off = 0; off < n && rc == 0;) {
+            const struct linux_dirent64_ *d = (const struct linux_dirent64_ *)(buf + off);
+            int type = d->d_type == DT_DIR ? ENT_DIR : d->d_type == DT_REG ? ENT_REG
+                     : d->d_type == DT_UNKNOWN ? ENT_UNKNOWN : ENT_OTHER;
+            rc = entry_(w, fd, d->d_name, type, len);
+            off += d->d_reclen;
+        }
+        if (rc) break;
+    }
+    free(buf);
+    close(fd);
+#else
+    DIR *d = fdopendir(fd);
+    if (!d) { close(fd); w->skipped++; return 0; }
+    struct dirent *e;
+    while (rc == 0 && (e = readdir(d)) != NULL) rc = entry_(w, fd, e->d_name, ENT_UNKNOWN, len);
+    closedir(d);
+#endif
+    return rc;
+}
+
+static int by_size_desc_(const void *a, const void *b) {
+    const batch_file_t *x = a, *y = b;
+    if (x->size != y->size) return x->size < y->size ? 1 : -1;
+    return strcmp(x->path, y->path);
+}
+
+int batch_walk(const char *dir, batch_list_t *list, uint64_t *skipped) {
+    walk_t *w = malloc(sizeof(*w));
+    if (!w) return -1;
+    size_t len = strlen(dir);
+    while (len > 1 && dir[len - 1] == '/') len--;
+    int rc = -1;
+    if (len >= sizeof(w->path)) { errno = ENAMETOOLONG; goto out; }
+    memcpy(w->path, dir, len);
+    w->path[len] = '\0';
+    w->list = list;
+    w->skipped = 0;
+    w->rel = len + 1;
+    int fd = open(w->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) goto out;
+    rc = walk_dir_(w, fd, len);
+    if (skipped) *skipped = w->skipped;
+    if (rc == 0) qsort(list->files, list->n, sizeof(*list->files), by_size_desc_);
+out:
+    free(w);
+    return rc;
+}
+
+void batch_list_free(batch_list_t *list) {
+    for (size_t i = 0; i < list->n; i++) free(list->files[i].path);
+    free(list->files);
+    memset(list, 0, sizeof(*list));
+}
+
+/* -------------------------------- Pipeline -------------------------------- */
+// Part 2 + Part 3 on one line (only read, despite slice_t's char *).
+static int line_(batch_stream_t *s, const char *p, size_t n) {
+    batch_result_t *r = s->r;
+    r->lines++;
+    slice_t ls = slice_from((char *)p, n);
+    if (!utf8_valid(ls.ptr, ls.len)) r->bad_utf8++;
+    ls = slice_trim(ls);
+    slice_t tok;
+    while (slice_split(&ls, ' ', &tok)) {
+        int64_t v;
+        double d;
+        r->tokens++;
+        int is_int = tokstats_add(s->ts, tok.ptr, tok.len, &v);    // parses integers once, for both
+        if (is_int < 0) return -1;
+        if (s->sorted && toksort_add(s->sorted, tok.ptr, tok.len) != 0) return -1;
+        if (is_int) {
+            r->sum = (int64_t)((uint64_t)r->sum + (uint64_t)v);
+            r->ints++;
+        } else if (fparse_strict(tok.ptr, tok.len, &d)) {
+            fsum_add(&r->fsum, d);
+        }
+    }
+    return 0;
+}
+
+int batch_stream_init(batch_stream_t *s, batch_result_t *r, tokstats_mode_t mode) {
+    memset(s, 0, sizeof(*s));
+    memset(r, 0, sizeof(*r));
+    s->r = r;
+    r->distinct_est = mode == TOKSTATS_SKETCH;
+    s->ts = tokstats_new(mode, 16, 0);
+    return s->ts ? 0 : -1;
+}
+
+// Add p[0..n) to the carried partial line; at BATCH_CHUNK bytes it is
+// processed as a line of its own.
+static int carry_(batch_stream_t *s, const char *p, size_t n) {
+    while (n) {
+        if (s->have == BATCH_CHUNK) {
+            if (line_(s, s->carry, s->have) != 0) return -1;
+            s->have = 0;
+        }
+        if (s->have == s->cap) {
+            size_t cap = s->cap ? 2 * s->cap : 256;
+            char *c = realloc(s->carry, cap);
+            if (!c) return -1;
+            s->carry = c;
+            s->cap = cap;
+        }
+        size_t k = s->cap - s->have < n ? s->cap - s->have : n;
+        memcpy(s->carry + s->have, p, k);
+        s->have += k;
+        p += k;
+        n -= k;
+    }
+    return 0;
+}
+
+int batch_stream_feed(batch_stream_t *s, const char *p, size_t n) {
+    const char *end = p + n, *nl;
+    s->r->bytes += n;
+    if (s->have) {                                  // finish the line the last piece started
+        nl = memchr(p, '\n', n);
+        if (carry_(s, p, nl ? (size_t)(nl - p) : n) != 0) return -1;
+        if (!nl) return 0;
+        if (line_(s, s->carry, s->have) != 0) return -1;
+        s->have = 0;
+        p = nl + 1;
+    }
+    while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        if (line_(s, p, (size_t)(nl - p)) != 0) return -1;
+        p = nl + 1;
+    }
+    return carry_(s, p, (size_t)(end - p));
+}
+
+int batch_stream_finish(batch_stream_t *s) {
+    batch_result_t *r = s->r;
+    int rc = s->have ? line_(s, s->carry, s->have) : 0;     // no '\n' at EOF
+    r->num = *tokstats_numeric(s->ts);
+    r->distinct = tokstats_cardinality(s->ts);
+    tokstat_t top;
+    if (tokstats_top(s->ts, &top, 1) == 1) {
+        size_t n = top.len < TOKSTATS_KEY_MAX ? top.len : TOKSTATS_KEY_MAX;
+        memcpy(r->top, top.key, n);
+        r->top[n] = '\0';
+        r->top_count = top.count;
+    }
+    tokstats_free(s->ts);
+    free(s->carry);
+    memset(s, 0, sizeof(*s));
+    return rc;
+}
+
+static int read_file_(const batch_file_t *f, char *buf, batch_stream_t *s) {
+    int fd = open(f->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int rc = -1;
+    for (;;) {
+        ssize_t n = read(fd, buf, BATCH_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) goto out;
+        if (n == 0) break;
+        if (batch_stream_feed(s, buf, (size_t)n) != 0) goto out;
+    }
+    rc = 0;
+out:
+    close(fd);
+    return rc;
+}
+
+// '/' alone -> "__" would give a/b/f2 and a__b__f2 the same report, and
+// two workers would race on it; escaping the escape character too keeps the
+// mapping one-to-one.
+char *batch_report_path(const char *out_dir, const char *rel, bool compress) {
+    size_t n = strlen(out_dir) + 3 * strlen(rel) + 16;
+    char *p = malloc(n), *o = p;
+    if (!p) return NULL;
+    o += sprintf(o, "%s/", out_dir);
+    for (; *rel; rel++) {
+        if (*rel == '%' || *rel == '/') o += sprintf(o, "%%%02X", (unsigned char)*rel);
+        else *o++ = *rel;
+    }
+    strcpy(o, compress ? ".report.lzb" : ".report");
+    return p;
+}
+
+int batch_write_result(const char *path, int flags, const char *name, const batch_result_t *r) {
+    char *body = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&body, &len);
+    int rc = -1;
+    if (!out) return -1;
+    fprintf(out, "REPORT\nfile=%s\nbytes=%llu\nlines=%llu\ntokens=%llu\n", name,
+            (unsigned long long)r->bytes, (unsigned long long)r->lines, (unsigned long long)r->tokens);
+    fprintf(out, "numeric_tokens=%llu\n", (unsigned long long)r->ints);
+    if (r->ints > 0) fprintf(out, "sum=%lld\n", (long long)r->sum);
+    if (r->fsum.n > 0) {
+        fprintf(out, "float_tokens=%llu\nfloat_sum=%.17g\n", (unsigned long long)r->fsum.n, fsum_value(&r->fsum));
+    }
+    if (r->num.n > 0) {
+        fprintf(out, "min=%lld\nmax=%lld\nmean=%.3f\n", (long long)r->num.min, (long long)r->num.max, r->num.mean);
+    }
+    fprintf(out, r->distinct_est ? "distinct_tokens_est=%zu\n" : "distinct_tokens=%zu\n", r->distinct);
+    if (r->top_count) fprintf(out, "top_token=%s x%llu\n", r->top, (unsigned long long)r->top_count);
+    if (r->bad_utf8) fprintf(out, "bad_utf8_lines=%llu\n", (unsigned long long)r->bad_utf8);
+    if (fclose(out) == 0) rc = rsum_write_report(path, flags, body, len);
+    free(body);
+    return rc;
+}
+
+static int write_file_report_(const batch_file_t *f, const batch_opts_t *o, const batch_result_t *r) {
+    char *path = batch_report_path(o->out_dir, f->path + f->rel, o->compress);
+    if (!path) return -1;
+    int rc = batch_write_result(path, o->compress ? RSUM_COMPRESS : 0, f->path + f->rel, r);
+    free(path);
+    return rc;
+}
+
+static void process_file_(const batch_file_t *f, const batch_opts_t *o, char *buf, batch_result_t *r) {
+    batch_stream_t s;
+    if (batch_stream_init(&s, r, TOKSTATS_EXACT) != 0) { r->err = ENOMEM; return; }
+    int failed = read_file_(f, buf, &s) != 0;
+    int err = errno;
+    batch_stream_finish(&s);
+    if (failed) { r->err = err; return; }
+    if (o->out_dir && write_file_report_(f, o, r) != 0) r->err = errno;
+}
+
+typedef struct {
+    const batch_list_t *list;
+    const batch_opts_t *opts;
+    batch_result_t *results;
+    atomic_size_t next;         // next file to hand out (largest first)
+} shared_t;
+
+static void *worker_(void *arg) {
+    shared_t *sh = arg;
+    char *buf = malloc(BATCH_CHUNK);
+    for (;;) {
+        size_t i = atomic_fetch_add_explicit(&sh->next, 1, memory_order_relaxed);
+        if (i >= sh->list->n) break;
+        if (!buf) { sh->results[i] = (batch_result_t){ .err = ENOMEM }; continue; }
+        process_file_(&sh->list->files[i], sh->opts, buf, &sh->results[i]);
+    }
+    free(buf);
+    return NULL;
+}
+
+int batch_run(const batch_list_t *list, const batch_opts_t *opts, batch_result_t *results) {
+    shared_t sh = { list, opts, results, 0 };
+    int nw = opts->workers < 1 ? 1 : opts->workers;
+    pthread_t *tids = malloc((size_t)nw * sizeof(*tids));
+    if (!tids) return -1;
+    int started = 0;
+    for (; started < nw; started++) {
+        int e = pthread_create(&tids[started], NULL, worker_, &sh);
+        if (e != 0) { errno = e; break; }
+    }
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    free(tids);
+    return started > 0 ? 0 : -1;
+}
+
+/* --------------------------------- Summary -------------------------------- */
+// Combine two sets of integer statistics (Chan et al.'s parallel variance).
+static void merge_num_(tokstats_num_t *a, const tokstats_num_t *b) {
+    if (!b->n) return;
+    if (!a->n) { *a = *b; return; }
+    uint64_t n = a->n + b->n;
+    double delta = b->mean - a->mean;
+    a->m2 += b->m2 + delta * delta * ((double)a->n * (double)b->n / (double)n);
+    a->mean += delta * ((double)b->n / (double)n);
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+    a->neg += b->neg;
+    for (int i = 0; i < 65; i++) a->hist[i] += b->hist[i];
+    a->n = n;
+}
+
+int batch_write_summary(const char *path, int flags, const char *dir, const batch_list_t *list,
+                        const batch_result_t *results) {
+    batch_result_t t = { 0 };
+    fsum_t fsum = { 0 };
+    uint64_t floats = 0, failed = 0;
+    for (size_t i = 0; i < list->n; i++) {
+        const batch_result_t *r = &results[i];
+        if (r->err) { failed++; continue; }
+        t.bytes += r->bytes;
+        t.lines += r->lines;
+        t.tokens += r->tokens;
+        t.ints += r->ints;
+        t.bad_utf8 += r->bad_utf8;
+        t.sum = (int64_t)((uint64_t)t.sum + (uint64_t)r->sum);
+        if (r->fsum.n) fsum_add(&fsum, fsum_value(&r->fsum));
+        floats += r->fsum.n;
+        merge_num_(&t.num, &r->num);
+    }
+
+    char *body = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&body, &len);
+    if (!out) return -1;
+    fprintf(out, "REPORT\nmode=directory\ndir=%s\nfiles=%zu\nfailed_files=%llu\n", dir, list->n,
+            (unsigned long long)failed);
+    fprintf(out, "bytes=%llu\nlines=%llu\ntokens=%llu\nnumeric_tokens=%llu\n", (unsigned long long)t.bytes,
+            (unsigned long long)t.lines, (unsigned long long)t.tokens, (unsigned long long)t.ints);
+    if (t.ints > 0) fprintf(out, "sum=%lld\n", (long long)t.sum);
+    if (floats > 0) fprintf(out, "float_tokens=%llu\nfloat_sum=%.17g\n", (unsigned long long)floats, fsum_value(&fsum));
+    if (t.num.n > 0) {
+        double sd = t.num.n > 1 ? sqrt(t.num.m2 / (double)(t.num.n - 1)) : 0.0;
+        fprintf(out, "min=%lld\nmax=%lld\nmean=%.3f\nstddev=%.3f\n", (long long)t.num.min, (long long)t.num.max,
+                t.num.mean, sd);
+    }
+    if (t.bad_utf8) fprintf(out, "bad_utf8_lines=%llu\n", (unsigned long long)t.bad_utf8);
+    for (size_t i = 0; i < list->n; i++) {
+        const batch_result_t *r = &results[i];
+        const char *rel = list->files[i].path + list->files[i].rel;
+        if (r->err) {
+            fprintf(out, "file[%zu]=%s error=%s\n", i, rel, strerror(r->err));
+        } else {
+            fprintf(out, "file[%zu]=%s bytes=%llu lines=%llu tokens=%llu sum=%lld top=%s\n", i, rel,
+                    (unsigned long long)r->bytes, (unsigned long long)r->lines, (unsigned long long)r->tokens,
+                    (long long)r->sum, r->top_count ? r->top : "-");
+        }
+    }
+    int rc = -1;
+    if (fclose(out) == 0) rc = rsum_write_report(path, flags, body, len);
+    free(body);
+    return rc;
+}
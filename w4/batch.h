@@ -0,0 +1,109 @@
+// batch.h
+// io_demo's directory mode: the Part 2/3 pipeline over every file in a tree.
+//
+// batch_walk() lists the regular files under a directory (recursively,
+// symlinks skipped) with getdents64 on Linux and readdir elsewhere, plus one
+// fstatat per entry for the size, and sorts them largest first.
+//
+// batch_run() starts `workers` threads that take files from the list in
+// that order through one atomic counter. Big files start first and small
+// ones fill in at the end, so no worker is still busy with a long file
+// while the others sit idle (longest-processing-time-first scheduling).
+// Each file is read in BATCH_CHUNK pieces and split into lines, then into
+// tokens on ' ' like Part 2. Every token is counted (tokstats.c), integers
+// are summed (Part 3) and float tokens summed with compensation (fparse.c).
+// With an out_dir, each file also gets its own REPORT (reportsum.c: CRC32C,
+// LZ blocks if asked), named after its path in the tree with '%' -> "%25"
+// and '/' -> "%2F": one flat directory, and no two paths share a name.
+//
+// batch_stream_t is the same per-file pipeline for input that is not a
+// file (io_demo -p reads a pipe): feed it bytes in pieces of any size. Give
+// it a toksort_t (sorted) and every token is also collected there.
+//
+// batch_write_summary() merges the per-file results into one REPORT: totals,
+// combined integer statistics and one file[i]= line per file.
+
+#ifndef W4_BATCH_H
+#define W4_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fparse.h"
+#include "toksort.h"
+#include "tokstats.h"
+
+#define BATCH_CHUNK (1u << 20)  // read size; longer lines are split
+
+typedef struct {
+    char *path;                 // dir + "/" + relative path
+    size_t rel;                 // where the relative part starts in path
+    uint64_t size;
+} batch_file_t;
+
+typedef struct {
+    batch_file_t *files;
+    size_t n, cap;
+    uint64_t bytes, dirs;
+} batch_list_t;
+
+typedef struct {
+    uint64_t bytes, lines, tokens, ints, bad_utf8;
+    int64_t sum;                // wraps like the machine would, never traps
+    fsum_t fsum;
+    tokstats_num_t num;         // integer tokens: min/max/mean/m2
+    size_t distinct;            // distinct tokens (an estimate if distinct_est)
+    bool distinct_est;          // counted in sketch mode: HyperLogLog
+    char top[TOKSTATS_KEY_MAX + 1];
+    uint64_t top_count;
+    int err;                    // errno if the file or its report failed, else 0
+} batch_result_t;
+
+typedef struct {
+    int workers;
+    const char *out_dir;        // per-file reports here, or NULL for none
+    bool compress;              // per-file reports as .lzb
+} batch_opts_t;
+
+typedef struct {
+    batch_result_t *r;
+    tokstats_t *ts;
+    toksort_t *sorted;          // set after init to collect tokens, or NULL
+    char *carry;                // a line split across pieces
+    size_t have, cap;
+} batch_stream_t;
+
+// Zero *r and start counting into it (exact or sketch token counts).
+// Returns 0, or -1 if out of memory.
+int batch_stream_init(batch_stream_t *s, batch_result_t *r, tokstats_mode_t mode);
+// Returns 0, or -1 if out of memory.
+int batch_stream_feed(batch_stream_t *s, const char *p, size_t n);
+// Process a last line without '\n', fill in the token results, free s
+// (not s->sorted). Returns 0, or -1 if out of memory.
+int batch_stream_finish(batch_stream_t *s);
+
+// Fill list (zeroed by the caller) with the files under dir. Returns 0, or
+// -1 with errno set; unreadable subdirectories are skipped and counted in
+// *skipped if it is not NULL.
+int batch_walk(const char *dir, batch_list_t *list, uint64_t *skipped);
+void batch_list_free(batch_list_t *list);
+
+// Process every file of list into results[0..list->n). Returns 0, or -1
+// with errno set if no worker could be started; per-file failures are in
+// results[i].err.
+int batch_run(const batch_list_t *list, const batch_opts_t *opts, batch_result_t *results);
+
+// "<out_dir>/<rel, escaped>.report[.lzb]", malloc'd; NULL if out of memory.
+char *batch_report_path(const char *out_dir, const char *rel, bool compress);
+
+// One result as a REPORT at path (rsum_write_report flags), the same fields
+// as io_demo's Part 4 report plus file=name. Returns 0, or -1 with errno set.
+int batch_write_result(const char *path, int flags, const char *name, const batch_result_t *r);
+
+// Merge results into one REPORT at path (rsum_write_report flags).
+// Returns 0, or -1 with errno set.
+int batch_write_summary(const char *path, int flags, const char *dir, const batch_list_t *list,
+                        const batch_result_t *results);
+
+#endif /* W4_BATCH_H */
@@ -0,0 +1,273 @@
+// batch_bench.c
+// Recitation extension: io_demo's directory mode (batch.c) on a generated tree
+//
+// Build:  make batch_bench
+// Run:    ./batch_bench                     (20000 files, 256 MiB, in /tmp)
+//         ./batch_bench -n 50000 -s 1G -d /some/disk -j 32
+//
+// 1. Generates -n log files under 1000 directories, sizes log-uniform
+//    (a few large files, many small ones) adding up to -s bytes.
+// 2. Walks the tree: batch_walk (getdents64 on Linux) vs opendir/readdir,
+//    both with one fstatat per entry, and prints their ratio; batch_walk
+//    also builds and sorts the file list, so it is not expected to win.
+// 3. Runs the pipeline with 1, 2, 4, ... -j workers, per-file reports on:
+//    files/s, MB/s and speedup; every run must produce the same totals.
+// 4. At -j workers, hands files out in walk order instead of largest
+//    first, to show what the ordering buys when a big file comes last.
+
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "batch.h"
+
+#define TOP_DIRS 100
+#define SUB_DIRS 10
+
+static uint64_t rng = 0x13198A2E03707344ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+static double rnd01(void) { return (double)(rnd() >> 11) / 9007199254740992.0; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* ---------------------------------- Tree ---------------------------------- */
+// Access-log-like lines: a method, a path, a latency, a status and a size.
+static size_t make_lines(char *out, size_t cap) {
+    static const char *methods[] = { "GET", "GET", "GET", "POST", "PUT", "DELETE" };
+    size_t used = 0;
+    while (used + 128 < cap) {
+        used += (size_t)snprintf(out + used, 128, "%s /api/v%u/items/%u %u.%03u %u %u\n", methods[rnd() % 6],
+                                 (unsigned)(rnd() % 4), (unsigned)(rnd() % 5000), (unsigned)(rnd() % 900),
+                                 (unsigned)(rnd() % 1000), (rnd() % 10) ? 200u : 500u, (unsigned)(rnd() % 65536));
+    }
+    return used;
+}
+
+static int write_all(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static void make_tree(const char *root, size_t nfiles, size_t total) {
+    size_t pool_cap = 8u << 20;
+    char *pool = malloc(pool_cap);
+    double *w = malloc(nfiles * sizeof(*w));
+    if (!pool || !w) { perror("malloc"); exit(1); }
+    size_t pool_len = make_lines(pool, pool_cap);
+    double wsum = 0;
+    for (size_t i = 0; i < nfiles; i++) wsum += w[i] = exp(rnd01() * log(4096.0));  // 1 .. 4096
+    char path[1024];
+    mkdir(root, 0755);
+    for (int d = 0; d < TOP_DIRS; d++) {
+        snprintf(path, sizeof(path), "%s/d%02d", root, d);
+        mkdir(path, 0755);
+        for (int e = 0; e < SUB_DIRS; e++) {
+            snprintf(path, sizeof(path), "%s/d%02d/e%d", root, d, e);
+            mkdir(path, 0755);
+        }
+    }
+    for (size_t i = 0; i < nfiles; i++) {
+        size_t size = (size_t)((double)total * w[i] / wsum);
+        if (size < 64) size = 64;
+        if (size > pool_len / 2) size = pool_len / 2;
+        size_t at = (size_t)(rnd() % (pool_len - size));
+        while (at && pool[at - 1] != '\n') at--;            // whole lines
+        size_t end = at + size;
+        while (end < pool_len && pool[end - 1] != '\n') end++;
+        snprintf(path, sizeof(path), "%s/d%02zu/e%zu/f%06zu.log", root, i % TOP_DIRS, (i / TOP_DIRS) % SUB_DIRS, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || write_all(fd, pool + at, end - at) != 0) { perror(path); exit(1); }
+        close(fd);
+    }
+    free(w);
+    free(pool);
+}
+
+static void remove_tree(const char *root, const batch_list_t *list) {
+    char path[1024];
+    for (size_t i = 0; i < list->n; i++) unlink(list->files[i].path);
+    for (int d = 0; d < TOP_DIRS; d++) {
+        for (int e = 0; e < SUB_DIRS; e++) {
+            snprintf(path, sizeof(path), "%s/d%02d/e%d", root, d, e);
+            rmdir(path);
+        }
+        snprintf(path, sizeof(path), "%s/d%02d", root, d);
+        rmdir(path);
+    }
+    rmdir(root);
+}
+
+/* ------------------------------ readdir walk ------------------------------ */
+static size_t readdir_walk(int dfd, uint64_t *bytes) {
+    DIR *d = fdopendir(dfd);
+    if (!d) { close(dfd); return 0; }
+    size_t files = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.' && (!e->d_name[1] || (e->d_name[1] == '.' && !e->d_name[2]))) continue;
+        struct stat st;
+        if (fstatat(dfd, e->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+        if (S_ISREG(st.st_mode)) {
+            files++;
+            *bytes += (uint64_t)st.st_size;
+        } else if (S_ISDIR(st.st_mode)) {
+            int sub = openat(dfd, e->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+            if (sub >= 0) files += readdir_walk(sub, bytes);
+        }
+    }
+    closedir(d);
+    return files;
+}
+
+/* ---------------------------------- Runs ---------------------------------- */
+typedef struct { uint64_t lines, tokens, ints; int64_t sum; double fsum; size_t failed; } totals_t;
+
+static totals_t totals(const batch_list_t *list, const batch_result_t *r) {
+    totals_t t = { 0 };
+    for (size_t i = 0; i < list->n; i++) {
+        if (r[i].err) { t.failed++; continue; }
+        t.lines += r[i].lines;
+        t.tokens += r[i].tokens;
+        t.ints += r[i].ints;
+        t.sum += r[i].sum;
+        t.fsum += fsum_value(&r[i].fsum);
+    }
+    return t;
+}
+
+static double run(const batch_list_t *list, int workers, const char *out_dir, batch_result_t *res) {
+    batch_opts_t o = { workers, out_dir, false };
+    uint64_t t0 = timing_now_ns();
+    if (batch_run(list, &o, res) != 0) { perror("batch_run"); exit(1); }
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t nfiles = 20000, total = 256u << 20;
+    const char *dir = "/tmp";
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_j = cpus > 4 ? 2 * (int)cpus : 8;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:d:j:")) != -1) {
+        switch (opt) {
+            case 'n': nfiles = (size_t)atol(optarg); break;
+            case 's': total = parse_size(optarg); break;
+            case 'd': dir = optarg; break;
+            case 'j': max_j = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n files] [-s total_bytes] [-d dir] [-j max_workers]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (nfiles < 1 || max_j < 1) return 2;
+    char root[512], out_dir[512];
+    snprintf(root, sizeof(root), "%s/batch_bench_tree", dir);
+    snprintf(out_dir, sizeof(out_dir), "%s/batch_bench_reports", dir);
+    printf("=== Directory mode: %zu files, %.0f MiB, %ld CPU(s) ===\n\n", nfiles, (double)total / (1 << 20), cpus);
+
+    uint64_t t0 = timing_now_ns();
+    make_tree(root, nfiles, total);
+    mkdir(out_dir, 0755);
+    printf("generated the tree in %.2f s\n", (double)(timing_now_ns() - t0) / 1e9);
+
+    // Walks, best of 3 (dentries and inodes cached after the first).
+    batch_list_t list = { 0 };
+    double best_gd = 1e30, best_rd = 1e30;
+    size_t rd_files = 0;
+    uint64_t rd_bytes = 0;
+    for (int r = 0; r < 3; r++) {
+        batch_list_free(&list);
+        t0 = timing_now_ns();
+        if (batch_walk(root, &list, NULL) != 0) { perror(root); return 1; }
+        double s = (double)(timing_now_ns() - t0) / 1e9;
+        if (s < best_gd) best_gd = s;
+        rd_bytes = 0;
+        t0 = timing_now_ns();
+        rd_files = readdir_walk(open(root, O_RDONLY | O_DIRECTORY), &rd_bytes);
+        s = (double)(timing_now_ns() - t0) / 1e9;
+        if (s < best_rd) best_rd = s;
+    }
+    int ok = list.n == nfiles && rd_files == nfiles && rd_bytes == list.bytes;
+    printf("walk (%zu files, %llu dirs)  batch_walk %.1f ms   readdir %.1f ms  (%.2fx the speed)  %s\n", list.n,
+           (unsigned long long)list.dirs, best_gd * 1e3, best_rd * 1e3, best_rd / best_gd,
+           ok ? "✅ same files" : "❌ counts differ");
+    printf("  (batch_walk also copies every path and sorts the list by size)\n");
+    printf("largest file %.1f KiB, smallest %.2f KiB\n\n", (double)list.files[0].size / 1024,
+           (double)list.files[list.n - 1].size / 1024);
+
+    batch_result_t *res = malloc(list.n * sizeof(*res));
+    if (!res) { perror("malloc"); return 1; }
+    run(&list, max_j, out_dir, res);                // warm the page cache for the reads
+    printf("%8s %10s %10s %10s %8s\n", "workers", "seconds", "files/s", "MB/s", "speedup");
+    totals_t ref = { 0 };
+    double base = 0;
+    for (int j = 1; j <= max_j; j = j < max_j && 2 * j > max_j ? max_j : 2 * j) {
+        double s = run(&list, j, out_dir, res);
+        totals_t t = totals(&list, res);
+        if (j == 1) {
+            ref = t;
+            base = s;
+        }
+        int same = t.failed == 0 && t.lines == ref.lines && t.tokens == ref.tokens && t.sum == ref.sum &&
+                   t.fsum == ref.fsum;
+        ok &= same;
+        printf("%8d %10.3f %10.0f %10.1f %7.2fx %s\n", j, s, (double)list.n / s, (double)list.bytes / s / 1e6,
+               base / s, same ? "✅" : "❌ totals differ");
+        if (j == max_j) break;
+    }
+    printf("totals: %llu lines, %llu tokens, %llu integers (sum %lld)\n", (unsigned long long)ref.lines,
+           (unsigned long long)ref.tokens, (unsigned long long)ref.ints, (long long)ref.sum);
+
+    // Walk order instead of largest first: move the biggest file to the end.
+    batch_list_t order = list;
+    order.files = malloc(list.n * sizeof(*order.files));
+    if (!order.files) { perror("malloc"); return 1; }
+    memcpy(order.files, list.files + 1, (list.n - 1) * sizeof(*order.files));
+    order.files[list.n - 1] = list.files[0];
+    double s_sorted = run(&list, max_j, out_dir, res);
+    double s_last = run(&order, max_j, out_dir, res);
+    printf("\n%d workers: largest first %.3f s, largest last %.3f s\n", max_j, s_sorted, s_last);
+    free(order.files);
+
+    for (size_t i = 0; i < list.n; i++) {
+        char *path = batch_report_path(out_dir, list.files[i].path + list.files[i].rel, false);
+        if (path) unlink(path);
+        free(path);
+    }
+    rmdir(out_dir);
+    remove_tree(root, &list);
+    batch_list_free(&list);
+    free(res);
+
+    printf("\nTakeaway:\n");
+    printf("  • Files are independent, so throughput scales with workers until the disk\n"
+           "    or the core count runs out; tens of thousands of small files are then\n"
+           "    dominated by open/read/close and the per-file report, not by parsing.\n");
+    printf("  • Largest first keeps the tail short: the last file to start is a small one.\n\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// checkpoint.c
+// Checkpointed line reader for append-only files. See checkpoint.h; used by
+// io_demo.c (Part 5) and checkpoint_bench.c.
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+#define CKPT_CHUNK (1u << 20)   // pread size for the line scan
+
+typedef struct {
+    uint64_t offset, dev, ino;
+    uint32_t sum, len;
+    uint32_t crc;
+    int has_crc;
+} ckpt_t;
+
+const char *ckpt_state_name(ckpt_state_t s) {
+    switch (s) {
+        case CKPT_NONE:      return "no checkpoint";
+        case CKPT_RESUMED:   return "resumed";
+        case CKPT_ROTATED:   return "file rotated";
+        case CKPT_TRUNCATED: return "file truncated";
+        case CKPT_MODIFIED:  return "file modified before checkpoint";
+    }
+    return "?";
+}
+
+uint32_t ckpt_adler32(const void *p, size_t n) {
+    const unsigned char *b = p;
+    uint32_t a = 1, s = 0;
+    while (n) {
+        // 5552 bytes is the most that cannot overflow s before the modulo.
+        size_t k = n < 5552 ? n : 5552;
+        n -= k;
+        while (k--) { a += *b++; s += a; }
+        a %= 65521;
+        s %= 65521;
+    }
+    return (s << 16) | a;
+}
+
+static int pread_all_(int fd, char *buf, size_t n, uint64_t off) {
+    while (n) {
+        ssize_t r = pread(fd, buf, n, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        buf += r;
+        n -= (size_t)r;
+        off += (uint64_t)r;
+    }
+    return 0;
+}
+
+// Checksum of the boundary block ending at `end`.
+static int boundary_(int fd, uint64_t end, uint32_t *sum, uint32_t *len) {
+    char buf[CKPT_BOUNDARY];
+    *len = (uint32_t)(end < CKPT_BOUNDARY ? end : CKPT_BOUNDARY);
+    if (pread_all_(fd, buf, *len, end - *len) != 0) return -1;
+    *sum = ckpt_adler32(buf, *len);
+    return 0;
+}
+
+static int load_(const char *path, ckpt_t *c) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    unsigned long long off, dev, ino;
+    unsigned sum, len;
+    int n = fscanf(f, "offset=%llu\ndev=%llu\nino=%llu\nsum=%u\nlen=%u\n", &off, &dev, &ino, &sum, &len);
+    unsigned crc = 0;
+    int has_crc = n == 5 && fscanf(f, "crc32c=%x\n", &crc) == 1;
+    fclose(f);
+    if (n != 5) return -1;
+    *c = (ckpt_t){ off, dev, ino, sum, len, crc, has_crc };
+    return 0;
+}
+
+static ckpt_state_t resume_(const char *ckpt_path, int fd, uint64_t *start, uint32_t *crc) {
+    *start = 0;
+    ckpt_t c;
+    struct stat st;
+    if (load_(ckpt_path, &c) != 0 || fstat(fd, &st) != 0) return CKPT_NONE;
+    if (crc && !c.has_crc) return CKPT_NONE;
+    if ((uint64_t)st.st_dev != c.dev || (uint64_t)st.st_ino != c.ino) return CKPT_ROTATED;
+    if ((uint64_t)st.st_size < c.offset) return CKPT_TRUNCATED;
+    uint32_t sum, len;
+    if (boundary_(fd, c.offset, &sum, &len) != 0 || sum != c.sum || len != c.len) return CKPT_MODIFIED;
+    *start = c.offset;
+    if (crc) *crc = c.crc;
+    return CKPT_RESUMED;
+}
+
+ckpt_state_t ckpt_resume(const char *ckpt_path, int fd, uint64_t *start) {
+    return resume_(ckpt_path, fd, start, NULL);
+}
+
+ckpt_state_t ckpt_resume_crc(const char *ckpt_path, int fd, uint64_t *start, uint32_t *crc) {
+    return resume_(ckpt_path, fd, start, crc);
+}
+
+int64_t ckpt_for_each_line(int fd, uint64_t start, ckpt_line_fn fn, void *arg) {
+    char *buf = malloc(CKPT_CHUNK);
+    if (!buf) return -1;
+    uint64_t off = start;       // file offset of buf[0]
+    size_t have = 0;            // bytes in buf
+    int64_t done = (int64_t)start;
+    for (;;) {
+        ssize_t r = pread(fd, buf + have, CKPT_CHUNK - have, (off_t)(off + have));
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) { done = -1; break; }
+        have += (size_t)r;
+        size_t used = 0;
+        for (;;) {
+            const char *nl = memchr(buf + used, '\n', have - used);
+            if (!nl) break;
+            size_t len = (size_t)(nl - (buf + used)) + 1;
+            if (fn && fn(buf + used, len, arg)) { done = (int64_t)(off + used + len); goto out; }
+            used += len;
+        }
+        done = (int64_t)(off + used);
+        if (r == 0) break;                      // EOF: a partial last line stays unread
+        if (used == 0 && have == CKPT_CHUNK) {  // one line longer than the buffer
+            errno = EOVERFLOW;
+            done = -1;
+            break;
+        }
+        memmove(buf, buf + used, have - used);
+        have -= used;
+        off += used;
+    }
+out:
+    free(buf);
+    return done;
+}
+
+static int commit_(const char *ckpt_path, int fd, uint64_t end, const uint32_t *crc) {
+    struct stat st;
+    uint32_t sum, len;
+    if (fstat(fd, &st) != 0 || boundary_(fd, end, &sum, &len) != 0) return -1;
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", ckpt_path) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    int ok = fprintf(f, "offset=%llu\ndev=%llu\nino=%llu\nsum=%u\nlen=%u\n",
+                     (unsigned long long)end, (unsigned long long)st.st_dev,
+                     (unsigned long long)st.st_ino, sum, len) > 0;
+    if (ok && crc) ok = fprintf(f, "crc32c=%08x\n", *crc) > 0;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, ckpt_path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int ckpt_commit(const char *ckpt_path, int fd, uint64_t end) {
+    return commit_(ckpt_path, fd, end, NULL);
+}
+
+int ckpt_commit_crc(const char *ckpt_path, int fd, uint64_t end, uint32_t crc) {
+    return commit_(ckpt_path, fd, end, &crc);
+}
@@ -0,0 +1,66 @@
+// checkpoint.h
+// Resume reading an append-only file (io_demo's REPORT file with -a) where
+// the previous run stopped, instead of re-reading it from byte 0.
+//
+// The checkpoint is a small text file next to the data (e.g. output.txt.ckpt):
+//     offset=...      first byte not yet processed (always a line start)
+//     dev=... ino=... identity of the file that offset belongs to
+//     sum=... len=... Adler-32 of the `len` bytes just before offset
+//                     (the "boundary block", up to CKPT_BOUNDARY bytes)
+//     crc32c=...      optional: the caller's running CRC32C of [0, offset)
+//                     (io_demo uses it to check the report footer on resume)
+//
+// ckpt_resume() only trusts the offset if the file is still the same inode,
+// is at least `offset` bytes long, and the boundary block still has the same
+// checksum. Otherwise it says why and restarts at 0:
+//     CKPT_ROTATED    different inode (renamed away, new file created)
+//     CKPT_TRUNCATED  file shorter than the offset (rewritten with "w")
+//     CKPT_MODIFIED   same size or longer, but the bytes before the offset
+//                     changed (rewritten in place)
+//
+// Lines are the records: a final line without '\n' is still being written,
+// so it is left for the next run.
+
+#ifndef W4_CHECKPOINT_H
+#define W4_CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CKPT_BOUNDARY 4096      // bytes before the offset that are checksummed
+
+typedef enum {
+    CKPT_NONE,                  // no (readable) checkpoint: full read
+    CKPT_RESUMED,
+    CKPT_ROTATED,
+    CKPT_TRUNCATED,
+    CKPT_MODIFIED,
+} ckpt_state_t;
+
+const char *ckpt_state_name(ckpt_state_t s);
+
+// Where should reading fd start? Sets *start (0 unless CKPT_RESUMED).
+ckpt_state_t ckpt_resume(const char *ckpt_path, int fd, uint64_t *start);
+
+// Called once per complete line, '\n' included; return non-zero to stop.
+typedef int (*ckpt_line_fn)(const char *line, size_t len, void *arg);
+
+// Feed every complete line from start to EOF to fn (may be NULL), reading
+// with pread in large chunks. Returns the offset just past the last line
+// delivered, which is what ckpt_commit should record, or -1 on error.
+int64_t ckpt_for_each_line(int fd, uint64_t start, ckpt_line_fn fn, void *arg);
+
+// Record `end` (normally ckpt_for_each_line's result) for fd.
+// Written to a temp file and renamed, so a crash leaves the old checkpoint.
+int ckpt_commit(const char *ckpt_path, int fd, uint64_t end);
+
+// The same, carrying a CRC32C of bytes [0, offset) (see reportsum.h). A
+// checkpoint saved without one resumes as CKPT_NONE, so the caller re-reads
+// from 0 and can compute it.
+ckpt_state_t ckpt_resume_crc(const char *ckpt_path, int fd, uint64_t *start, uint32_t *crc);
+int ckpt_commit_crc(const char *ckpt_path, int fd, uint64_t end, uint32_t crc);
+
+// Adler-32 as in zlib / rsync's rolling checksum.
+uint32_t ckpt_adler32(const void *p, size_t n);
+
+#endif /* W4_CHECKPOINT_H */
@@ -0,0 +1,222 @@
+// checkpoint_bench.c
+// Recitation extension: re-reading a growing report vs resuming from a checkpoint
+//
+// Build:  make checkpoint_bench
+// Run:    ./checkpoint_bench                     (1 GiB report + 1 MiB appended)
+//         ./checkpoint_bench -s 10G -a 1M        (the full-size run, needs ~10 GiB disk)
+//         ./checkpoint_bench -d /some/disk       (where to put the test file)
+//
+// Steps:
+//   1. write a report file of -s bytes (io_demo REPORT blocks, repeated)
+//   2. first run: no checkpoint, every line is processed; commit
+//   3. append -a bytes of new reports (what `io_demo out.txt -a` does)
+//   4. full rescan (the old Part 5) vs resumed run (only the new lines)
+// Then, on a small file, check that truncation, in-place rewrite and
+// rotation are each detected and fall back to a full read.
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "checkpoint.h"
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* ----------------------------- Report data ------------------------------ */
+// ~1 MiB of complete REPORT blocks, written as many times as needed.
+static size_t make_chunk(char *buf, size_t cap, unsigned seed) {
+    size_t n = 0;
+    for (unsigned r = 0;; r++) {
+        char rep[1024];
+        int len = snprintf(rep, sizeof(rep),
+                           "REPORT\nargv_count=2\nargv[0]=./io_demo\nargv[1]=output.txt\nline_tokens=4\n"
+                           "token[0]=run%u\ntoken[1]=%u\ntoken[2]=-%u\ntoken[3]=ok\n"
+                           "numeric_tokens=2\nsum=0\n---- END REPORT ----\n", seed + r, r, r);
+        if (n + (size_t)len > cap) return n;
+        memcpy(buf + n, rep, (size_t)len);
+        n += (size_t)len;
+    }
+}
+
+static int append_bytes(const char *path, size_t bytes, unsigned seed) {
+    static char chunk[1 << 20];
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return -1;
+    size_t full = make_chunk(chunk, sizeof(chunk), seed);
+    for (size_t done = 0; done < bytes;) {
+        // Whole chunks, then one shorter chunk; stop when not even one report fits.
+        size_t n = bytes - done < full ? make_chunk(chunk, bytes - done, seed) : full;
+        if (!n) break;
+        if (write(fd, chunk, n) != (ssize_t)n) { close(fd); return -1; }
+        done += n;
+    }
+    return close(fd);
+}
+
+/* ------------------------------ Processing ------------------------------ */
+typedef struct { uint64_t lines, reports, bytes; } tally_t;
+
+// Stand-in for Part 5's per-line work: count lines and REPORT records.
+static int tally_line(const char *line, size_t len, void *arg) {
+    tally_t *t = arg;
+    t->lines++;
+    t->bytes += len;
+    if (len == 7 && memcmp(line, "REPORT\n", 7) == 0) t->reports++;
+    return 0;
+}
+
+// One run of "Part 5": resume, read new lines, commit. Returns ms.
+static double run(const char *path, const char *ckpt, int use_ckpt, tally_t *t, ckpt_state_t *st) {
+    uint64_t t0 = timing_now_ns();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror(path); exit(1); }
+    uint64_t start = 0;
+    *st = use_ckpt ? ckpt_resume(ckpt, fd, &start) : CKPT_NONE;
+    memset(t, 0, sizeof(*t));
+    int64_t end = ckpt_for_each_line(fd, start, tally_line, t);
+    if (end < 0 || (use_ckpt && ckpt_commit(ckpt, fd, (uint64_t)end) != 0)) {
+        perror("checkpoint");
+        exit(1);
+    }
+    close(fd);
+    return (double)(timing_now_ns() - t0) / 1e6;
+}
+
+/* --------------------------- Detection checks --------------------------- */
+static int expect(const char *what, const char *path, const char *ckpt, ckpt_state_t want) {
+    tally_t t;
+    ckpt_state_t st;
+    run(path, ckpt, 1, &t, &st);
+    int ok = st == want;
+    printf("  %-34s -> %-32s %s\n", what, ckpt_state_name(st), ok ? "✅" : "❌");
+    return ok;
+}
+
+static int detection_checks(const char *dir) {
+    char path[512], ckpt[520], moved[520];
+    snprintf(path, sizeof(path), "%s/ckpt_small.txt", dir);
+    snprintf(ckpt, sizeof(ckpt), "%s.ckpt", path);
+    snprintf(moved, sizeof(moved), "%s.1", path);
+    unlink(path);
+    unlink(ckpt);
+    int ok = 1;
+    append_bytes(path, 64 << 10, 1);
+    ok &= expect("first run", path, ckpt, CKPT_NONE);
+    append_bytes(path, 8 << 10, 2);
+    ok &= expect("append (io_demo -a)", path, ckpt, CKPT_RESUMED);
+
+    // Partial last line: must not be consumed until it is finished.
+    int fd = open(path, O_WRONLY | O_APPEND);
+    if (write(fd, "REPORT\nargv_co", 14) != 14) ok = 0;
+    close(fd);
+    tally_t t;
+    ckpt_state_t st;
+    run(path, ckpt, 1, &t, &st);
+    fd = open(path, O_WRONLY | O_APPEND);
+    if (write(fd, "unt=1\n", 6) != 6) ok = 0;
+    close(fd);
+    run(path, ckpt, 1, &t, &st);
+    int partial_ok = st == CKPT_RESUMED && t.lines == 1 && t.bytes == 13;
+    printf("  %-34s -> %-32s %s\n", "line finished by a later write", "delivered once, complete",
+           partial_ok ? "✅" : "❌");
+    ok &= partial_ok;
+
+    if (truncate(path, 1000) != 0) ok = 0;
+    ok &= expect("truncate (io_demo without -a)", path, ckpt, CKPT_TRUNCATED);
+    append_bytes(path, 64 << 10, 3);
+    run(path, ckpt, 1, &t, &st);                // checkpoint the new content
+    fd = open(path, O_WRONLY);                  // same length, different bytes
+    if (pwrite(fd, "X", 1, lseek(fd, 0, SEEK_END) - 10) != 1) ok = 0;
+    close(fd);
+    ok &= expect("rewrite in place", path, ckpt, CKPT_MODIFIED);
+    if (rename(path, moved) != 0) ok = 0;
+    append_bytes(path, 64 << 10, 4);
+    ok &= expect("rotate (rename + new file)", path, ckpt, CKPT_ROTATED);
+    unlink(path);
+    unlink(moved);
+    unlink(ckpt);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    size_t size = 1ul << 30, add = 1u << 20;
+    const char *dir = "/tmp";
+    int opt;
+    while ((opt = getopt(argc, argv, "s:a:d:")) != -1) {
+        switch (opt) {
+            case 's': size = parse_size(optarg); break;
+            case 'a': add = parse_size(optarg); break;
+            case 'd': dir = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-s report_bytes] [-a appended_bytes] [-d dir]\n", argv[0]);
+                return 2;
+        }
+    }
+    char path[512], ckpt[520];
+    snprintf(path, sizeof(path), "%s/ckpt_report.txt", dir);
+    snprintf(ckpt, sizeof(ckpt), "%s.ckpt", path);
+
+    struct statvfs vfs;
+    if (statvfs(dir, &vfs) == 0 &&
+        (double)vfs.f_bavail * vfs.f_frsize < (double)(size + add) * 1.1) {
+        printf("skipped: %s has %.1f GiB free, need %.1f GiB (try -d or a smaller -s)\n", dir,
+               (double)vfs.f_bavail * vfs.f_frsize / (1 << 30), (double)(size + add) / (1 << 30));
+        return 0;
+    }
+
+    printf("=== Checkpointed report reading: %.2f GiB report, %.2f MiB appended (%s) ===\n\n",
+           (double)size / (1 << 30), (double)add / (1 << 20), dir);
+    unlink(path);
+    unlink(ckpt);
+    uint64_t t0 = timing_now_ns();
+    if (append_bytes(path, size, 0) != 0) { perror(path); return 1; }
+    printf("wrote report in %.1f s\n\n", (double)(timing_now_ns() - t0) / 1e9);
+
+    tally_t t1, t2, t3;
+    ckpt_state_t st;
+    printf("%-26s %11s %12s %10s  %s\n", "run", "ms", "lines", "reports", "checkpoint");
+    double ms = run(path, ckpt, 1, &t1, &st);
+    printf("%-26s %11.1f %12llu %10llu  %s\n", "first run", ms, (unsigned long long)t1.lines,
+           (unsigned long long)t1.reports, ckpt_state_name(st));
+
+    if (append_bytes(path, add, 7) != 0) { perror(path); return 1; }
+    double full = run(path, ckpt, 0, &t2, &st);
+    printf("%-26s %11.1f %12llu %10llu  %s\n", "after append: full rescan", full,
+           (unsigned long long)t2.lines, (unsigned long long)t2.reports, "(ignored)");
+    double resumed = run(path, ckpt, 1, &t3, &st);
+    printf("%-26s %11.3f %12llu %10llu  %s\n", "after append: resumed", resumed,
+           (unsigned long long)t3.lines, (unsigned long long)t3.reports, ckpt_state_name(st));
+
+    int ok = st == CKPT_RESUMED && t3.lines == t2.lines - t1.lines && t3.reports == t2.reports - t1.reports;
+    printf("%s resumed run saw exactly the appended lines; %.0fx faster than a rescan\n",
+           ok ? "✅" : "❌", full / resumed);
+    unlink(path);
+    unlink(ckpt);
+
+    printf("\nfallbacks (small file):\n");
+    ok &= detection_checks(dir);
+
+    printf("\nTakeaway:\n");
+    printf("  • A byte offset plus a checksum of the bytes just before it is enough to\n"
+           "    resume safely: re-run cost follows the appended bytes, not the file size.\n");
+    printf("  • Never trust the offset alone: truncate, rewrite and rotate all leave a\n"
+           "    plausible-looking file behind.\n\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+// crc32c_bench.c
+// Recitation extension: what CRC32C checksums cost io_demo's reports
+//
+// Build:  make crc32c_bench
+// Run:    ./crc32c_bench                (256 MiB report file in /tmp)
+//         ./crc32c_bench -s 1G -d /some/disk
+//
+// 1. Every kernel in common/crc32c.h against the slicing-by-8 table on
+//    random lengths, offsets and split points (plus the standard check value).
+// 2. Raw GB/s per kernel: one crc32 chain vs three interleaved chains vs the
+//    table, from 64 B (one record line) to 16 MiB.
+// 3. The report path with checksums off and on: writing -s bytes of REPORT
+//    records (per-record crc32c= lines + running file CRC + footer), then
+//    Part 5's fgets read-back with and without rsum_verify_feed.
+
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/crc32c.h"
+#include "../common/timing.h"
+#include "reportsum.h"
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* -------------------------------- Kernels -------------------------------- */
+static int check_kernels(void) {
+    static unsigned char buf[1 << 16];
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (unsigned char)rnd();
+    int ok = 1;
+    for (size_t k = 0; k < CRC32C_NIMPLS; k++) {
+        if (!crc32c_supported_(k)) continue;
+        const crc32c_impl_t *im = &crc32c_impls_[k];
+        int good = im->fn(0, "123456789", 9) == 0xE3069283u;
+        for (int r = 0; r < 20000 && good; r++) {
+            size_t off = (size_t)(rnd() % 64), len = (size_t)(rnd() % (sizeof(buf) - 64));
+            size_t cut = len ? (size_t)(rnd() % len) : 0;
+            uint32_t seed = (uint32_t)rnd();
+            uint32_t want = crc32c_scalar_(seed, buf + off, len);
+            good = im->fn(seed, buf + off, len) == want &&
+                   im->fn(im->fn(seed, buf + off, cut), buf + off + cut, len - cut) == want;
+        }
+        printf("%s %-8s agrees with the table kernel (check value, random splits)\n",
+               good ? "✅" : "❌", im->name);
+        ok &= good;
+    }
+    return ok;
+}
+
+static void kernel_speed(void) {
+    static const size_t sizes[] = { 64, 1024, 64 << 10, 16 << 20 };
+    unsigned char *buf = malloc(16 << 20);
+    if (!buf) { perror("malloc"); exit(1); }
+    for (size_t i = 0; i < (16u << 20); i++) buf[i] = (unsigned char)rnd();
+    printf("\n%-10s", "GB/s");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        char label[16];
+        snprintf(label, sizeof(label), sizes[s] >= (1 << 20) ? "%zu MiB" : sizes[s] >= 1024 ? "%zu KiB" : "%zu B",
+                 sizes[s] >= (1 << 20) ? sizes[s] >> 20 : sizes[s] >= 1024 ? sizes[s] >> 10 : sizes[s]);
+        printf(" %9s", label);
+    }
+    printf("\n");
+    for (size_t k = 0; k < CRC32C_NIMPLS; k++) {
+        if (!crc32c_supported_(k)) continue;
+        const crc32c_impl_t *im = &crc32c_impls_[k];
+        printf("%-10s", im->name);
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            size_t n = sizes[s], iters = (256u << 20) / n;
+            uint32_t c = 0;
+            uint64_t t0 = timing_now_ns();
+            for (size_t i = 0; i < iters; i++) c = im->fn(c, buf, n);
+            double ns = (double)(timing_now_ns() - t0);
+            printf(" %9.2f", (double)n * (double)iters / ns + (c == 42 ? 1e-9 : 0.0));
+        }
+        printf("\n");
+    }
+    free(buf);
+}
+
+/* ------------------------------ Report path ------------------------------ */
+// One REPORT body like io_demo's, "REPORT\n" through the last field line.
+static int make_body(char *out, size_t cap, unsigned r) {
+    return snprintf(out, cap,
+                    "REPORT\nargv_count=2\nargv[0]=./io_demo\nargv[1]=output.txt\nline_tokens=4\n"
+                    "token[0]=GET\ntoken[1]=/api/v%u\ntoken[2]=%u.%03u\ntoken[3]=200\n"
+                    "numeric_tokens=1\nsum=200\nfloat_tokens=1\nfloat_sum=%u.%03u\n"
+                    "distinct_tokens=4\ntop_token=GET x1\n", r % 7, r % 900, r % 1000, r % 900, r % 1000);
+}
+
+static int put_crc_line(char *out, uint32_t crc) {
+    memcpy(out, "crc32c=", 7);
+    for (int i = 0; i < 8; i++) out[7 + i] = "0123456789abcdef"[(crc >> (28 - 4 * i)) & 0xF];
+    out[15] = '\n';
+    return 16;
+}
+
+// Write `size` bytes of records to path; returns seconds.
+static double write_reports(const char *path, size_t size, int checksums) {
+    static char chunk[1 << 20];
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { perror(path); exit(1); }
+    uint64_t t0 = timing_now_ns();
+    uint32_t fcrc = 0;
+    uint64_t total = 0;
+    size_t used = 0;
+    for (unsigned r = 0; total + used < size; r++) {
+        if (used + 1024 > sizeof(chunk)) {
+            if (checksums) fcrc = crc32c(fcrc, chunk, used);
+            if (write(fd, chunk, used) != (ssize_t)used) { perror("write"); exit(1); }
+            total += used;
+            used = 0;
+        }
+        int n = make_body(chunk + used, 1024, r);
+        if (checksums) n += put_crc_line(chunk + used + n, crc32c(0, chunk + used, (size_t)n));
+        memcpy(chunk + used + n, "---- END REPORT ----\n", 21);
+        used += (size_t)n + 21;
+    }
+    if (checksums) {
+        fcrc = crc32c(fcrc, chunk, used);
+        used += (size_t)sprintf(chunk + used, "FOOTER crc32c=%08x bytes=%020llu\n", fcrc,
+                                (unsigned long long)(total + used));
+    }
+    if (write(fd, chunk, used) != (ssize_t)used) { perror("write"); exit(1); }
+    close(fd);
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+static uint64_t read_bytes, read_lines;
+
+// Part 5's loop over the whole file; returns seconds.
+static double read_reports(const char *path, int verify, rsum_verify_t *v) {
+    FILE *in = fopen(path, "r");
+    if (!in) { perror(path); exit(1); }
+    char buf[256];
+    rsum_verify_init(v, 0, 0);
+    read_bytes = read_lines = 0;
+    uint64_t t0 = timing_now_ns();
+    while (fgets(buf, sizeof(buf), in)) {
+        size_t n = strlen(buf);                 // Part 5 needs it for the checkpoint too
+        if (verify) rsum_verify_feed(v, buf, n);
+        read_bytes += n;
+        read_lines++;
+    }
+    double s = (double)(timing_now_ns() - t0) / 1e9;
+    fclose(in);
+    return s;
+}
+
+int main(int argc, char **argv) {
+    size_t size = 256u << 20;
+    const char *dir = "/tmp";
+    int opt;
+    while ((opt = getopt(argc, argv, "s:d:")) != -1) {
+        switch (opt) {
+            case 's': size = parse_size(optarg); break;
+            case 'd': dir = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-s report_bytes] [-d dir]\n", argv[0]);
+                return 2;
+        }
+    }
+    printf("=== CRC32C for reports: kernels");
+    for (size_t k = 0; k < CRC32C_NIMPLS; k++)
+        if (crc32c_supported_(k)) printf(" %s", crc32c_impls_[k].name);
+    printf(" (default %s) ===\n\n", crc32c_isa());
+
+    int ok = check_kernels();
+    kernel_speed();
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/crc32c_reports.txt", dir);
+    double mib = (double)size / (1 << 20);
+    printf("\nreport file, %.0f MiB           %8s %8s\n", mib, "off", "on");
+    double w_off = write_reports(path, size, 0);
+    double w_on = write_reports(path, size, 1);
+    printf("write (records + footer) GB/s   %8.2f %8.2f\n", (double)size / w_off / 1e9, (double)size / w_on / 1e9);
+    rsum_verify_t v;
+    read_reports(path, 0, &v);                  // warm the page cache
+    double r_off = read_reports(path, 0, &v);
+    double r_on = read_reports(path, 1, &v);
+    printf("Part 5 fgets read-back GB/s     %8.2f %8.2f\n", (double)size / r_off / 1e9, (double)size / r_on / 1e9);
+    printf("verify: %.1f ns per line (%.0f-byte lines on average), read-back throughput %.0f%% lower\n",
+           (r_on - r_off) * 1e9 / (double)read_lines, (double)read_bytes / (double)read_lines,
+           100.0 * (1.0 - r_off / r_on));
+    int verified = v.records_bad == 0 && v.records_unchecked == 0 && v.footer == 1 && v.records_ok > 0;
+    printf("%s %llu reports verified, footer %s\n", verified ? "✅" : "❌",
+           (unsigned long long)v.records_ok, v.footer == 1 ? "ok" : "bad");
+    ok &= verified;
+
+    // Flip one bit in a token half way through: exactly that report and the
+    // footer must fail.
+    int fd = open(path, O_RDWR);
+    char win[4097] = { 0 };
+    off_t mid = (off_t)(size / 2);
+    if (fd < 0 || pread(fd, win, sizeof(win) - 1, mid) <= 0) { perror(path); return 1; }
+    char *tok = strstr(win, "token[1]=");
+    if (!tok) { fprintf(stderr, "no token line near the middle\n"); return 1; }
+    off_t at = mid + (tok - win) + 10;
+    win[tok - win + 10] ^= 0x01;
+    if (pwrite(fd, &win[tok - win + 10], 1, at) != 1) { perror(path); return 1; }
+    close(fd);
+    read_reports(path, 1, &v);
+    int caught = v.records_bad == 1 && v.footer == -1;
+    printf("%s one flipped byte: %llu report(s) bad, footer %s\n", caught ? "✅" : "❌",
+           (unsigned long long)v.records_bad, v.footer == -1 ? "mismatch" : "ok?!");
+    ok &= caught;
+    unlink(path);
+
+    printf("\nTakeaway:\n");
+    printf("  • Three interleaved crc32 chains keep the CRC unit busy every cycle; one\n"
+           "    chain waits on its own 3-cycle latency.\n");
+    printf("  • Report lines average %.0f bytes, far below where kernel speed matters:\n"
+           "    the cost is per line (a call, a short CRC, a few compares), not per byte.\n",
+           (double)read_bytes / (double)read_lines);
+    printf("  • Verifying where fgets left the bytes, with one CRC call per line and the\n"
+           "    record CRC derived at its boundary, still took %.0f%% of Part 5's read-back\n"
+           "    throughput here: cheap per byte, not free per line.\n\n", 100.0 * (1.0 - r_off / r_on));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// fmt_bench.c
+// Recitation extension: Part 6's tag/path building, snprintf vs common/fmt.h
+//
+// Build:  make fmt_bench
+// Run:    ./fmt_bench                       (10M constructions per shape)
+//         ./fmt_bench -n 100M
+//
+// Four shapes from io_demo Part 6 and w5's fn_bounds, built from a pool of
+// random labels (1-20 chars, so some of them truncate):
+//     tag      "TAG:%s"                  into char[20]
+//     path     "tmp/%s.txt"              into char[24]
+//     banner   "[%s:%s]"                 into char[24]
+//     numbered "logs/%s/part-%llu.%lld"  into char[48] (integers: digit pairs)
+// 1. Every shape, every label and a spread of integers (0, 9, 10, 99, ...,
+//    INT64_MIN, UINT64_MAX) at every capacity from 1 up: fmt must produce the
+//    same bytes and the same return value as snprintf.
+// 2. -n constructions per shape with each: ns per call and speedup.
+
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/fmt.h"
+#include "../common/timing.h"
+
+#define LABELS 4096
+
+static uint64_t rng = 0x452821E638D01377ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_count(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1e3; break;
+        case 'm': case 'M': v *= 1e6; break;
+        case 'g': case 'G': v *= 1e9; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+static char labels[LABELS][21];
+
+/* --------------------------------- Shapes --------------------------------- */
+// Each shape twice, same signature: (buf, cap, label, a, b) -> wanted length.
+typedef size_t (*shape_fn)(char *buf, size_t cap, const char *label, uint64_t u, int64_t i);
+
+static size_t tag_snprintf(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)u, (void)i;
+    return (size_t)snprintf(buf, cap, "TAG:%s", label);
+}
+static size_t tag_fmt(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)u, (void)i;
+    fmt_t f = fmt_begin(buf, cap);
+    fmt_lit(&f, "TAG:");
+    fmt_str(&f, label);
+    return fmt_end(&f);
+}
+
+static size_t path_snprintf(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)u, (void)i;
+    return (size_t)snprintf(buf, cap, "tmp/%s.txt", label);
+}
+static size_t path_fmt(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)u, (void)i;
+    fmt_t f = fmt_begin(buf, cap);
+    fmt_lit(&f, "tmp/");
+    fmt_str(&f, label);
+    fmt_lit(&f, ".txt");
+    return fmt_end(&f);
+}
+
+static size_t banner_snprintf(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)i;
+    return (size_t)snprintf(buf, cap, "[%s:%s]", label, labels[u % LABELS]);
+}
+static size_t banner_fmt(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    (void)i;
+    fmt_t f = fmt_begin(buf, cap);
+    fmt_char(&f, '[');
+    fmt_str(&f, label);
+    fmt_char(&f, ':');
+    fmt_str(&f, labels[u % LABELS]);
+    fmt_char(&f, ']');
+    return fmt_end(&f);
+}
+
+static size_t num_snprintf(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    return (size_t)snprintf(buf, cap, "logs/%s/part-%" PRIu64 ".%" PRId64, label, u, i);
+}
+static size_t num_fmt(char *buf, size_t cap, const char *label, uint64_t u, int64_t i) {
+    fmt_t f = fmt_begin(buf, cap);
+    fmt_lit(&f, "logs/");
+    fmt_str(&f, label);
+    fmt_lit(&f, "/part-");
+    fmt_u64(&f, u);
+    fmt_char(&f, '.');
+    fmt_i64(&f, i);
+    return fmt_end(&f);
+}
+
+typedef struct {
+    const char *name;
+    size_t cap;                 // the buffer the demos use
+    shape_fn ref, fast;
+} shape_t;
+
+static const shape_t shapes[] = {
+    { "tag", 20, tag_snprintf, tag_fmt },
+    { "path", 24, path_snprintf, path_fmt },
+    { "banner", 24, banner_snprintf, banner_fmt },
+    { "numbered", 48, num_snprintf, num_fmt },
+};
+#define SHAPES (sizeof(shapes) / sizeof(shapes[0]))
+
+/* ---------------------------------- Check --------------------------------- */
+static int check(const shape_t *s) {
+    static const uint64_t us[] = { 0, 9, 10, 99, 100, 999, 1000, 12345678, 4294967296ull, UINT64_MAX };
+    static const int64_t is[] = { 0, -1, 7, -10, 99, -100, 1000000, INT64_MAX, INT64_MIN };
+    char a[80], b[80];
+    size_t bad = 0;
+    for (size_t l = 0; l < 64; l++) {
+        for (size_t x = 0; x < sizeof(us) / sizeof(us[0]); x++) {
+            for (size_t y = 0; y < sizeof(is) / sizeof(is[0]); y++) {
+                for (size_t cap = 1; cap <= sizeof(a); cap++) {
+                    memset(a, 'x', sizeof(a));
+                    memset(b, 'x', sizeof(b));
+                    size_t na = s->fast(a, cap, labels[l], us[x], is[y]);
+                    size_t nb = s->ref(b, cap, labels[l], us[x], is[y]);
+                    if (na != nb || memcmp(a, b, sizeof(a)) != 0) bad++;
+                }
+            }
+        }
+    }
+    return bad == 0;
+}
+
+/* ---------------------------------- Time ---------------------------------- */
+static double run(shape_fn fn, size_t cap, size_t n, uint64_t *sink, size_t *truncated) {
+    char buf[64];
+    uint64_t acc = 0;
+    size_t trunc = 0;
+    uint64_t t0 = timing_now_ns();
+    for (size_t k = 0; k < n; k++) {
+        size_t need = fn(buf, cap, labels[k % LABELS], k * 2654435761u, (int64_t)(k ^ 0x5555) - 50000);
+        trunc += need >= cap;
+        acc += (unsigned char)buf[need < cap ? need / 2 : cap / 2];
+    }
+    double s = (double)(timing_now_ns() - t0) / 1e9;
+    *sink += acc;
+    *truncated = trunc;
+    return s;
+}
+
+int main(int argc, char **argv) {
+    size_t n = 10000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': n = parse_count(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n constructions]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n < 1) return 2;
+    for (size_t l = 0; l < LABELS; l++) {
+        size_t len = 1 + rnd() % 20;
+        for (size_t c = 0; c < len; c++) labels[l][c] = (char)('a' + rnd() % 26);
+        labels[l][len] = '\0';
+    }
+    printf("=== Bounded formatting: %zu constructions per shape ===\n\n", n);
+
+    int ok = 1;
+    for (size_t s = 0; s < SHAPES; s++) {
+        int same = check(&shapes[s]);
+        ok &= same;
+        printf("check %-9s every capacity 1..80 vs snprintf  %s\n", shapes[s].name,
+               same ? "✅ identical" : "❌ differs");
+    }
+
+    printf("\n%-9s %5s %10s %12s %12s %9s\n", "shape", "cap", "truncated", "snprintf ns", "fmt ns", "speedup");
+    uint64_t sink = 0;
+    for (size_t s = 0; s < SHAPES; s++) {
+        size_t tr_ref, tr_fast;
+        double s_ref = run(shapes[s].ref, shapes[s].cap, n, &sink, &tr_ref);
+        double s_fast = run(shapes[s].fast, shapes[s].cap, n, &sink, &tr_fast);
+        ok &= tr_ref == tr_fast;
+        printf("%-9s %5zu %9.1f%% %12.1f %12.1f %8.2fx%s\n", shapes[s].name, shapes[s].cap,
+               100.0 * (double)tr_fast / (double)n, s_ref * 1e9 / (double)n, s_fast * 1e9 / (double)n,
+               s_ref / s_fast, tr_ref == tr_fast ? "" : " ❌ truncation counts differ");
+    }
+    printf("(checksum %llu)\n", (unsigned long long)(sink & 0xFFFF));
+
+    printf("\nTakeaway:\n");
+    printf("  • snprintf parses its format string on every call, through varargs and the\n"
+           "    locale-aware stdio machinery, to copy a few bytes into a tiny buffer.\n");
+    printf("  • Typed pieces do only the copying; integers take one division per two\n"
+           "    digits. Truncation is still reported with the same return value.\n");
+    printf("  • Constant maximum widths let FMT_FITS prove at compile time that a buffer\n"
+           "    is big enough, so the truncation branch becomes dead code.\n\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+// fparse.c
+// Strict float token parsing: Clinger fast path, Eisel-Lemire, strtod fallback.
+// See fparse.h; used by io_demo.c (Part 3) and fparse_bench.c.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fparse.h"
+
+_Thread_local fparse_stats_t fparse_stats;
+
+/* ======================= 128-bit powers of five ========================== */
+// T[q] for q in [-342, 308]: 5^q scaled by a power of two so bit 127 is the
+// leading one, truncated to 128 bits (for q < 0, floor(2^b / 5^-q) + 1, the
+// same rule as the published Eisel-Lemire tables). Generated once, exactly,
+// with a small bignum instead of shipping 1302 magic constants.
+#define POW5_MIN (-342)
+#define POW5_MAX 308
+static uint64_t pow5_[2 * (POW5_MAX - POW5_MIN + 1)];    // {high, low} per q
+static pthread_once_t pow5_once_ = PTHREAD_ONCE_INIT;
+
+#define BN_WORDS 64             // 2048 bits: room for 2^1984 and 5^342
+#define BN_K     1984           // numerator exponent for the reciprocals
+
+typedef struct { uint32_t w[BN_WORDS]; } bn_t;
+
+static int bn_bitlen_(const bn_t *a) {
+    for (int i = BN_WORDS - 1; i >= 0; i--)
+        if (a->w[i]) return i * 32 + 32 - __builtin_clz(a->w[i]);
+    return 0;
+}
+
+static void bn_mul_small_(bn_t *a, uint32_t m) {
+    uint64_t carry = 0;
+    for (int i = 0; i < BN_WORDS; i++) {
+        uint64_t v = (uint64_t)a->w[i] * m + carry;
+        a->w[i] = (uint32_t)v;
+        carry = v >> 32;
+    }
+}
+
+static void bn_div_small_(bn_t *a, uint32_t d) {
+    uint64_t rem = 0;
+    for (int i = BN_WORDS - 1; i >= 0; i--) {
+        uint64_t cur = (rem << 32) | a->w[i];
+        a->w[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+}
+
+static void bn_shr_(bn_t *a, int s) {
+    bn_t r = { { 0 } };
+    for (int i = 0; i < BN_WORDS; i++) {
+        int src = i + s / 32;
+        if (src >= BN_WORDS) break;
+        uint64_t v = a->w[src] >> (s % 32);
+        if (s % 32 && src + 1 < BN_WORDS) v |= (uint64_t)a->w[src + 1] << (32 - s % 32);
+        r.w[i] = (uint32_t)v;
+    }
+    *a = r;
+}
+
+static void bn_add1_(bn_t *a) {
+    for (int i = 0; i < BN_WORDS && ++a->w[i] == 0; i++) {}
+}
+
+// Bits [from, from + 64) of a; bits below 0 read as zero.
+static uint64_t bn_bits64_(const bn_t *a, int from) {
+    uint64_t r = 0;
+    for (int b = 0; b < 64; b++) {
+        int i = from + b;
+        if (i >= 0 && i < BN_WORDS * 32 && (a->w[i / 32] >> (i % 32) & 1)) r |= 1ull << b;
+    }
+    return r;
+}
+
+// Store the top 128 bits of a (left-aligned if it is shorter) as T[q].
+static void pow5_store_(int q, const bn_t *a) {
+    int from = bn_bitlen_(a) - 128;
+    pow5_[2 * (q - POW5_MIN)] = bn_bits64_(a, from + 64);
+    pow5_[2 * (q - POW5_MIN) + 1] = bn_bits64_(a, from);
+}
+
+static void pow5_init_(void) {
+    bn_t p = { { 1 } };                         // 5^q
+    for (int q = 0; q <= POW5_MAX; q++) {
+        pow5_store_(q, &p);
+        bn_mul_small_(&p, 5);
+    }
+    bn_t y = { { 0 } };                         // floor(2^K / 5^n)
+    y.w[BN_K / 32] = 1u << (BN_K % 32);
+    p = (bn_t){ { 1 } };
+    for (int n = 1; n <= -POW5_MIN; n++) {
+        bn_div_small_(&y, 5);
+        bn_mul_small_(&p, 5);
+        int z = bn_bitlen_(&p);                 // 2^(z-1) < 5^n < 2^z
+        int b = n <= 27 ? z + 127 : 2 * z + 128;
+        bn_t x = y;
+        bn_shr_(&x, BN_K - b);                  // floor(2^b / 5^n)
+        bn_add1_(&x);
+        pow5_store_(-n, &x);
+    }
+}
+
+/* ============================= Eisel-Lemire ============================== */
+// w * 10^q for w != 0, q in [POW5_MIN, POW5_MAX]. Returns false when the
+// truncated table entry leaves the rounding undecided, or the result is
+// subnormal; the caller then falls back to strtod.
+static bool eisel_lemire_(uint64_t w, int q, uint64_t *bits) {
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+    const uint64_t *t = &pow5_[2 * (q - POW5_MIN)];
+    __uint128_t first = (__uint128_t)w * t[0];
+    uint64_t hi = (uint64_t)(first >> 64), lo = (uint64_t)first;
+    if ((hi & 0x1FF) == 0x1FF) {                // low 9 bits all ones: carry may matter
+        uint64_t second_hi = (uint64_t)(((__uint128_t)w * t[1]) >> 64);
+        lo += second_hi;
+        if (second_hi > lo) hi++;
+    }
+    // Still all ones: the true product could round either way.
+    if (lo == UINT64_MAX && (q < -27 || q > 55)) return false;
+
+    int upper = (int)(hi >> 63);
+    int shift = upper + 64 - 52 - 3;
+    uint64_t m = hi >> shift;
+    // floor(log2(10^q)) + 63, as a fixed-point multiply.
+    int p2 = (((152170 + 65536) * q) >> 16) + 63 + upper - lz + 1023;
+    if (p2 <= 0) return false;                  // subnormal: leave it to strtod
+
+    // Exactly halfway between two doubles can only happen for small q;
+    // round to even there instead of up.
+    if (lo <= 1 && q >= -4 && q <= 23 && (m & 3) == 1 && (m << shift) == hi) m &= ~1ull;
+    m += m & 1;
+    m >>= 1;
+    if (m >= (2ull << 52)) { m = 1ull << 52; p2++; }
+    m &= ~(1ull << 52);
+    if (p2 >= 0x7FF) { p2 = 0x7FF; m = 0; }     // overflow to infinity
+    *bits = m | (uint64_t)p2 << 52;
+    return true;
+}
+
+/* ================================ Parsing ================================ */
+static const double exact_pow10_[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static double fallback_(const char *s, size_t len) {
+    char small[128], *buf = len < sizeof(small) ? small : malloc(len + 1);
+    if (!buf) return 0.0;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    double d = strtod(buf, NULL);
+    if (buf != small) free(buf);
+    fparse_stats.fallback++;
+    return d;
+}
+
+bool fparse_strict(const char *s, size_t len, double *out) {
+    const char *p = s, *end = s + len;
+    bool neg = false, any = false, inexact = false;
+    if (p < end && (*p == '+' || *p == '-')) neg = *p++ == '-';
+
+    // Up to 19 significant digits fit in w; later ones only move the exponent.
+    uint64_t w = 0;
+    int nd = 0;
+    int64_t q = 0;
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++) {
+        any = true;
+        if (nd < 19) { w = w * 10 + (uint64_t)(*p - '0'); nd += w != 0; }
+        else { q++; inexact |= *p != '0'; }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned)(*p - '0') <= 9; p++) {
+            any = true;
+            if (nd < 19) { w = w * 10 + (uint64_t)(*p - '0'); nd += w != 0; q--; }
+            else inexact |= *p != '0';
+        }
+    }
+    if (!any) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        bool eneg = false;
+        if (++p < end && (*p == '+' || *p == '-')) eneg = *p++ == '-';
+        const char *edigits = p;
+        int64_t e = 0;
+        for (; p < end && (unsigned)(*p - '0') <= 9; p++)
+            if (e < 100000) e = e * 10 + (*p - '0');
+        if (p == edigits) return false;         // "1e" / "1e+" with no digits
+        q += eneg ? -e : e;
+    }
+    if (p != end) return false;
+
+    if (inexact) { *out = fallback_(s, len); return true; }
+    if (w == 0 || q < POW5_MIN) { *out = neg ? -0.0 : 0.0; return true; }
+    if (q > POW5_MAX) { *out = neg ? -HUGE_VAL : HUGE_VAL; return true; }
+
+    // Clinger: both operands exact, so one IEEE operation rounds correctly.
+    if (w <= (1ull << 53) && q >= -22 && q <= 22) {
+        double d = (double)w;
+        d = q < 0 ? d / exact_pow10_[-q] : d * exact_pow10_[q];
+        *out = neg ? -d : d;
+        fparse_stats.clinger++;
+        return true;
+    }
+
+    pthread_once(&pow5_once_, pow5_init_);      // batch workers may race to the first call
+    uint64_t bits;
+    if (!eisel_lemire_(w, (int)q, &bits)) { *out = fallback_(s, len); return true; }
+    bits |= (uint64_t)neg << 63;
+    memcpy(out, &bits, sizeof(*out));
+    fparse_stats.eisel_lemire++;
+    return true;
+}
@@ -0,0 +1,49 @@
+// fparse.h
+// Strict decimal float tokens for io_demo Part 3 and fparse_bench.
+//
+// fparse_strict(s, len, &d) accepts exactly
+//     [+-]? digits [. digits]? ([eE] [+-]? digits)?     ("12.375", "-1e-3", ".5", "5.")
+// and nothing else: no spaces, no "inf"/"nan", no hex floats (strtod takes
+// all of those, which is not what "looks like a latency" means). The value
+// is bit-identical to strtod's:
+//   1. Clinger's fast path: <= 2^53 significand and |exponent| <= 22, so
+//      one exact double multiply/divide is correctly rounded.
+//   2. Eisel-Lemire: multiply the 64-bit significand by a 128-bit
+//      truncated power of five and round from the high bits; it can tell
+//      when the truncation might have changed the answer.
+//   3. strtod for those cases, more than 19 significant digits, and
+//      subnormal results.
+//
+// fsum_t adds doubles with Neumaier's compensation (Kahan's algorithm,
+// also correct when the next term is larger than the running sum).
+
+#ifndef W4_FPARSE_H
+#define W4_FPARSE_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+bool fparse_strict(const char *s, size_t len, double *out);
+
+// How many fparse_strict calls took each path (for the benchmark), per thread.
+typedef struct { uint64_t clinger, eisel_lemire, fallback; } fparse_stats_t;
+extern _Thread_local fparse_stats_t fparse_stats;
+
+typedef struct {
+    double sum, comp;           // running sum and the low-order bits it lost
+    uint64_t n;
+} fsum_t;
+
+static inline void fsum_add(fsum_t *s, double x) {
+    double t = s->sum + x;
+    if (fabs(s->sum) >= fabs(x)) s->comp += (s->sum - t) + x;
+    else s->comp += (x - t) + s->sum;
+    s->sum = t;
+    s->n++;
+}
+
+static inline double fsum_value(const fsum_t *s) { return s->sum + s->comp; }
+
+#endif /* W4_FPARSE_H */
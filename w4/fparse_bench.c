@@ -0,0 +1,247 @@
+// fparse_bench.c
+// Recitation extension: strtod vs fparse_strict on float tokens (fparse.c)
+//
+// Build:  make fparse_bench
+// Run:    ./fparse_bench                  (100M tokens per mix, 1M distinct)
+//         ./fparse_bench -n 10M           (quicker)
+//         ./fparse_bench -f 50M           (only the bit-for-bit fuzz check)
+//
+// Mixes (each a buffer of -u distinct tokens, parsed round-robin until -n):
+//   latency   "12.375"-style: 0..10000 with 3 decimals (what io_demo logs)
+//   roundtrip %.17g of random finite doubles: 17 digits, any exponent
+//   sci       short scientific forms like "6.02e23" and "-1.5e-7"
+// Before timing, every distinct token is parsed by both and the doubles
+// compared bit for bit. Also shown: which path fparse took, and what
+// Neumaier summation buys over a plain running sum.
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "fparse.h"
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static uint64_t parse_count(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1e3; break;
+        case 'm': case 'M': v *= 1e6; break;
+        case 'g': case 'G': v *= 1e9; break;
+        default: break;
+    }
+    return (uint64_t)v;
+}
+
+static double rnd_double(void) {
+    for (;;) {
+        uint64_t bits = rnd();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (isfinite(d)) return d;
+    }
+}
+
+/* -------------------------------- Tokens -------------------------------- */
+// NUL-separated so strtod can read them in place; lengths for fparse.
+typedef struct {
+    char *buf;
+    size_t *off, *len, n, bytes;
+} toks_t;
+
+typedef enum { MIX_LATENCY, MIX_ROUNDTRIP, MIX_SCI, MIX_COUNT } mix_t;
+static const char *mix_name[] = { "latency", "roundtrip", "sci" };
+
+static int make_token(mix_t mix, char *out, size_t cap) {
+    switch (mix) {
+        case MIX_LATENCY:
+            return snprintf(out, cap, "%llu.%03llu", (unsigned long long)(rnd() % 10000),
+                            (unsigned long long)(rnd() % 1000));
+        case MIX_ROUNDTRIP:
+            return snprintf(out, cap, "%.17g", rnd_double());
+        default:
+            return snprintf(out, cap, "%s%llu.%llue%d", rnd() & 1 ? "-" : "",
+                            (unsigned long long)(rnd() % 10), (unsigned long long)(rnd() % 1000),
+                            (int)(rnd() % 60) - 30);
+    }
+}
+
+static toks_t make_tokens(mix_t mix, size_t n) {
+    toks_t t = { malloc(n * 32), malloc(n * sizeof(size_t)), malloc(n * sizeof(size_t)), n, 0 };
+    if (!t.buf || !t.off || !t.len) { perror("malloc"); exit(1); }
+    for (size_t i = 0; i < n; i++) {
+        int k = make_token(mix, t.buf + t.bytes, 32);
+        t.off[i] = t.bytes;
+        t.len[i] = (size_t)k;
+        t.bytes += (size_t)k + 1;
+    }
+    return t;
+}
+
+static void free_tokens(toks_t *t) {
+    free(t->buf);
+    free(t->off);
+    free(t->len);
+}
+
+/* ---------------------------- Equivalence ------------------------------- */
+// 0 if fparse_strict gives exactly strtod's bits for s; prints the first few misses.
+static int check_one(const char *s, size_t len) {
+    static int shown;
+    double a = strtod(s, NULL), b = 0.0;
+    bool ok = fparse_strict(s, len, &b);
+    if (ok && memcmp(&a, &b, sizeof(a)) == 0) return 0;
+    if (shown++ < 10) printf("  ❌ \"%s\": strtod %.17g, fparse %s%.17g\n", s, a, ok ? "" : "rejected ", b);
+    return 1;
+}
+
+static const char *hard_cases[] = {
+    "9007199254740993",             // 2^53 + 1: halfway, rounds to even
+    "9007199254740995",
+    "1.7976931348623157e308",       // DBL_MAX
+    "1.7976931348623158e308",       // still DBL_MAX
+    "1.7976931348623159e308",       // overflows
+    "2.2250738585072014e-308",      // DBL_MIN
+    "2.2250738585072011e-308",      // just below: subnormal
+    "4.9e-324", "2.4703282292062328e-324", "2e-324", "1e-400", "1e400",
+    "0.1", "0.30000000000000004", "123456789012345678901234567890",
+    "7.2057594037927933e16", "1448997445238699", "-0", "-0.0e10", "0e-999",
+    "0.000000000000000000000000000000000000000000001",
+    "3.0000000000000001", "5e-20", "1e23", "8.98846567431158e307",
+};
+
+static uint64_t fuzz(uint64_t n) {
+    uint64_t bad = 0;
+    char s[64];
+    for (size_t i = 0; i < sizeof(hard_cases) / sizeof(hard_cases[0]); i++)
+        bad += (uint64_t)check_one(hard_cases[i], strlen(hard_cases[i]));
+    for (uint64_t i = 0; i < n; i++) {
+        int k;
+        switch (rnd() % 4) {
+            case 0:                             // shortest-ish round trips
+                k = snprintf(s, sizeof(s), "%.*g", 1 + (int)(rnd() % 17), rnd_double());
+                break;
+            case 1: {                           // 17 digits, last one changed: near ties
+                k = snprintf(s, sizeof(s), "%.16e", rnd_double());
+                *(strchr(s, 'e') - 1) = (char)('0' + rnd() % 10);
+                break;
+            }
+            default: {                          // random digits, random exponent
+                int digits = 1 + (int)(rnd() % 19);
+                k = 0;
+                for (int j = 0; j < digits; j++) s[k++] = (char)('0' + rnd() % 10);
+                k += snprintf(s + k, sizeof(s) - (size_t)k, "e%d", (int)(rnd() % 700) - 360);
+                break;
+            }
+        }
+        bad += (uint64_t)check_one(s, (size_t)k);
+    }
+    return bad;
+}
+
+/* ------------------------------- Timing --------------------------------- */
+static double time_strtod(const toks_t *t, uint64_t n, double *sink) {
+    double acc = 0.0;
+    uint64_t t0 = timing_now_ns();
+    for (uint64_t i = 0, j = 0; i < n; i++, j = j + 1 == t->n ? 0 : j + 1)
+        acc += strtod(t->buf + t->off[j], NULL);
+    uint64_t ns = timing_now_ns() - t0;
+    *sink += acc;
+    return (double)ns;
+}
+
+static double time_fparse(const toks_t *t, uint64_t n, double *sink) {
+    double acc = 0.0, d;
+    uint64_t t0 = timing_now_ns();
+    for (uint64_t i = 0, j = 0; i < n; i++, j = j + 1 == t->n ? 0 : j + 1)
+        if (fparse_strict(t->buf + t->off[j], t->len[j], &d)) acc += d;
+    uint64_t ns = timing_now_ns() - t0;
+    *sink += acc;
+    return (double)ns;
+}
+
+/* ------------------------------ Summation ------------------------------- */
+static void summation_demo(void) {
+    printf("\nsummation (naive running sum vs fsum_t):\n");
+    double naive = 0.0;
+    fsum_t fs = { 0 };
+    double tenth;
+    fparse_strict("0.1", 3, &tenth);
+    for (int i = 0; i < 10000000; i++) { naive += tenth; fsum_add(&fs, tenth); }
+    printf("  10M x \"0.1\"          naive %-22.17g fsum %-22.17g (exact: 1000000.0000000000555)\n",
+           naive, fsum_value(&fs));
+    const double xs[] = { 1e16, 1.0, -1e16 };
+    naive = 0.0;
+    fs = (fsum_t){ 0 };
+    for (int i = 0; i < 3; i++) { naive += xs[i]; fsum_add(&fs, xs[i]); }
+    printf("  1e16 + 1 - 1e16      naive %-22.17g fsum %-22.17g (exact: 1)\n", naive, fsum_value(&fs));
+}
+
+int main(int argc, char **argv) {
+    uint64_t n = 100000000, fuzz_n = 0;
+    size_t uniq = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:u:f:")) != -1) {
+        switch (opt) {
+            case 'n': n = parse_count(optarg); break;
+            case 'u': uniq = (size_t)parse_count(optarg); break;
+            case 'f': fuzz_n = parse_count(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n tokens_per_mix] [-u distinct] [-f fuzz_cases]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (uniq == 0) uniq = 1;
+
+    if (fuzz_n) {
+        printf("=== fparse_strict vs strtod: %llu random strings + %zu hard cases ===\n",
+               (unsigned long long)fuzz_n, sizeof(hard_cases) / sizeof(hard_cases[0]));
+        fparse_stats = (fparse_stats_t){ 0 };
+        uint64_t bad = fuzz(fuzz_n);
+        printf("paths: %llu Clinger, %llu Eisel-Lemire, %llu strtod fallback\n",
+               (unsigned long long)fparse_stats.clinger, (unsigned long long)fparse_stats.eisel_lemire,
+               (unsigned long long)fparse_stats.fallback);
+        printf("%s %llu mismatches\n", bad ? "❌" : "✅", (unsigned long long)bad);
+        return bad ? 1 : 0;
+    }
+
+    printf("=== Float token parsing: %llu tokens per mix, %zu distinct ===\n\n",
+           (unsigned long long)n, uniq);
+    printf("%-10s %-7s %9s %9s %8s   %s\n", "mix", "parser", "ns/token", "MB/s", "speedup", "fparse paths");
+    uint64_t bad = fuzz(100000);                // hard cases + a quick random sweep
+    double sink = 0.0;
+    for (int m = 0; m < MIX_COUNT; m++) {
+        toks_t t = make_tokens((mix_t)m, uniq);
+        for (size_t i = 0; i < t.n; i++) bad += (uint64_t)check_one(t.buf + t.off[i], t.len[i]);
+        // Average token bytes over the n parses (the buffer is cycled).
+        double mb = (double)(t.bytes - t.n) / (double)t.n * (double)n / 1e6;
+        double ns_s = time_strtod(&t, n, &sink);
+        fparse_stats = (fparse_stats_t){ 0 };
+        double ns_f = time_fparse(&t, n, &sink);
+        printf("%-10s %-7s %9.1f %9.0f\n", mix_name[m], "strtod", ns_s / (double)n, mb / (ns_s / 1e9));
+        printf("%-10s %-7s %9.1f %9.0f %7.1fx   %.1f%% Clinger, %.1f%% E-L, %.2f%% fallback\n", "",
+               "fparse", ns_f / (double)n, mb / (ns_f / 1e9), ns_s / ns_f,
+               100.0 * (double)fparse_stats.clinger / (double)n,
+               100.0 * (double)fparse_stats.eisel_lemire / (double)n,
+               100.0 * (double)fparse_stats.fallback / (double)n);
+        free_tokens(&t);
+    }
+    printf("%s every distinct token parsed to strtod's exact bits (%llu mismatches)\n",
+           bad ? "❌" : "✅", (unsigned long long)bad);
+    if (sink == 42.0) puts("");                 // keep the loops observable
+    summation_demo();
+
+    printf("\nTakeaway:\n");
+    printf("  • strtod handles locales, hex, inf/nan and arbitrary length on every call;\n"
+           "    most real tokens need one 64x128-bit multiply to round correctly.\n");
+    printf("  • Correctness is kept by knowing when the fast path is unsure and asking\n"
+           "    strtod then, not by hoping the fast path is always right.\n\n");
+    return bad ? 1 : 0;
+}
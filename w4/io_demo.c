@@ -1,9 +1,28 @@
 // io_demo.c
 // Recitation: Practical Input/Output in C (argv, fgets, strtok, strtol, fopen/fprintf)
-// + Part 6: Bounds checking clinic
+// + Part 6: Bounds checking clinic (fgets + common/fmt.h, checked sizes)
+// Part 3 also aggregates the tokens (tokstats.c): top tokens, min/max/mean,
+// and parses float tokens like "12.375" (fparse.c) into a compensated sum.
+// Part 2 checks the line is valid UTF-8 (common/utf8.h, SIMD) before anything
+// is split or written; UTF8_POLICY=replace (default, U+FFFD) | reject | pass.
+// Part 5 resumes from <output_path>.ckpt (checkpoint.c): with -a, only the
+// newly appended report is read back. Every report carries a CRC32C and the
+// file a CRC32C footer (reportsum.c); Part 5 verifies both as it reads.
+// An output path ending in .lzb is written as 64 KiB LZ blocks (lzblock.c),
+// which Part 5 decompresses on all cores.
+// Directory mode (-d, batch.c) runs Parts 2-4 non-interactively on every
+// file under a tree, on -j worker threads, and merges a summary report.
+// Filter mode (-p, passthru.c) forwards stdin to a file or pipe unchanged,
+// with splice/tee when it can, and tokenizes a tee'd copy for the report.
+// TOKEN_ORDER=sorted lists the report's tokens sorted and unique, with
+// counts (toksort.c, radix sort); -p -u writes the same for a whole stream.
 //
-// Build:  gcc -O2 -Wall -Wextra -o io_demo io_demo.c
+// Build:  gcc -O2 -Wall -Wextra -pthread -o io_demo io_demo.c tokstats.c checkpoint.c fparse.c reportsum.c lzblock.c batch.c passthru.c toksort.c -lm
 // Run:    ./io_demo [output_path] [-a]
+//         ./io_demo reports.lzb -a
+//         ./io_demo -d logs/ [-j workers] [-o per_file_report_dir] [summary_path]
+//         producer | ./io_demo -p [-c] [-n] [-o output] [-u tokens.txt] [report_path] | consumer
+//         UTF8_POLICY=reject TOKEN_ORDER=sorted ./io_demo
 
 #define _POSIX_C_SOURCE 200809L
 #include <ctype.h>
@@ -12,23 +31,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../common/strslice.h"     // slice_t: chomp/trim/split without rescanning
+#include "../common/utf8.h"         // SIMD UTF-8 validation + U+FFFD replacement
+#include "../common/fmt.h"          // bounded formatting, no format string
+#include "tokstats.h"                // token counts + numeric statistics
+#include "fparse.h"                  // strict float tokens, bit-identical to strtod
+#include "checkpoint.h"              // resume Part 5 where the last run stopped
+#include "reportsum.h"               // per-report and per-file CRC32C
+#include "lzblock.h"                 // optional LZ block compression
+#include "batch.h"                   // directory mode: many files, many threads
+#include "passthru.h"                // filter mode: splice/tee passthrough
+#include "toksort.h"                 // sorted unique tokens with counts
+#include "../common/timing.h"
+#include "../common/crc32c.h"
 
 /* ---------------------------- Small utilities ---------------------------- */
 
-static void chomp_newline(char *s) {
-    size_t n = strlen(s);
-    if (n && s[n - 1] == '\n') s[n - 1] = '\0';
-}
-
-static void trim_spaces(char *s) {
-    size_t i = 0;
-    while (isspace((unsigned char)s[i])) i++;
-    if (i) memmove(s, s + i, strlen(s + i) + 1);
-
-    size_t n = strlen(s);
-    while (n && isspace((unsigned char)s[n - 1])) s[--n] = '\0';
-}
-
 static bool parse_int_strict(const char *token, long *out) {
     if (!token || !*token) return false;
     errno = 0;
@@ -42,6 +64,21 @@ static bool parse_int_strict(const char *token, long *out) {
     return true;
 }
 
+// Apply the UTF-8 policy to *ls, copying into clean[cap] if bytes must be
+// replaced. Returns false if the line is rejected.
+static bool apply_utf8_policy(slice_t *ls, char *clean, size_t cap, utf8_policy_t policy) {
+    if (policy == UTF8_PASS || utf8_valid(ls->ptr, ls->len)) return true;
+    if (policy == UTF8_REJECT) {
+        fprintf(stderr, "error: input is not valid UTF-8 (byte %zu)\n", utf8_error_at(ls->ptr, ls->len));
+        return false;
+    }
+    size_t bad = 0;
+    size_t n = utf8_replace(ls->ptr, ls->len, clean, cap - 1, &bad);    // room for slice_cstr's '\0'
+    fprintf(stderr, "[warn] replaced %zu invalid UTF-8 sequence%s with U+FFFD\n", bad, bad == 1 ? "" : "s");
+    *ls = (slice_t){ clean, n };
+    return true;
+}
+
 /* --------- Bounds helpers: input flushing & safe snprintf checks ---------- */
 
 // Flush the remainder of the current stdin line after a truncated fgets.
@@ -57,18 +94,6 @@ static void wait_for_enter(void) {
     while ((c = getchar()) != '\n' && c != EOF) { /* discard extra */ }
 }
 
-/* ---------------------------- File helpers ------------------------------- */
-
-static FILE* open_output(const char *path, bool append_mode) {
-    const char *mode = append_mode ? "a" : "w";
-    FILE *f = fopen(path, mode);
-    if (!f) {
-        fprintf(stderr, "error: cannot open '%s' (%s)\n", path, strerror(errno));
-        return NULL;
-    }
-    return f;
-}
-
 /* ---------------------------- Pretty printing ---------------------------- */
 
 static void show_argv(int argc, char **argv) {
@@ -80,11 +105,206 @@ static void show_argv(int argc, char **argv) {
     puts("");
 }
 
+/* ----------------------------- Directory mode ----------------------------- */
+
+static bool has_lzb_suffix(const char *path) {
+    size_t n = strlen(path);
+    return n > 4 && strcmp(path + n - 4, ".lzb") == 0;
+}
+
+// io_demo -d dir [-j workers] [-o report_dir] [summary_path]
+static int run_directory(int argc, char **argv) {
+    const char *dir = argv[2], *report_dir = NULL, *summary = "summary.txt";
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 0 ? (int)cpus : 1;
+    for (int i = 3; i < argc; i++) {
+        long v = 0;
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc && parse_int_strict(argv[i + 1], &v) && v > 0 && v <= 1024) {
+            workers = (int)v;
+            i++;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report_dir = argv[++i];
+        } else if (argv[i][0] != '-') {
+            summary = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s -d dir [-j workers] [-o report_dir] [summary_path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("=== Directory mode: %s ===\n", dir);
+    batch_list_t list = { 0 };
+    uint64_t skipped = 0;
+    uint64_t t0 = timing_now_ns();
+    if (batch_walk(dir, &list, &skipped) != 0) {
+        fprintf(stderr, "error: cannot walk '%s' (%s)\n", dir, strerror(errno));
+        batch_list_free(&list);
+        return 2;
+    }
+    double walk_s = (double)(timing_now_ns() - t0) / 1e9;
+    printf("Found %zu files (%.1f MiB) in %llu directories in %.1f ms%s\n", list.n,
+           (double)list.bytes / (1 << 20), (unsigned long long)list.dirs, walk_s * 1e3,
+           skipped ? " (some entries unreadable, skipped)" : "");
+
+    batch_result_t *results = calloc(list.n ? list.n : 1, sizeof(*results));
+    // Per-file reports are compressed when the summary is (a .lzb path).
+    batch_opts_t opts = { workers, report_dir, report_dir && has_lzb_suffix(summary) };
+    t0 = timing_now_ns();
+    if (!results || batch_run(&list, &opts, results) != 0) {
+        fprintf(stderr, "error: cannot start workers (%s)\n", strerror(errno));
+        free(results);
+        batch_list_free(&list);
+        return 2;
+    }
+    double run_s = (double)(timing_now_ns() - t0) / 1e9;
+    uint64_t failed = 0;
+    for (size_t i = 0; i < list.n; i++) {
+        if (!results[i].err) continue;
+        failed++;
+        fprintf(stderr, "[warn] %s: %s\n", list.files[i].path, strerror(results[i].err));
+    }
+    printf("Processed %zu files with %d worker%s in %.3f s: %.0f files/s, %.1f MB/s%s\n", list.n, workers,
+           workers == 1 ? "" : "s", run_s, (double)list.n / run_s, (double)list.bytes / run_s / 1e6,
+           report_dir ? " (per-file reports written)" : "");
+
+    int rc = 0;
+    if (batch_write_summary(summary, has_lzb_suffix(summary) ? RSUM_COMPRESS : 0, dir, &list, results) != 0) {
+        fprintf(stderr, "error: write failed for '%s' (%s)\n", summary, strerror(errno));
+        rc = 2;
+    } else {
+        printf("Wrote summary to %s (%llu file%s failed) %s\n", summary, (unsigned long long)failed,
+               failed == 1 ? "" : "s", failed ? "❌" : "✅");
+    }
+    free(results);
+    batch_list_free(&list);
+    return rc;
+}
+
+static double cpu_seconds(const struct timeval *tv) {
+    return (double)tv->tv_sec + (double)tv->tv_usec / 1e6;
+}
+
+// producer | io_demo -p [-c] [-n] [-o output] [-u tokens.txt] [report_path] | consumer
+// stdout carries the data, so everything io_demo has to say goes to stderr.
+static int run_passthrough(int argc, char **argv) {
+    const char *out_path = NULL, *report = NULL, *tokens_path = NULL;
+    pass_mode_t mode = PASS_SPLICE;
+    bool stats = true;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            mode = PASS_COPY;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            stats = false;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            tokens_path = argv[++i];
+        } else if (argv[i][0] != '-') {
+            report = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s -p [-c] [-n] [-o output] [-u tokens.txt] [report_path]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((report || tokens_path) && !stats) {
+        fprintf(stderr, "error: a report or token list needs statistics (drop -n)\n");
+        return 1;
+    }
+    if (isatty(STDIN_FILENO)) fprintf(stderr, "Reading stdin until EOF (Ctrl-D)...\n");
+
+    int out_fd = STDOUT_FILENO;
+    if (out_path && (out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0) {
+        fprintf(stderr, "error: cannot open '%s' (%s)\n", out_path, strerror(errno));
+        return 2;
+    }
+
+    // Sketch counts: a pipe can carry far more distinct tokens than fit in memory.
+    batch_result_t r;
+    batch_stream_t s;
+    if (stats && batch_stream_init(&s, &r, TOKSTATS_SKETCH) != 0) {
+        fprintf(stderr, "error: out of memory\n");
+        if (out_path) close(out_fd);
+        return 2;
+    }
+    toksort_t sorted = { 0 };
+    if (tokens_path) s.sorted = &sorted;
+    pass_mode_t used;
+    uint64_t t0 = timing_now_ns();
+    int64_t n = passthru_run(STDIN_FILENO, out_fd, mode, stats ? &s : NULL, &used);
+    int err = errno;
+    double secs = (double)(timing_now_ns() - t0) / 1e9;
+    if (stats && batch_stream_finish(&s) != 0 && n >= 0) {
+        n = -1;
+        err = ENOMEM;
+    }
+    if (out_path && close(out_fd) != 0 && n >= 0) {
+        n = -1;
+        err = errno;
+    }
+    if (n < 0) {
+        fprintf(stderr, "error: passthrough failed (%s)\n", strerror(err));
+        toksort_free(&sorted);
+        return 2;
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    fprintf(stderr, "Forwarded %lld bytes via %s in %.3f s: %.2f GB/s, CPU user %.3f s sys %.3f s\n",
+            (long long)n, passthru_mode_name(used), secs, secs > 0 ? (double)n / secs / 1e9 : 0.0,
+            cpu_seconds(&ru.ru_utime), cpu_seconds(&ru.ru_stime));
+    if (mode == PASS_SPLICE && used == PASS_COPY)
+        fprintf(stderr, "(stdin or the output cannot splice; copied instead)\n");
+    if (!stats) return 0;
+    fprintf(stderr, "Lines: %llu, tokens: %llu, integers: %llu (sum %lld), distinct ~%zu (HyperLogLog)\n",
+            (unsigned long long)r.lines, (unsigned long long)r.tokens, (unsigned long long)r.ints,
+            (long long)r.sum, r.distinct);
+    if (report) {
+        if (batch_write_result(report, has_lzb_suffix(report) ? RSUM_COMPRESS : 0, "stdin", &r) != 0) {
+            fprintf(stderr, "error: write failed for '%s' (%s)\n", report, strerror(errno));
+            return 2;
+        }
+        fprintf(stderr, "Wrote report to %s ✅\n", report);
+    }
+    if (tokens_path) {
+        size_t total = sorted.n;
+        t0 = timing_now_ns();
+        FILE *tf = NULL;
+        int rc = toksort_unique(&sorted);
+        if (rc == 0 && (tf = fopen(tokens_path, "w")) == NULL) rc = -1;
+        if (rc == 0) rc = toksort_write(&sorted, tf);
+        if (tf && fclose(tf) != 0) rc = -1;
+        if (rc != 0) {
+            fprintf(stderr, "error: cannot write tokens to '%s' (%s)\n", tokens_path, strerror(errno));
+            toksort_free(&sorted);
+            return 2;
+        }
+        fprintf(stderr, "Wrote %zu unique of %zu tokens to %s, sorted in %.3f s ✅\n", sorted.n, total,
+                tokens_path, (double)(timing_now_ns() - t0) / 1e9);
+        toksort_free(&sorted);
+    }
+    return 0;
+}
+
 /* ---------------------------- Main exercise ------------------------------ */
 
 int main(int argc, char **argv) {
     const char *out_path = "output.txt";
     bool append_mode = false;
+    const char *policy_name = getenv("UTF8_POLICY");
+    int utf8_policy = utf8_policy_parse(policy_name ? policy_name : "replace");
+    if (utf8_policy < 0) {
+        fprintf(stderr, "error: UTF8_POLICY must be reject, replace or pass\n");
+        return 1;
+    }
+    const char *order = getenv("TOKEN_ORDER");
+    bool sorted_tokens = order && strcmp(order, "sorted") == 0;
+    if (order && !sorted_tokens && strcmp(order, "input") != 0) {
+        fprintf(stderr, "error: TOKEN_ORDER must be input or sorted\n");
+        return 1;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "-d") == 0) return run_directory(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "-p") == 0) return run_passthrough(argc, argv);
 
     if (argc >= 2 && strcmp(argv[1], "-a") != 0) {
         out_path = argv[1];
@@ -108,30 +328,38 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Measure once; every step below works on (ptr, len) instead of rescanning.
+    slice_t ls = slice_from_cstr(line);
+
     // Detect truncation: if newline wasn't captured, input > sizeof(line)-1
-    bool truncated = (strchr(line, '\n') == NULL);
+    bool truncated = !(ls.len && ls.ptr[ls.len - 1] == '\n');
     if (truncated) {
         fprintf(stderr, "[warn] input longer than %zu chars; truncating & flushing\n",
                 sizeof(line) - 1);
         flush_stdin_line();
+        // A multi-byte character cut by the buffer is not an encoding error.
+        ls.len = utf8_complete_len(ls.ptr, ls.len);
     }
 
-    chomp_newline(line);
-    trim_spaces(line);
+    char clean[3 * sizeof(line)];           // worst case: every byte becomes U+FFFD
+    if (!apply_utf8_policy(&ls, clean, sizeof(clean), (utf8_policy_t)utf8_policy)) return 1;
+    ls = slice_trim(slice_chomp(ls));
 
-    printf("Raw line: \"%s\"%s\n", line, truncated ? "  (truncated)" : "");
+    printf("Raw line: \"%.*s\"%s\n", SLICE_FMT(ls), truncated ? "  (truncated)" : "");
 
-    // Tokenize by spaces (collapse consecutive delimiters)
+    // Tokenize by spaces (collapse consecutive delimiters, like strtok)
     int token_count = 0;
     char *tokens[64] = {0};
+    size_t token_len[64] = {0};
     {
-        char *save = NULL;
-        char *t = strtok_r(line, " ", &save);
-        while (t && token_count < (int)(sizeof(tokens)/sizeof(tokens[0]))) {
-            tokens[token_count++] = t;
-            t = strtok_r(NULL, " ", &save);
+        slice_t tok;
+        bool more = slice_split(&ls, ' ', &tok);
+        while (more && token_count < (int)(sizeof(tokens)/sizeof(tokens[0]))) {
+            token_len[token_count] = tok.len;
+            tokens[token_count++] = slice_cstr(tok);    // '\0' over the delimiter
+            more = slice_split(&ls, ' ', &tok);
         }
-        if (t != NULL) {
+        if (more) {
             fprintf(stderr, "[warn] too many tokens; kept first %zu\n",
                     sizeof(tokens)/sizeof(tokens[0]));
         }
@@ -148,12 +376,17 @@ int main(int argc, char **argv) {
     printf("=== Part 3: Detect integers among tokens using strtol ===\n");
     long sum = 0;
     int ints_found = 0;
+    fsum_t fsum = { 0 };
     for (int i = 0; i < token_count; i++) {
         long val = 0;
+        double d = 0.0;
         if (parse_int_strict(tokens[i], &val)) {
             printf("  numeric token: \"%s\" -> %ld\n", tokens[i], val);
             sum += val;
             ints_found++;
+        } else if (fparse_strict(tokens[i], token_len[i], &d)) {
+            printf("  float token: \"%s\" -> %.17g\n", tokens[i], d);
+            fsum_add(&fsum, d);
         } else {
             printf("  non-numeric token: \"%s\"\n", tokens[i]);
         }
@@ -163,6 +396,26 @@ int main(int argc, char **argv) {
     } else {
         printf("No numeric tokens found.\n");
     }
+    if (fsum.n > 0) {
+        printf("Sum of %llu float tokens = %.15g\n", (unsigned long long)fsum.n, fsum_value(&fsum));
+    }
+
+    // Streaming aggregation: the same code path tokstats_bench runs on GBs.
+    tokstats_t *stats = tokstats_new(TOKSTATS_EXACT, 0, 0);
+    if (!stats) {
+        fprintf(stderr, "error: out of memory for token stats\n");
+        return 1;
+    }
+    for (int i = 0; i < token_count; i++) {
+        tokstats_add(stats, tokens[i], token_len[i], NULL);
+    }
+    tokstat_t top[3];
+    size_t ntop = tokstats_top(stats, top, 3);
+    printf("Distinct tokens: %zu; most frequent:\n", tokstats_distinct(stats));
+    for (size_t i = 0; i < ntop; i++) {
+        printf("  \"%.*s\" x%llu\n", (int)top[i].len, top[i].key, (unsigned long long)top[i].count);
+    }
+    tokstats_print_numeric(stats, stdout);
     puts("");
     wait_for_enter();
 
@@ -170,28 +423,80 @@ int main(int argc, char **argv) {
     printf("=== Part 4: Write a report with fopen/fprintf/fclose ===\n");
     printf("Output path: %s (%s)\n", out_path, append_mode ? "append" : "write");
 
-    FILE *out = open_output(out_path, append_mode);
-    if (!out) return 2;
-
-    if (fprintf(out, "REPORT\n") < 0) {
-        fprintf(stderr, "error: write failed for '%s'\n", out_path);
-        fclose(out);
+    // Build the report in memory first: it is checksummed before it reaches the file.
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *out = open_memstream(&body, &body_len);
+    if (!out) {
+        fprintf(stderr, "error: cannot buffer the report (%s)\n", strerror(errno));
         return 2;
     }
+
+    fprintf(out, "REPORT\n");
     fprintf(out, "argv_count=%d\n", argc);
     for (int i = 0; i < argc; i++) {
         fprintf(out, "argv[%d]=%s\n", i, argv[i]);
     }
     fprintf(out, "line_tokens=%d\n", token_count);
-    for (int i = 0; i < token_count; i++) {
-        fprintf(out, "token[%d]=%s\n", i, tokens[i]);
+    toksort_t uniq = { 0 };
+    if (sorted_tokens) {
+        // Downstream wants `sort | uniq -c`: one token[i]= per distinct token.
+        for (int i = 0; i < token_count; i++) {
+            if (toksort_add(&uniq, tokens[i], token_len[i]) != 0) sorted_tokens = false;
+        }
+        if (!sorted_tokens || toksort_unique(&uniq) != 0) {
+            fprintf(stderr, "[warn] out of memory sorting tokens; listing them in input order\n");
+            sorted_tokens = false;
+        }
     }
+    if (sorted_tokens) {
+        fprintf(out, "token_order=sorted\nunique_tokens=%zu\n", uniq.n);
+        for (size_t i = 0; i < uniq.n; i++) {
+            fprintf(out, "token[%zu]=%s\ntoken_count[%zu]=%llu\n", i, uniq.keys[i], i,
+                    (unsigned long long)uniq.counts[i]);
+        }
+    } else {
+        for (int i = 0; i < token_count; i++) {
+            fprintf(out, "token[%d]=%s\n", i, tokens[i]);
+        }
+    }
+    toksort_free(&uniq);
     fprintf(out, "numeric_tokens=%d\n", ints_found);
     if (ints_found > 0) fprintf(out, "sum=%ld\n", sum);
-    fprintf(out, "---- END REPORT ----\n");
+    if (fsum.n > 0) {
+        fprintf(out, "float_tokens=%llu\nfloat_sum=%.17g\n",
+                (unsigned long long)fsum.n, fsum_value(&fsum));
+    }
+    const tokstats_num_t *num = tokstats_numeric(stats);
+    if (num->n > 0) {
+        fprintf(out, "min=%lld\nmax=%lld\nmean=%.3f\n",
+                (long long)num->min, (long long)num->max, num->mean);
+    }
+    fprintf(out, "distinct_tokens=%zu\n", tokstats_distinct(stats));
+    if (ntop > 0) {
+        fprintf(out, "top_token=%.*s x%llu\n", (int)top[0].len, top[0].key,
+                (unsigned long long)top[0].count);
+    }
+    tokstats_free(stats);
+
+    // Without -a the file is truncated and rewritten: an old checkpoint would
+    // point into bytes that are gone (or, if the new report happens to match
+    // the old one byte for byte, skip a report nobody has verified).
+    char ckpt_path[512];
+    snprintf(ckpt_path, sizeof(ckpt_path), "%s.ckpt", out_path);
+    if (!append_mode && unlink(ckpt_path) != 0 && errno != ENOENT) {
+        fprintf(stderr, "[warn] cannot remove stale checkpoint '%s' (%s)\n", ckpt_path, strerror(errno));
+    }
 
-    fclose(out);
-    printf("Wrote report to %s ✅\n\n", out_path);
+    // Adds crc32c= and the END line, then rewrites the file footer.
+    int flags = (append_mode ? RSUM_APPEND : 0) | (has_lzb_suffix(out_path) ? RSUM_COMPRESS : 0);
+    if (fclose(out) != 0 || rsum_write_report(out_path, flags, body, body_len) != 0) {
+        fprintf(stderr, "error: write failed for '%s' (%s)\n", out_path, strerror(errno));
+        free(body);
+        return 2;
+    }
+    free(body);
+    printf("Wrote report to %s (CRC32C via %s) ✅\n\n", out_path, crc32c_isa());
     wait_for_enter();
 
     // ---------------------- Part 5: Read report back ----------------------
@@ -201,16 +506,78 @@ int main(int argc, char **argv) {
         fprintf(stderr, "error: cannot reopen '%s' (%s)\n", out_path, strerror(errno));
         return 2;
     }
+    // With -a the file keeps growing; skip what an earlier run already read.
+    // A fresh file is read (and verified) in full, then checkpointed for -a.
+    uint64_t start = 0;
+    uint32_t crc = 0;               // CRC32C of the bytes before `start`
+    if (append_mode) {
+        ckpt_state_t ck = ckpt_resume_crc(ckpt_path, fileno(in), &start, &crc);
+        printf("[checkpoint] %s; reading from byte %llu\n", ckpt_state_name(ck),
+               (unsigned long long)start);
+    } else {
+        printf("[checkpoint] new file; reading from byte 0\n");
+    }
+    // A compressed file is read as text from memory: its blocks from the
+    // checkpoint on, decompressed in parallel. `text` is what fgets reads.
+    int framed = lzb_is_framed(fileno(in));
+    lzb_span_t sp = { 0 };
+    FILE *text = in;
+    if (framed > 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        if (lzb_read(fileno(in), start, cpus > 0 ? (int)cpus : 1, &sp) != 0 ||
+            !(text = fmemopen(sp.data, sp.len, "r"))) {
+            fprintf(stderr, "error: cannot decompress '%s' (%s)\n", out_path, strerror(errno));
+            free(sp.data);
+            fclose(in);
+            return 2;
+        }
+        printf("[lz] %llu block(s): %zu bytes of text from %llu on disk (%.1fx)\n",
+               (unsigned long long)sp.blocks, sp.len, (unsigned long long)sp.file_bytes,
+               sp.file_bytes ? (double)sp.len / (double)sp.file_bytes : 0.0);
+    } else if (framed < 0 || fseeko(in, (off_t)start, SEEK_SET) != 0) {
+        fprintf(stderr, "error: cannot seek '%s' (%s)\n", out_path, strerror(errno));
+        fclose(in);
+        return 2;
+    }
+    uint64_t pos = framed > 0 ? sp.raw_off : start;    // text offset of the next line
+    rsum_verify_t v;
+    rsum_verify_init(&v, pos, crc);
     char buf[256];
-    while (fgets(buf, sizeof(buf), in)) {
+    uint64_t done = start;          // where the next run resumes
+    uint32_t done_crc = crc;
+    while (fgets(buf, sizeof(buf), text)) {
         printf("  %s", buf); // fgets keeps newline
+        size_t n = strlen(buf);
+        // Appends rewrite a compressed file's last block: resume at its start.
+        if (framed > 0 && pos == sp.last_raw) {
+            done = sp.last_off;
+            done_crc = rsum_verify_crc(&v);
+        }
+        pos += n;
+        // The footer is rewritten by every append: never checkpoint past it.
+        if (rsum_verify_feed(&v, buf, n)) continue;
+        if (framed <= 0 && n && buf[n - 1] == '\n') done = pos;
+    }
+    if (framed <= 0) done_crc = rsum_verify_crc(&v);
+    // A half-written last line would make the CRC cover bytes past `done`;
+    // leave the checkpoint alone until the writer has finished it.
+    bool intact = v.records_bad == 0 && v.footer >= 0 && v.line_start;
+    printf("[crc32c] reports: %llu ok, %llu bad, %llu without checksum; file footer: %s\n",
+           (unsigned long long)v.records_ok, (unsigned long long)v.records_bad,
+           (unsigned long long)v.records_unchecked,
+           v.footer > 0 ? "ok ✅" : v.footer < 0 ? "MISMATCH ❌" : "missing");
+    // A damaged file is not checkpointed either, so the next run reports it again.
+    if (intact && ckpt_commit_crc(ckpt_path, fileno(in), done, done_crc) != 0) {
+        fprintf(stderr, "[warn] cannot save checkpoint '%s' (%s)\n", ckpt_path, strerror(errno));
     }
+    if (text != in) fclose(text);
+    free(sp.data);
     fclose(in);
     puts("");
     wait_for_enter();
 
     // ---------------------- Part 6: Bounds checking clinic ----------------
-    printf("=== Part 6: Bounds checking clinic (fgets + snprintf) ===\n");
+    printf("=== Part 6: Bounds checking clinic (fgets + fmt.h) ===\n");
 
     // (A) Bounded fgets with truncation detection & flushing
     // Ask for a short label (max 15 chars).
@@ -220,29 +587,40 @@ int main(int argc, char **argv) {
         fprintf(stderr, "error: no input for label\n");
         return 1;
     }
-    bool lab_trunc = (strchr(label, '\n') == NULL);
+    slice_t lab = slice_from_cstr(label);
+    bool lab_trunc = !(lab.len && lab.ptr[lab.len - 1] == '\n');
     if (lab_trunc) {
         fprintf(stderr, "[warn] label truncated to %zu chars; flushing rest\n",
                 sizeof(label) - 1);
         flush_stdin_line();
     }
-    chomp_newline(label);
+    slice_cstr(slice_chomp(lab));
 
-    // (B) Safe formatting into small buffers with snprintf
-    // Make a short tag like: "TAG:<label>"
+    // (B) Safe formatting into small buffers (common/fmt.h)
+    // Make a short tag like: "TAG:<label>". The format is typed pieces, so
+    // its longest output is a constant: the compiler checks tag[] holds it.
     char tag[20];
-    int need = snprintf(tag, sizeof(tag), "TAG:%s", label);
-    // snprintf returns the number of chars it *wanted* to write (excluding '\0')
-    if (need >= (int)sizeof(tag)) {
-        fprintf(stderr, "[warn] tag truncated (need %d, cap %zu)\n", need, sizeof(tag));
+    FMT_FITS(tag, FMT_LIT_MAX("TAG:") + FMT_STR_MAX(label));
+    fmt_t f = FMT_BEGIN(tag);
+    fmt_lit(&f, "TAG:");
+    fmt_str(&f, label);
+    // Like snprintf, fmt_end returns the length it *wanted* (excluding '\0')
+    size_t need = fmt_end(&f);
+    if (need >= sizeof(tag)) {
+        fprintf(stderr, "[warn] tag truncated (need %zu, cap %zu)\n", need, sizeof(tag));
     }
     printf("tag = \"%s\"\n", tag);
 
     // Build a tiny path like "tmp/<label>.txt" in a very small buffer.
     char tiny_path[24];
-    need = snprintf(tiny_path, sizeof(tiny_path), "tmp/%s.txt", label);
-    if (need >= (int)sizeof(tiny_path)) {
-        fprintf(stderr, "[warn] path truncated (need %d, cap %zu)\n", need, sizeof(tiny_path));
+    FMT_FITS(tiny_path, FMT_LIT_MAX("tmp/") + FMT_STR_MAX(label) + FMT_LIT_MAX(".txt"));
+    f = FMT_BEGIN(tiny_path);
+    fmt_lit(&f, "tmp/");
+    fmt_str(&f, label);
+    fmt_lit(&f, ".txt");
+    need = fmt_end(&f);
+    if (need >= sizeof(tiny_path)) {
+        fprintf(stderr, "[warn] path truncated (need %zu, cap %zu)\n", need, sizeof(tiny_path));
     }
     printf("tiny_path = \"%s\"\n", tiny_path);
 
@@ -252,6 +630,8 @@ int main(int argc, char **argv) {
     puts("\nBounds tips:\n"
          "  • With fgets: if no newline is captured, input was too long; flush the rest.\n"
          "  • With snprintf: check return value; if >= buffer size, it truncated.\n"
+         "  • With fmt.h: the longest output is a constant; FMT_FITS proves the buffer\n"
+         "    holds it at compile time, and fmt_end still reports truncation.\n"
          "  • For arrays: always compare an index against the array length before writing.\n");
 
     return 0;
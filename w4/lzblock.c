@@ -0,0 +1,376 @@
+// lzblock.c
+// LZ4-format block codec and 64 KiB block framing. See lzblock.h; used by
+// reportsum.c (io_demo Parts 4 and 5) and lzblock_bench.c.
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lzblock.h"
+
+#define MINMATCH     4
+#define LASTLITERALS 5          // a block ends with at least this many literals
+#define MFLIMIT      12         // no match may start in the last MFLIMIT bytes
+#define HASH_LOG     12
+#define SKIP_TRIGGER 6          // after 2^6 misses, probe every 2nd byte, and so on
+
+static const char MAGIC[4] = { 'L', 'Z', 'B', '1' };
+
+static inline uint32_t read32_(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t hash_(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_LOG); }
+
+// Length continuation bytes for a nibble that overflowed (len >= 15).
+static unsigned char *put_len_(unsigned char *op, size_t len) {
+    for (len -= 15; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+static unsigned char *put_literals_(unsigned char *op, unsigned char *token, const unsigned char *lit, size_t n) {
+    if (n >= 15) {
+        *token = 15 << 4;
+        op = put_len_(op, n);
+    } else {
+        *token = (unsigned char)(n << 4);
+    }
+    memcpy(op, lit, n);
+    return op + n;
+}
+
+size_t lzb_compress(const void *src, size_t n, void *dst, size_t cap) {
+    const unsigned char *in = src, *ip = in, *anchor = in, *end = in + n;
+    unsigned char *op = dst, *oend = op + cap;
+    if (n > LZB_BLOCK) return 0;
+    // Positions fit in 16 bits because a block is at most 64 KiB; an empty
+    // slot reads as position 0, which the 4-byte compare rejects if wrong.
+    uint16_t table[1 << HASH_LOG];
+    memset(table, 0, sizeof(table));
+
+    if (n > MFLIMIT) {
+        const unsigned char *mflimit = end - MFLIMIT;
+        const unsigned char *matchlimit = end - LASTLITERALS;
+        ip++;
+        for (;;) {
+            const unsigned char *ref;
+            unsigned probes = 1u << SKIP_TRIGGER;
+            for (;;) {
+                if (ip > mflimit) goto last;
+                uint32_t h = hash_(read32_(ip));
+                ref = in + table[h];
+                table[h] = (uint16_t)(ip - in);
+                if (ref < ip && read32_(ref) == read32_(ip)) break;
+                ip += probes++ >> SKIP_TRIGGER;
+            }
+            while (ip > anchor && ref > in && ip[-1] == ref[-1]) { ip--; ref--; }
+
+            const unsigned char *mp = ip + MINMATCH, *rp = ref + MINMATCH;
+            while (mp < matchlimit && *mp == *rp) { mp++; rp++; }
+            size_t lit = (size_t)(ip - anchor), mlen = (size_t)(mp - ip) - MINMATCH;
+            // token + literal length + literals + offset + match length
+            if ((size_t)(oend - op) < 1 + lit / 255 + 1 + lit + 2 + mlen / 255 + 1) return 0;
+            unsigned char *token = op++;
+            op = put_literals_(op, token, anchor, lit);
+            size_t off = (size_t)(ip - ref);
+            *op++ = (unsigned char)off;
+            *op++ = (unsigned char)(off >> 8);
+            if (mlen >= 15) {
+                *token |= 15;
+                op = put_len_(op, mlen);
+            } else {
+                *token |= (unsigned char)mlen;
+            }
+            ip = anchor = mp;
+            if (ip <= mflimit) table[hash_(read32_(ip - 2))] = (uint16_t)(ip - 2 - in);
+        }
+    }
+last:;
+    size_t lit = (size_t)(end - anchor);
+    if ((size_t)(oend - op) < 1 + lit / 255 + 1 + lit) return 0;
+    unsigned char *token = op++;
+    op = put_literals_(op, token, anchor, lit);
+    size_t out = (size_t)(op - (unsigned char *)dst);
+    return out < n ? out : 0;
+}
+
+// Read a length continuation; returns false on running off the input.
+static inline bool get_len_(const unsigned char **ip, const unsigned char *iend, size_t *len) {
+    unsigned b;
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+int64_t lzb_decompress(const void *src, size_t n, void *dst, size_t cap) {
+    const unsigned char *ip = src, *iend = ip + n;
+    unsigned char *out = dst, *op = out, *oend = out + cap;
+    while (ip < iend) {
+        unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_len_(&ip, iend, &lit)) return -1;
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) return -1;
+        if ((size_t)(iend - ip) >= lit + 8 && (size_t)(oend - op) >= lit + 8) {
+            for (size_t i = 0; i < lit; i += 8) memcpy(op + i, ip + i, 8);    // may overshoot: room checked
+        } else {
+            memcpy(op, ip, lit);
+        }
+        op += lit;
+        ip += lit;
+        if (ip == iend) break;                      // the last sequence has no match
+
+        if (iend - ip < 2) return -1;
+        size_t off = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (off == 0 || off > (size_t)(op - out)) return -1;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !get_len_(&ip, iend, &mlen)) return -1;
+        mlen += MINMATCH;
+        if (mlen > (size_t)(oend - op)) return -1;
+        const unsigned char *m = op - off;
+        if (off >= 8 && (size_t)(oend - op) >= mlen + 8) {
+            for (size_t i = 0; i < mlen; i += 8) memcpy(op + i, m + i, 8);     // source is 8+ bytes behind
+        } else {
+            for (size_t i = 0; i < mlen; i++) op[i] = m[i];                  // overlapping run
+        }
+        op += mlen;
+    }
+    return (int64_t)(op - out);
+}
+
+/* --------------------------------- Framing -------------------------------- */
+static void put32_(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+static void put64_(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+static uint32_t get32_(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = v << 8 | p[i];
+    return v;
+}
+static uint64_t get64_(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = v << 8 | p[i];
+    return v;
+}
+
+typedef struct {
+    uint64_t raw_off;
+    uint32_t raw_len, comp_len;
+} header_t;
+
+// Parse the header at p (LZB_HEADER bytes); false if it cannot be one of ours.
+static bool get_header_(const unsigned char *p, header_t *h) {
+    if (memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+    h->raw_off = get64_(p + 4);
+    h->raw_len = get32_(p + 12);
+    h->comp_len = get32_(p + 16);
+    return h->raw_len <= LZB_BLOCK && h->comp_len <= h->raw_len;
+}
+
+static int pread_all_(int fd, void *buf, size_t n, uint64_t off) {
+    char *p = buf;
+    while (n) {
+        ssize_t r = pread(fd, p, n, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) { errno = EBADMSG; return -1; }     // file ends inside a block
+        p += r;
+        n -= (size_t)r;
+        off += (uint64_t)r;
+    }
+    return 0;
+}
+
+static int pwrite_all_(int fd, const void *buf, size_t n, uint64_t off) {
+    const char *p = buf;
+    while (n) {
+        ssize_t w = pwrite(fd, p, n, (off_t)off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) return -1;
+        p += w;
+        n -= (size_t)w;
+        off += (uint64_t)w;
+    }
+    return 0;
+}
+
+int lzb_is_framed(int fd) {
+    char m[sizeof(MAGIC)];
+    ssize_t r;
+    do r = pread(fd, m, sizeof(m), 0); while (r < 0 && errno == EINTR);
+    if (r < 0) return -1;
+    return r == (ssize_t)sizeof(m) && memcmp(m, MAGIC, sizeof(m)) == 0;
+}
+
+int lzb_last_block(int fd, uint64_t *off) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    uint64_t size = (uint64_t)st.st_size, at = 0;
+    *off = 0;
+    while (at < size) {
+        unsigned char hb[LZB_HEADER];
+        header_t h;
+        if (pread_all_(fd, hb, sizeof(hb), at) != 0) return -1;
+        if (!get_header_(hb, &h)) { errno = EBADMSG; return -1; }
+        *off = at;
+        at += LZB_HEADER + (uint64_t)h.comp_len;
+    }
+    if (at != size) { errno = EBADMSG; return -1; }
+    return 0;
+}
+
+int lzb_write(int fd, uint64_t off, uint64_t raw_off, const char *raw, size_t n, uint64_t *end) {
+    unsigned char *buf = malloc(LZB_HEADER + LZB_BOUND(LZB_BLOCK));
+    if (!buf) return -1;
+    int rc = -1;
+    while (n) {
+        size_t take = n < LZB_BLOCK ? n : LZB_BLOCK;
+        if (take < n) {                             // end the block after a '\n' if there is one
+            size_t cut = take;
+            while (cut && raw[cut - 1] != '\n') cut--;
+            if (cut) take = cut;
+        }
+        size_t c = lzb_compress(raw, take, buf + LZB_HEADER, LZB_BOUND(LZB_BLOCK));
+        if (!c) {                                   // incompressible: store it
+            memcpy(buf + LZB_HEADER, raw, take);
+            c = take;
+        }
+        memcpy(buf, MAGIC, sizeof(MAGIC));
+        put64_(buf + 4, raw_off);
+        put32_(buf + 12, (uint32_t)take);
+        put32_(buf + 16, (uint32_t)c);
+        if (pwrite_all_(fd, buf, LZB_HEADER + c, off) != 0) goto out;
+        off += LZB_HEADER + c;
+        raw_off += take;
+        raw += take;
+        n -= take;
+    }
+    *end = off;
+    rc = 0;
+out:
+    free(buf);
+    return rc;
+}
+
+/* ------------------------------ Parallel read ----------------------------- */
+typedef struct {
+    const unsigned char *src;   // compressed bytes (header skipped)
+    char *dst;
+    header_t h;
+} block_t;
+
+typedef struct {
+    block_t *blocks;
+    size_t from, to;
+    int failed;
+} worker_t;
+
+static void *decode_range_(void *arg) {
+    worker_t *w = arg;
+    for (size_t i = w->from; i < w->to && !w->failed; i++) {
+        block_t *b = &w->blocks[i];
+        if (b->h.comp_len == b->h.raw_len) {
+            memcpy(b->dst, b->src, b->h.raw_len);
+        } else if (lzb_decompress(b->src, b->h.comp_len, b->dst, b->h.raw_len) != (int64_t)b->h.raw_len) {
+            w->failed = 1;
+        }
+    }
+    return NULL;
+}
+
+int lzb_read(int fd, uint64_t off, int threads, lzb_span_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->last_off = off;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    uint64_t size = (uint64_t)st.st_size;
+    if (off > size) { errno = EINVAL; return -1; }
+
+    unsigned char *comp = malloc(size - off + 1);
+    block_t *blocks = NULL;
+    worker_t *workers = NULL;
+    pthread_t *tids = NULL;
+    size_t nblocks = 0, capb = 0;
+    uint64_t raw = 0;
+    int rc = -1;
+    if (!comp || pread_all_(fd, comp, size - off, off) != 0) goto out;
+
+    // Walk the headers: every block must follow the previous one in the
+    // uncompressed stream too.
+    for (uint64_t at = 0; at < size - off;) {
+        header_t h;
+        if (size - off - at < LZB_HEADER || !get_header_(comp + at, &h) ||
+            h.comp_len > size - off - at - LZB_HEADER || (nblocks && h.raw_off != out->raw_off + raw)) {
+            errno = EBADMSG;
+            goto out;
+        }
+        if (nblocks == capb) {
+            capb = capb ? 2 * capb : 64;
+            block_t *nb = realloc(blocks, capb * sizeof(*blocks));
+            if (!nb) goto out;
+            blocks = nb;
+        }
+        if (!nblocks) out->raw_off = h.raw_off;
+        blocks[nblocks++] = (block_t){ comp + at + LZB_HEADER, NULL, h };
+        out->last_off = off + at;
+        out->last_raw = h.raw_off;
+        raw += h.raw_len;
+        at += LZB_HEADER + (uint64_t)h.comp_len;
+    }
+
+    out->data = malloc(raw + 1);
+    if (!out->data) goto out;
+    for (size_t i = 0; i < nblocks; i++) blocks[i].dst = out->data + (blocks[i].h.raw_off - out->raw_off);
+
+    // Contiguous ranges of blocks per thread; the calling thread takes the first.
+    size_t nt = threads < 1 ? 1 : (size_t)threads;
+    if (nt > nblocks) nt = nblocks ? nblocks : 1;
+    workers = calloc(nt, sizeof(*workers));
+    tids = calloc(nt, sizeof(*tids));
+    if (!workers || !tids) goto out;
+    size_t started = 1;
+    for (size_t t = 0; t < nt; t++) workers[t] = (worker_t){ blocks, nblocks * t / nt, nblocks * (t + 1) / nt, 0 };
+    for (; started < nt; started++) {
+        int e = pthread_create(&tids[started], NULL, decode_range_, &workers[started]);
+        if (e != 0) { errno = e; break; }
+    }
+    if (started < nt) {                             // could not start them all: do the rest here
+        for (size_t t = started; t < nt; t++) decode_range_(&workers[t]);
+    }
+    decode_range_(&workers[0]);
+    int failed = 0;
+    for (size_t t = 0; t < nt; t++) {
+        if (t > 0 && t < started) pthread_join(tids[t], NULL);
+        failed |= workers[t].failed;
+    }
+    if (failed) { errno = EBADMSG; goto out; }
+
+    out->len = (size_t)raw;
+    out->blocks = nblocks;
+    out->file_bytes = size - off;
+    rc = 0;
+out:
+    if (rc != 0) {
+        free(out->data);
+        out->data = NULL;
+    }
+    free(tids);
+    free(workers);
+    free(blocks);
+    free(comp);
+    return rc;
+}
@@ -0,0 +1,74 @@
+// lzblock.h
+// LZ77 block compression for io_demo REPORT files (LZ4's block format, no
+// external library), framed into independent blocks of up to 64 KiB.
+//
+// Codec (one block at a time, as in LZ4):
+//     token           high nibble: literal count, low nibble: match length - 4
+//                     (15 means "more length bytes follow, 255 = keep going")
+//     literals        copied as is
+//     offset          2 bytes little-endian, 1..65535 back into the output
+// The last 5 bytes of a block are always literals and the last match starts
+// at least 12 bytes before the end, so the decoder may copy 8 bytes at a time.
+//
+// File framing (LZB_HEADER bytes before each block, integers little-endian):
+//     "LZB1" | raw_off (8) | raw_len (4) | comp_len (4) | comp_len bytes
+// raw_off is where the block's text starts in the uncompressed stream;
+// comp_len == raw_len means the block is stored uncompressed. Blocks never
+// refer to each other, so they can be decompressed in any order, by any
+// number of threads, starting at any block.
+//
+// lzb_write() cuts blocks at line ends, so every block starts a line. That
+// lets a writer rewrite only the last block when it appends (io_demo keeps
+// the file footer there) and a reader checkpoint at a block start.
+
+#ifndef W4_LZBLOCK_H
+#define W4_LZBLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LZB_BLOCK  65536        // most raw bytes per block
+#define LZB_HEADER 20
+
+// Worst-case compressed size of n raw bytes.
+#define LZB_BOUND(n) ((n) + (n) / 255 + 16)
+
+// Compress src[0..n), n <= LZB_BLOCK, into dst[0..cap). Returns the
+// compressed size, or 0 if it does not fit (or would not be smaller).
+size_t lzb_compress(const void *src, size_t n, void *dst, size_t cap);
+
+// Decompress one block into dst[0..cap). Returns the raw size, or -1 if the
+// block is malformed or does not fit (never reads or writes out of bounds).
+int64_t lzb_decompress(const void *src, size_t n, void *dst, size_t cap);
+
+// 1 if fd holds framed blocks (starts with the magic), 0 if not or empty,
+// -1 with errno set on a read error.
+int lzb_is_framed(int fd);
+
+// File offset of the last block (0 for an empty file). Returns 0, or -1
+// with errno set (EBADMSG if a header is damaged).
+int lzb_last_block(int fd, uint64_t *off);
+
+// Compress raw[0..n) as blocks written at file offset off, the first one
+// starting at raw_off in the uncompressed stream. *end is set to the file
+// offset after the last block (the caller truncates there). Returns 0, or
+// -1 with errno set.
+int lzb_write(int fd, uint64_t off, uint64_t raw_off, const char *raw, size_t n, uint64_t *end);
+
+// Decompressed blocks from file offset off to EOF.
+typedef struct {
+    char *data;                 // malloc'd; the caller frees it
+    size_t len;
+    uint64_t raw_off;           // uncompressed offset of data[0]
+    uint64_t blocks;
+    uint64_t file_bytes;        // compressed bytes read, headers included
+    uint64_t last_off;          // file offset of the last block (off if none)
+    uint64_t last_raw;          // ... and its uncompressed offset
+} lzb_span_t;
+
+// Read and decompress every block from off (a block start) to EOF using up
+// to `threads` threads. Returns 0, or -1 with errno set (EBADMSG for a
+// damaged block or header).
+int lzb_read(int fd, uint64_t off, int threads, lzb_span_t *out);
+
+#endif /* W4_LZBLOCK_H */
@@ -0,0 +1,302 @@
+// lzblock_bench.c
+// Recitation extension: LZ block compression for io_demo's reports (lzblock.c)
+//
+// Build:  make lzblock_bench
+// Run:    ./lzblock_bench                 (256 MiB of reports in /tmp)
+//         ./lzblock_bench -s 1G -d /some/disk -t 8
+//
+// 1. Round trips: random, low-entropy, run-length and report text of every
+//    size up to one block must decompress to the input; damaged blocks must
+//    be rejected (or decode to something) without touching memory outside
+//    the buffers.
+// 2. On -s bytes of generated REPORT records: compression ratio, compress
+//    and decompress GB/s for one thread in memory.
+// 3. The file path: writing the report file raw vs as LZ blocks, then
+//    reading it back (pread vs lzb_read with 1 and -t threads).
+
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "lzblock.h"
+
+static uint64_t rng = 0x452821E638D01377ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+// REPORT records like io_demo's (crc32c= values are just hex noise here).
+static size_t make_reports(char *out, size_t size) {
+    size_t used = 0;
+    for (unsigned r = 0; used + 1024 < size; r++) {
+        used += (size_t)snprintf(out + used, 1024,
+                                 "REPORT\nargv_count=2\nargv[0]=./io_demo\nargv[1]=output.txt\nline_tokens=4\n"
+                                 "token[0]=GET\ntoken[1]=/api/v%u/items/%u\ntoken[2]=%u.%03u\ntoken[3]=%u\n"
+                                 "numeric_tokens=1\nsum=%u\nfloat_tokens=1\nfloat_sum=%u.%03u\n"
+                                 "distinct_tokens=4\ntop_token=GET x1\ncrc32c=%08x\n---- END REPORT ----\n",
+                                 r % 7, (unsigned)(rnd() % 100000), r % 900, r % 1000, 200 + r % 5 * 100,
+                                 200 + r % 5 * 100, r % 900, r % 1000, (unsigned)rnd());
+    }
+    return used;
+}
+
+/* ------------------------------ Round trips ------------------------------ */
+static void fill(unsigned char *p, size_t n, int kind) {
+    switch (kind) {
+        case 0: for (size_t i = 0; i < n; i++) p[i] = (unsigned char)rnd(); break;       // incompressible
+        case 1: for (size_t i = 0; i < n; i++) p[i] = "abcd"[rnd() & 3]; break;          // low entropy
+        case 2:                                                                            // runs: offsets < 8
+            for (size_t i = 0; i < n;) {
+                size_t run = 1 + rnd() % 300;
+                unsigned char c = (unsigned char)rnd();
+                for (; run-- && i < n; i++) p[i] = c;
+            }
+            break;
+        default: {                                                                         // report text
+            static char text[2 * LZB_BLOCK];
+            static size_t text_len;
+            if (!text_len) text_len = make_reports(text, sizeof(text));
+            size_t at = (size_t)(rnd() % (text_len - n + 1));
+            memcpy(p, text + at, n);
+        }
+    }
+}
+
+static int round_trips(void) {
+    static unsigned char src[LZB_BLOCK], comp[LZB_BOUND(LZB_BLOCK)], back[LZB_BLOCK + 64];
+    static const char *kinds[] = { "random", "4-letter", "runs", "reports" };
+    int ok = 1;
+    for (int kind = 0; kind < 4; kind++) {
+        int good = 1;
+        size_t stored = 0, trials = 0;
+        for (int r = 0; r < 3000 && good; r++, trials++) {
+            size_t n = r < 64 ? (size_t)r : r % 10 == 0 ? LZB_BLOCK : (size_t)(rnd() % (LZB_BLOCK + 1));
+            fill(src, n, kind);
+            size_t c = lzb_compress(src, n, comp, sizeof(comp));
+            if (!c) { stored++; continue; }             // lzb_write would store it raw
+            int64_t d = lzb_decompress(comp, c, back, n);
+            good = d == (int64_t)n && memcmp(src, back, n) == 0;
+            if (!good) fprintf(stderr, "  %s: n=%zu c=%zu -> %lld\n", kinds[kind], n, c, (long long)d);
+        }
+        printf("%s %-9s %zu blocks round-trip (%zu stored raw)\n", good ? "✅" : "❌", kinds[kind], trials, stored);
+        ok &= good;
+    }
+
+    // Damage: flipped bytes and truncation. The output buffer is exactly the
+    // claimed size plus a guard that must stay untouched.
+    size_t rejected = 0, decoded = 0;
+    int guard_ok = 1;
+    for (int r = 0; r < 20000; r++) {
+        size_t n = 1024 + (size_t)(rnd() % (LZB_BLOCK - 1024));
+        fill(src, n, 1 + r % 3);
+        size_t c = lzb_compress(src, n, comp, sizeof(comp));
+        if (!c) continue;
+        if (r & 1) {
+            for (int k = 0; k < 4; k++) comp[rnd() % c] ^= (unsigned char)(1 + rnd() % 255);
+        } else {
+            c = (size_t)(rnd() % c);
+        }
+        memset(back + n, 0xA5, 64);
+        int64_t d = lzb_decompress(comp, c, back, n);
+        for (int k = 0; k < 64; k++) guard_ok &= back[n + k] == 0xA5;
+        if (d < 0) rejected++;
+        else decoded++;
+    }
+    printf("%s damaged blocks: %zu rejected, %zu decoded to garbage, no write past the buffer\n",
+           guard_ok ? "✅" : "❌", rejected, decoded);
+    return ok & guard_ok;
+}
+
+/* --------------------------------- Speed --------------------------------- */
+static double best_of(int reps, double (*fn)(void *), void *arg) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        double s = fn(arg);
+        if (s < best) best = s;
+    }
+    return best;
+}
+
+typedef struct {
+    const char *text;
+    size_t len;
+    unsigned char *comp;        // blocks back to back, no headers
+    size_t *clen;               // compressed size per block (0 = stored)
+    size_t nblocks, comp_total;
+    char *back;
+} mem_t;
+
+static double compress_all(void *arg) {
+    mem_t *m = arg;
+    uint64_t t0 = timing_now_ns();
+    unsigned char *o = m->comp;
+    m->comp_total = 0;
+    for (size_t b = 0; b < m->nblocks; b++) {
+        size_t off = b * LZB_BLOCK, n = m->len - off < LZB_BLOCK ? m->len - off : LZB_BLOCK;
+        m->clen[b] = lzb_compress(m->text + off, n, o, LZB_BOUND(LZB_BLOCK));
+        size_t used = m->clen[b] ? m->clen[b] : n;
+        if (!m->clen[b]) memcpy(o, m->text + off, n);
+        o += used;
+        m->comp_total += used;
+    }
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+static double decompress_all(void *arg) {
+    mem_t *m = arg;
+    uint64_t t0 = timing_now_ns();
+    const unsigned char *c = m->comp;
+    for (size_t b = 0; b < m->nblocks; b++) {
+        size_t off = b * LZB_BLOCK, n = m->len - off < LZB_BLOCK ? m->len - off : LZB_BLOCK;
+        if (m->clen[b]) {
+            lzb_decompress(c, m->clen[b], m->back + off, n);
+            c += m->clen[b];
+        } else {
+            memcpy(m->back + off, c, n);
+            c += n;
+        }
+    }
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+static double write_file(const char *path, const char *text, size_t len, int compress, uint64_t *bytes) {
+    uint64_t t0 = timing_now_ns();
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { perror(path); exit(1); }
+    uint64_t end = len;
+    if (compress) {
+        if (lzb_write(fd, 0, 0, text, len, &end) != 0) { perror("lzb_write"); exit(1); }
+    } else {
+        for (size_t off = 0; off < len;) {
+            ssize_t w = write(fd, text + off, len - off);
+            if (w <= 0) { perror("write"); exit(1); }
+            off += (size_t)w;
+        }
+    }
+    if (fsync(fd) != 0) perror("fsync");
+    close(fd);
+    *bytes = end;
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+typedef struct {
+    const char *path;
+    int threads;                // 0: plain pread of the raw file
+    size_t len;
+} rd_t;
+
+static double read_file(void *arg) {
+    rd_t *r = arg;
+    uint64_t t0 = timing_now_ns();
+    int fd = open(r->path, O_RDONLY);
+    if (fd < 0) { perror(r->path); exit(1); }
+    if (r->threads == 0) {
+        char *buf = malloc(r->len);
+        if (!buf) { perror("malloc"); exit(1); }
+        for (size_t off = 0; off < r->len;) {
+            ssize_t n = pread(fd, buf + off, r->len - off, (off_t)off);
+            if (n <= 0) { perror("pread"); exit(1); }
+            off += (size_t)n;
+        }
+        free(buf);
+    } else {
+        lzb_span_t sp;
+        if (lzb_read(fd, 0, r->threads, &sp) != 0 || sp.len != r->len) { perror("lzb_read"); exit(1); }
+        free(sp.data);
+    }
+    close(fd);
+    return (double)(timing_now_ns() - t0) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t size = 256u << 20;
+    const char *dir = "/tmp";
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:d:t:")) != -1) {
+        switch (opt) {
+            case 's': size = parse_size(optarg); break;
+            case 'd': dir = optarg; break;
+            case 't': threads = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s report_bytes] [-d dir] [-t threads]\n", argv[0]);
+                return 2;
+        }
+    }
+    printf("=== LZ blocks for reports: %zu KiB blocks, %d threads ===\n\n", (size_t)LZB_BLOCK >> 10, threads);
+    int ok = round_trips();
+
+    mem_t m = { 0 };
+    char *text = malloc(size);
+    m.back = malloc(size);
+    m.nblocks = (size + LZB_BLOCK - 1) / LZB_BLOCK;
+    m.comp = malloc(m.nblocks * LZB_BOUND(LZB_BLOCK));
+    m.clen = malloc(m.nblocks * sizeof(*m.clen));
+    if (!text || !m.back || !m.comp || !m.clen) { perror("malloc"); return 1; }
+    m.text = text;
+    m.len = make_reports(text, size);
+    m.nblocks = (m.len + LZB_BLOCK - 1) / LZB_BLOCK;
+
+    double c_s = best_of(3, compress_all, &m);
+    double d_s = best_of(3, decompress_all, &m);
+    int same = memcmp(text, m.back, m.len) == 0;
+    ok &= same;
+    printf("\n%.0f MiB of reports in %zu blocks -> %.1f MiB (ratio %.2f)\n", (double)m.len / (1 << 20), m.nblocks,
+           (double)m.comp_total / (1 << 20), (double)m.len / (double)m.comp_total);
+    printf("compress   1 thread   %6.2f GB/s\n", (double)m.len / c_s / 1e9);
+    printf("decompress 1 thread   %6.2f GB/s %s\n", (double)m.len / d_s / 1e9, same ? "✅" : "❌ output differs");
+
+    char raw_path[512], lz_path[512];
+    snprintf(raw_path, sizeof(raw_path), "%s/lzblock_reports.txt", dir);
+    snprintf(lz_path, sizeof(lz_path), "%s/lzblock_reports.lzb", dir);
+    uint64_t raw_bytes, lz_bytes;
+    double w_raw = write_file(raw_path, text, m.len, 0, &raw_bytes);
+    double w_lz = write_file(lz_path, text, m.len, 1, &lz_bytes);
+    printf("\nreport file (text GB/s)      raw      lzb\n");
+    printf("bytes on disk (MiB)     %8.1f %8.1f\n", (double)raw_bytes / (1 << 20), (double)lz_bytes / (1 << 20));
+    printf("write + fsync           %8.2f %8.2f\n", (double)m.len / w_raw / 1e9, (double)m.len / w_lz / 1e9);
+    rd_t raw = { raw_path, 0, m.len }, one = { lz_path, 1, m.len }, many = { lz_path, threads, m.len };
+    double r_raw = best_of(3, read_file, &raw);
+    double r_one = best_of(3, read_file, &one);
+    double r_many = best_of(3, read_file, &many);
+    printf("read (page cache)       %8.2f %8.2f  1 thread\n", (double)m.len / r_raw / 1e9, (double)m.len / r_one / 1e9);
+    printf("                        %8s %8.2f  %d threads\n", "", (double)m.len / r_many / 1e9, threads);
+
+    // The framed file must read back as exactly the text.
+    int fd = open(lz_path, O_RDONLY);
+    lzb_span_t sp;
+    int back_ok = fd >= 0 && lzb_read(fd, 0, threads, &sp) == 0 && sp.len == m.len && memcmp(sp.data, text, m.len) == 0;
+    printf("%s lzb_read of the file matches the text\n", back_ok ? "✅" : "❌");
+    if (fd >= 0) close(fd);
+    if (back_ok) free(sp.data);
+    ok &= back_ok;
+    unlink(raw_path);
+    unlink(lz_path);
+
+    printf("\nTakeaway:\n");
+    printf("  • Reports repeat the same keys in every record, so a 64 KiB window finds\n"
+           "    most of each record in the one before it: fewer bytes to write and read.\n");
+    printf("  • Blocks that never refer to each other cost a little ratio but let every\n"
+           "    core decompress its own share, and let appends rewrite only the tail.\n\n");
+    free(text);
+    free(m.back);
+    free(m.comp);
+    free(m.clen);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// passthru.c
+// Forward a stream unchanged while tokenizing a copy: read/write vs
+// tee + splice. See passthru.h; used by io_demo.c (-p) and passthru_bench.c.
+
+#ifdef __linux__
+#define _GNU_SOURCE             // splice, tee, F_SETPIPE_SZ
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "passthru.h"
+
+const char *passthru_mode_name(pass_mode_t m) {
+    return m == PASS_SPLICE ? "splice" : "copy";
+}
+
+static int write_all_(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int64_t copy_(int in, int out, batch_stream_t *stats) {
+    char *buf = malloc(PASS_CHUNK);
+    if (!buf) return -1;
+    int64_t done = 0;
+    for (;;) {
+        ssize_t n = read(in, buf, PASS_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) { done = -1; break; }
+        if (n == 0) break;
+        if (write_all_(out, buf, (size_t)n) != 0 ||
+            (stats && batch_stream_feed(stats, buf, (size_t)n) != 0)) {
+            done = -1;
+            break;
+        }
+        done += n;
+    }
+    free(buf);
+    return done;
+}
+
+#ifdef __linux__
+// Move exactly n bytes from in to out; *moved says how far it got.
+static int splice_all_(int in, int out, size_t n, size_t *moved) {
+    *moved = 0;
+    while (*moved < n) {
+        ssize_t m = splice(in, NULL, out, NULL, n - *moved, SPLICE_F_MOVE);
+        if (m < 0 && errno == EINTR) continue;
+        if (m == 0) errno = EPIPE;
+        if (m <= 0) return -1;
+        *moved += (size_t)m;
+    }
+    return 0;
+}
+
+// Returns bytes forwarded, -1 on error, or -2 if the fds cannot splice
+// and nothing has been consumed yet (the caller copies instead).
+static int64_t splice_(int in, int out, batch_stream_t *stats) {
+    int side[2] = { -1, -1 };
+    char *buf = NULL;
+    int64_t done = 0;
+    fcntl(in, F_SETPIPE_SZ, PASS_CHUNK);           // fewer, larger rounds; fine if refused
+    if (stats) {
+        if (pipe2(side, O_CLOEXEC) != 0) return -1;
+        fcntl(side[1], F_SETPIPE_SZ, PASS_CHUNK);
+        if (!(buf = malloc(PASS_CHUNK))) { done = -1; goto out; }
+    }
+    for (;;) {
+        // tee copies page references into the side pipe and leaves them in
+        // stdin; the splice below then consumes them.
+        ssize_t n = stats ? tee(in, side[1], PASS_CHUNK, 0) : splice(in, NULL, out, NULL, PASS_CHUNK, SPLICE_F_MOVE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) { done = done == 0 && errno == EINVAL ? -2 : -1; goto out; }
+        if (n == 0) break;
+        if (stats) {
+            size_t moved;
+            if (splice_all_(in, out, (size_t)n, &moved) != 0) {
+                done = done == 0 && moved == 0 && errno == EINVAL ? -2 : -1;
+                goto out;
+            }
+            for (size_t left = (size_t)n; left;) {
+                ssize_t r = read(side[0], buf, left);
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0 || batch_stream_feed(stats, buf, (size_t)r) != 0) { done = -1; goto out; }
+                left -= (size_t)r;
+            }
+        }
+        done += n;
+    }
+out:
+    free(buf);
+    if (side[0] >= 0) close(side[0]);
+    if (side[1] >= 0) close(side[1]);
+    return done;
+}
+#endif
+
+int64_t passthru_run(int in_fd, int out_fd, pass_mode_t mode, batch_stream_t *stats, pass_mode_t *used) {
+    *used = PASS_COPY;
+#ifdef __linux__
+    if (mode == PASS_SPLICE) {
+        int64_t n = splice_(in_fd, out_fd, stats);
+        if (n != -2) {
+            *used = PASS_SPLICE;
+            return n;
+        }
+    }
+#else
+    (void)mode;
+#endif
+    return copy_(in_fd, out_fd, stats);
+}
@@ -0,0 +1,37 @@
+// passthru.h
+// io_demo's filter mode (-p): forward stdin to a file or pipe unchanged and
+// tokenize it on the side (batch.h's stream pipeline).
+//
+// Copying path, what fgets + fprintf amount to: read() every chunk into a
+// buffer, write() it out again, tokenize the buffer. Each byte crosses the
+// user/kernel boundary twice.
+//
+// Splice path (Linux, stdin must be a pipe):
+//     tee(stdin, side pipe)         duplicate the next chunk inside the kernel
+//     splice(stdin, out)            move it to the output: page references,
+//                                   no copy through user space
+//     read(side pipe)               the one copy, for the tokenizer
+// Without statistics the tee and the read go away: bytes never enter the
+// process at all. If the output cannot take splice (a terminal, an O_APPEND
+// file on older kernels) the first splice fails before anything has been
+// consumed and the copying path takes over.
+
+#ifndef W4_PASSTHRU_H
+#define W4_PASSTHRU_H
+
+#include <stdint.h>
+
+#include "batch.h"
+
+#define PASS_CHUNK (1u << 20)   // bytes per tee/splice/read round, and the pipe size asked for
+
+typedef enum { PASS_COPY, PASS_SPLICE } pass_mode_t;
+
+// Forward in_fd to out_fd until EOF, feeding stats (NULL: no statistics).
+// *used is the mode that actually ran. Returns bytes forwarded, or -1 with
+// errno set.
+int64_t passthru_run(int in_fd, int out_fd, pass_mode_t mode, batch_stream_t *stats, pass_mode_t *used);
+
+const char *passthru_mode_name(pass_mode_t m);
+
+#endif /* W4_PASSTHRU_H */
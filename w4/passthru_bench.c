@@ -0,0 +1,225 @@
+// passthru_bench.c
+// Recitation extension: io_demo's filter mode (passthru.c), copying vs splice
+//
+// Build:  make passthru_bench
+// Run:    ./passthru_bench                  (1 GiB through a pipe into /dev/null)
+//         ./passthru_bench -s 10G -o /tmp/passthru.out
+//
+// A child process generates -s bytes of log lines into a pipe with vmsplice
+// (write() off Linux), so the producer side costs the same in every run. The
+// parent forwards the pipe to -o (default /dev/null) five ways:
+//     fgets + fputs              what io_demo's interactive parts do, per line
+//     read + write               passthru's copying path, no statistics
+//     splice                     no statistics, bytes never enter the process
+//     read + write + stats       copying path, tokenizing the buffer
+//     tee + splice + stats       splice path, tokenizing a tee'd copy
+// and reports wall time, GB/s and the parent's CPU time (getrusage: user,
+// sys), which is what the splice path saves even when the pipe is the limit.
+// Both statistics runs must agree.
+
+#ifdef __linux__
+#define _GNU_SOURCE             // vmsplice, F_SETPIPE_SZ
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "passthru.h"
+
+#define POOL_BYTES (4u << 20)
+
+static uint64_t rng = 0xA4093822299F31D0ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+// Access-log-like lines, like batch_bench's; ends on a line boundary.
+static size_t make_lines(char *out, size_t cap) {
+    static const char *methods[] = { "GET", "GET", "GET", "POST", "PUT", "DELETE" };
+    size_t used = 0;
+    while (used + 128 < cap) {
+        used += (size_t)snprintf(out + used, 128, "%s /api/v%u/items/%u %u.%03u %u %u\n", methods[rnd() % 6],
+                                 (unsigned)(rnd() % 4), (unsigned)(rnd() % 5000), (unsigned)(rnd() % 900),
+                                 (unsigned)(rnd() % 1000), (rnd() % 10) ? 200u : 500u, (unsigned)(rnd() % 65536));
+    }
+    return used;
+}
+
+/* -------------------------------- Producer -------------------------------- */
+// Child: total bytes of pool into fd, then exit. vmsplice hands the pipe
+// references to pool's pages; pool never changes, so that is safe.
+static void produce(int fd, const char *pool, size_t pool_len, size_t total) {
+#ifdef __linux__
+    fcntl(fd, F_SETPIPE_SZ, PASS_CHUNK);
+    int use_vmsplice = 1;
+#endif
+    size_t at = 0;
+    while (total) {
+        size_t n = pool_len - at < total ? pool_len - at : total;
+        ssize_t w;
+#ifdef __linux__
+        if (use_vmsplice) {
+            struct iovec iov = { (void *)(pool + at), n };
+            w = vmsplice(fd, &iov, 1, 0);
+            if (w < 0 && errno == EINVAL) {
+                use_vmsplice = 0;
+                continue;
+            }
+        } else
+#endif
+            w = write(fd, pool + at, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) _exit(1);
+        at = (at + (size_t)w) % pool_len;
+        total -= (size_t)w;
+    }
+    _exit(0);
+}
+
+/* ---------------------------------- Runs ---------------------------------- */
+typedef enum { RUN_STDIO, RUN_COPY, RUN_SPLICE, RUN_COPY_STATS, RUN_SPLICE_STATS } run_t;
+
+static const char *run_names[] = { "fgets + fputs", "read + write", "splice", "read + write + stats",
+                                   "tee + splice + stats" };
+
+typedef struct { double secs, user, sys; int64_t bytes; pass_mode_t used; } timing_t;
+
+static double tv_s(struct timeval tv) { return (double)tv.tv_sec + (double)tv.tv_usec / 1e6; }
+
+// fgets + fputs through a 4 KiB line buffer, like io_demo's Part 2.
+static int64_t stdio_copy(int in, int out) {
+    FILE *fi = fdopen(in, "r"), *fo = fdopen(dup(out), "w");
+    if (!fi || !fo) { perror("fdopen"); exit(1); }
+    char line[4096];
+    int64_t n = 0;
+    while (fgets(line, sizeof(line), fi)) {
+        size_t len = strlen(line);
+        if (fputs(line, fo) == EOF) { n = -1; break; }
+        n += (int64_t)len;
+    }
+    fclose(fi);
+    if (fclose(fo) != 0) n = -1;
+    return n;
+}
+
+static timing_t run(run_t kind, const char *out_path, const char *pool, size_t pool_len, size_t total,
+                    batch_result_t *r) {
+    int p[2];
+    if (pipe(p) != 0) { perror("pipe"); exit(1); }
+    pid_t pid = fork();
+    if (pid < 0) { perror("fork"); exit(1); }
+    if (pid == 0) {
+        close(p[0]);
+        produce(p[1], pool, pool_len, total);
+    }
+    close(p[1]);
+    int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) { perror(out_path); exit(1); }
+
+    batch_stream_t s;
+    int stats = kind == RUN_COPY_STATS || kind == RUN_SPLICE_STATS;
+    if (stats && batch_stream_init(&s, r, TOKSTATS_SKETCH) != 0) { perror("batch_stream_init"); exit(1); }
+    timing_t t = { 0 };
+    struct rusage a, b;
+    getrusage(RUSAGE_SELF, &a);
+    uint64_t t0 = timing_now_ns();
+    if (kind == RUN_STDIO) {
+        t.bytes = stdio_copy(p[0], out);
+        t.used = PASS_COPY;
+    } else {
+        pass_mode_t mode = kind == RUN_SPLICE || kind == RUN_SPLICE_STATS ? PASS_SPLICE : PASS_COPY;
+        t.bytes = passthru_run(p[0], out, mode, stats ? &s : NULL, &t.used);
+        close(p[0]);
+    }
+    if (stats) batch_stream_finish(&s);
+    t.secs = (double)(timing_now_ns() - t0) / 1e9;
+    getrusage(RUSAGE_SELF, &b);
+    t.user = tv_s(b.ru_utime) - tv_s(a.ru_utime);
+    t.sys = tv_s(b.ru_stime) - tv_s(a.ru_stime);
+    close(out);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (t.bytes < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: run failed (%s)\n", run_names[kind], strerror(errno));
+        exit(1);
+    }
+    return t;
+}
+
+int main(int argc, char **argv) {
+    size_t total = 1u << 30;
+    const char *out_path = "/dev/null";
+    int opt;
+    while ((opt = getopt(argc, argv, "s:o:")) != -1) {
+        switch (opt) {
+            case 's': total = parse_size(optarg); break;
+            case 'o': out_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-s bytes] [-o output]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (total < 1) return 2;
+    char *pool = malloc(POOL_BYTES);
+    if (!pool) { perror("malloc"); return 1; }
+    size_t pool_len = make_lines(pool, POOL_BYTES);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("=== Filter mode: %.2f GiB through a pipe into %s, %ld CPU(s) ===\n\n", (double)total / (1u << 30),
+           out_path, cpus);
+
+    printf("%-22s %8s %8s %9s %9s %10s\n", "path", "seconds", "GB/s", "user s", "sys s", "CPU s/GB");
+    int ok = 1;
+    batch_result_t r[2] = { { 0 } };
+    double secs[RUN_SPLICE_STATS + 1];
+    for (run_t k = RUN_STDIO; k <= RUN_SPLICE_STATS; k++) {
+        timing_t t = run(k, out_path, pool, pool_len, total, &r[k == RUN_SPLICE_STATS]);
+        secs[k] = t.secs;
+        double cpu = t.user + t.sys;
+        int whole = t.bytes == (int64_t)total;
+        ok &= whole;
+        printf("%-22s %8.3f %8.2f %9.3f %9.3f %10.3f %s%s\n", run_names[k], t.secs,
+               (double)total / t.secs / 1e9, t.user, t.sys, cpu / ((double)total / 1e9), whole ? "✅" : "❌ bytes lost",
+               (k == RUN_SPLICE || k == RUN_SPLICE_STATS) && t.used != PASS_SPLICE ? " (copied: cannot splice)" : "");
+    }
+    int same = r[0].lines == r[1].lines && r[0].tokens == r[1].tokens && r[0].ints == r[1].ints &&
+               r[0].sum == r[1].sum;
+    ok &= same;
+    printf("\nstatistics: %llu lines, %llu tokens, %llu integers (sum %lld), both paths %s\n",
+           (unsigned long long)r[1].lines, (unsigned long long)r[1].tokens, (unsigned long long)r[1].ints,
+           (long long)r[1].sum, same ? "agree ✅" : "differ ❌");
+    double gain = secs[RUN_COPY_STATS] / secs[RUN_SPLICE_STATS];
+    printf("with statistics, tee + splice vs read + write: %.2fx (%s here)\n", gain,
+           gain >= 1.0 ? "faster" : "slower");
+    free(pool);
+
+    printf("\nTakeaway:\n");
+    printf("  • read + write copies every byte into the process and out again; splice moves\n"
+           "    page references between pipe and output, so sys time drops and user time\n"
+           "    all but vanishes when nothing needs to look at the data.\n");
+    printf("  • With statistics the tokenizer dominates and the bytes must enter the\n"
+           "    process anyway: tee + splice trades the write-side copy for an extra\n"
+           "    syscall and pipe per chunk, which can cost more than it saves (ratio\n"
+           "    above). Zero-copy pays off when the filter does little per byte.\n");
+    printf("  • fgets + fputs pays per line on top of the copies; a filter should move chunks.\n\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,612 @@
+// report_index.c
+// Segment-based inverted index over io_demo REPORT files.
+// See report_index.h; used by report_search.c and report_index_bench.c.
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lzblock.h"
+#include "report_index.h"
+
+#define SEG_MAGIC  "RIDXSEG1"
+#define HEAD_BYTES 256          // file prefix hashed to notice a rewrite
+#define END_LINE   "---- END REPORT ----"
+
+/* ============================ On-disk layout ============================= */
+// Segment: [hdr][file table][term dictionary][blob: names + keys][postings],
+// every part 8-byte aligned so the mmap can be read in place.
+typedef struct {
+    char magic[8];
+    uint64_t bytes;             // whole segment, header included
+    uint32_t nfiles, nterms;
+    uint64_t files_off, dict_off, blob_off, post_off;   // from segment start
+} seg_hdr_t;
+
+typedef struct {
+    uint64_t upto;              // bytes of the file indexed so far
+    uint64_t head_hash;         // FNV-1a of the first min(upto, HEAD_BYTES) bytes
+    uint32_t reports;           // REPORT blocks in [0, upto)
+    uint32_t name_off, name_len, pad_;
+} seg_file_t;
+
+typedef struct {                // sorted by key
+    uint32_t key_off, key_len;  // in the blob
+    uint64_t post_off;          // from the segment's post_off
+    uint32_t post_len, nhits;
+} seg_term_t;
+
+/* ============================== Byte buffer ============================== */
+typedef struct {
+    char *p;
+    size_t len, cap;
+} buf_t;
+
+static int buf_put_(buf_t *b, const void *d, size_t n) {
+    if (b->len + n > b->cap) {
+        size_t nc = b->cap ? b->cap * 2 : 4096;
+        while (nc < b->len + n) nc *= 2;
+        char *np = realloc(b->p, nc);
+        if (!np) return -1;
+        b->p = np;
+        b->cap = nc;
+    }
+    if (n) memcpy(b->p + b->len, d, n);
+    b->len += n;
+    return 0;
+}
+
+static int buf_pad8_(buf_t *b) {
+    static const char zero[8];
+    return buf_put_(b, zero, (8 - b->len % 8) % 8);
+}
+
+// LEB128: 7 bits per byte, high bit = "more follows". Positions, report
+// numbers and file-id deltas are small, so nearly every field is one byte.
+static int buf_varint_(buf_t *b, uint64_t v) {
+    uint8_t t[10];
+    size_t n = 0;
+    while (v >= 0x80) { t[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+    t[n++] = (uint8_t)v;
+    return buf_put_(b, t, n);
+}
+
+static uint64_t get_varint_(const uint8_t **p, const uint8_t *end) {
+    uint64_t v = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t c = *(*p)++;
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) break;
+    }
+    return v;
+}
+
+static uint64_t fnv1a_(const char *s, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)s[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+static int keycmp_(const char *a, size_t alen, const char *b, size_t blen) {
+    int c = memcmp(a, b, alen < blen ? alen : blen);
+    return c ? c : (alen > blen) - (alen < blen);
+}
+
+/* ================================ Builder ================================ */
+typedef struct { uint32_t file, report, pos; } posting_t;
+
+typedef struct {
+    uint32_t key_off, key_len;  // in builder blob
+    posting_t *v;
+    uint32_t n, cap;
+} term_t;
+
+typedef struct { const char *tok; uint32_t len, pos; } pending_t;
+
+typedef struct {
+    term_t *terms;
+    size_t nterms, terms_cap;
+    uint32_t *table;            // term index + 1, 0 = empty
+    size_t table_cap;
+    seg_file_t *files;
+    size_t nfiles, files_cap;
+    buf_t blob;                 // file names and term keys
+    pending_t *pend;            // tokens of the REPORT block being read
+    size_t npend, pend_cap;
+} builder_t;
+
+static void builder_free_(builder_t *b) {
+    for (size_t i = 0; i < b->nterms; i++) free(b->terms[i].v);
+    free(b->terms);
+    free(b->table);
+    free(b->files);
+    free(b->blob.p);
+    free(b->pend);
+}
+
+static int table_grow_(builder_t *b) {
+    size_t ncap = b->table_cap ? b->table_cap * 2 : 1024;
+    uint32_t *nt = calloc(ncap, sizeof(uint32_t));
+    if (!nt) return -1;
+    for (size_t t = 0; t < b->nterms; t++) {
+        const term_t *e = &b->terms[t];
+        size_t i = fnv1a_(b->blob.p + e->key_off, e->key_len) & (ncap - 1);
+        while (nt[i]) i = (i + 1) & (ncap - 1);
+        nt[i] = (uint32_t)t + 1;
+    }
+    free(b->table);
+    b->table = nt;
+    b->table_cap = ncap;
+    return 0;
+}
+
+static term_t *builder_term_(builder_t *b, const char *tok, size_t len) {
+    if ((b->nterms + 1) * 2 > b->table_cap && table_grow_(b) != 0) return NULL;
+    size_t mask = b->table_cap - 1;
+    size_t i = fnv1a_(tok, len) & mask;
+    for (; b->table[i]; i = (i + 1) & mask) {
+        term_t *e = &b->terms[b->table[i] - 1];
+        if (e->key_len == len && memcmp(b->blob.p + e->key_off, tok, len) == 0) return e;
+    }
+    if (b->nterms == b->terms_cap) {
+        size_t nc = b->terms_cap ? b->terms_cap * 2 : 256;
+        term_t *nt = realloc(b->terms, nc * sizeof(term_t));
+        if (!nt) return NULL;
+        b->terms = nt;
+        b->terms_cap = nc;
+    }
+    term_t *e = &b->terms[b->nterms];
+    *e = (term_t){ .key_off = (uint32_t)b->blob.len, .key_len = (uint32_t)len };
+    if (buf_put_(&b->blob, tok, len) != 0) return NULL;
+    b->table[i] = (uint32_t)++b->nterms;
+    return e;
+}
+
+static int term_push_(term_t *e, posting_t p) {
+    if (e->n == e->cap) {
+        uint32_t nc = e->cap ? e->cap * 2 : 4;
+        posting_t *nv = realloc(e->v, nc * sizeof(posting_t));
+        if (!nv) return -1;
+        e->v = nv;
+        e->cap = nc;
+    }
+    e->v[e->n++] = p;
+    return 0;
+}
+
+// A file's text: read as is, or decoded if it is LZB framed (io_demo and
+// batch reports written with RSUM_COMPRESS). Offsets (upto, from) always
+// count text bytes, so a compressed file is indexed like its plain twin.
+typedef struct {
+    char *mem;                  // malloc'd
+    const char *p;              // text from `from` on
+    size_t n;
+    uint64_t size;              // whole text
+    int framed;                 // mem holds the text from byte 0
+} text_t;
+
+static int text_load_(FILE *f, uint64_t from, text_t *t) {
+    memset(t, 0, sizeof(*t));
+    int framed = lzb_is_framed(fileno(f));
+    if (framed < 0) return -1;
+    if (framed) {
+        lzb_span_t sp;
+        if (lzb_read(fileno(f), 0, 1, &sp) != 0) return -1;
+        t->mem = sp.data;
+        t->size = sp.len;
+        t->framed = 1;
+        t->n = sp.len > from ? sp.len - (size_t)from : 0;
+        t->p = t->mem + (sp.len - t->n);
+        return 0;
+    }
+    if (fseek(f, 0, SEEK_END) != 0) return -1;
+    long size = ftell(f);
+    if (size < 0) return -1;
+    t->size = (uint64_t)size;
+    t->n = t->size > from ? (size_t)(t->size - from) : 0;
+    t->mem = malloc(t->n ? t->n : 1);
+    if (!t->mem) return -1;
+    t->p = t->mem;
+    if (t->n && (fseek(f, (long)from, SEEK_SET) != 0 || fread(t->mem, 1, t->n, f) != t->n)) {
+        free(t->mem);
+        t->mem = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Hash of the first min(upto, HEAD_BYTES) text bytes; 0 if the read fails.
+static uint64_t head_hash_(FILE *f, const text_t *t, uint64_t upto) {
+    char head[HEAD_BYTES];
+    size_t want = upto < HEAD_BYTES ? (size_t)upto : HEAD_BYTES;
+    if (t->framed) return want <= t->size ? fnv1a_(t->mem, want) : 0;
+    if (fseek(f, 0, SEEK_SET) != 0 || fread(head, 1, want, f) != want) return 0;
+    return fnv1a_(head, want);
+}
+
+// Index complete REPORT blocks in [from, EOF) of path, numbering them after
+// the `reports` blocks already indexed. Adds a file-table entry only if at
+// least one new block was found.
+static int builder_file_(builder_t *b, const char *path, uint64_t from, uint32_t reports) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    int rc = -1;
+    text_t t;
+    if (text_load_(f, from, &t) != 0) goto out;     // t is zeroed first
+    const char *buf = t.p;
+    size_t n = t.n;
+
+    uint32_t fid = (uint32_t)b->nfiles, report = reports, done = reports;
+    uint64_t upto = from;
+    int in_report = 0;
+    const char *end = buf + n;
+    for (const char *line = buf; line < end;) {
+        const char *nl = memchr(line, '\n', (size_t)(end - line));
+        if (!nl) break;                         // unfinished line: next update
+        size_t ll = (size_t)(nl - line);
+        if (ll == 6 && memcmp(line, "REPORT", 6) == 0) {
+            in_report = 1;
+            report++;
+            b->npend = 0;
+        } else if (in_report && ll == sizeof(END_LINE) - 1 && memcmp(line, END_LINE, ll) == 0) {
+            // Block complete: only now do its tokens become postings.
+            for (size_t i = 0; i < b->npend; i++) {
+                term_t *e = builder_term_(b, b->pend[i].tok, b->pend[i].len);
+                if (!e || term_push_(e, (posting_t){ fid, report, b->pend[i].pos }) != 0) goto out;
+            }
+            in_report = 0;
+            done = report;
+            upto = from + (uint64_t)(nl + 1 - buf);
+        } else if (in_report && ll > 8 && memcmp(line, "token[", 6) == 0) {
+            const char *p = line + 6;
+            uint32_t pos = 0;
+            while (p < nl && *p >= '0' && *p <= '9') pos = pos * 10 + (uint32_t)(*p++ - '0');
+            if (p + 1 < nl && p[0] == ']' && p[1] == '=') {
+                if (b->npend == b->pend_cap) {
+                    size_t nc = b->pend_cap ? b->pend_cap * 2 : 64;
+                    pending_t *np = realloc(b->pend, nc * sizeof(pending_t));
+                    if (!np) goto out;
+                    b->pend = np;
+                    b->pend_cap = nc;
+                }
+                b->pend[b->npend++] = (pending_t){ p + 2, (uint32_t)(nl - p - 2), pos };
+            }
+        }
+        line = nl + 1;
+    }
+
+    if (upto > from) {
+        if (b->nfiles == b->files_cap) {
+            size_t nc = b->files_cap ? b->files_cap * 2 : 16;
+            seg_file_t *nf = realloc(b->files, nc * sizeof(seg_file_t));
+            if (!nf) goto out;
+            b->files = nf;
+            b->files_cap = nc;
+        }
+        size_t name_len = strlen(path);
+        b->files[b->nfiles++] = (seg_file_t){
+            .upto = upto, .head_hash = head_hash_(f, &t, upto), .reports = done,
+            .name_off = (uint32_t)b->blob.len, .name_len = (uint32_t)name_len,
+        };
+        if (buf_put_(&b->blob, path, name_len) != 0) goto out;
+    }
+    rc = 0;
+out:
+    free(t.mem);
+    fclose(f);
+    return rc;
+}
+
+typedef struct { const char *key; uint32_t len, idx; } sort_key_t;
+
+static int sort_key_cmp_(const void *pa, const void *pb) {
+    const sort_key_t *a = pa, *b = pb;
+    return keycmp_(a->key, a->len, b->key, b->len);
+}
+
+// Serialize the builder as one segment into out.
+static int builder_emit_(builder_t *b, buf_t *out) {
+    int rc = -1;
+    buf_t post = { 0 };
+    sort_key_t *order = malloc((b->nterms ? b->nterms : 1) * sizeof(sort_key_t));
+    seg_term_t *dict = malloc((b->nterms ? b->nterms : 1) * sizeof(seg_term_t));
+    if (!order || !dict) goto out;
+    for (size_t i = 0; i < b->nterms; i++)
+        order[i] = (sort_key_t){ b->blob.p + b->terms[i].key_off, b->terms[i].key_len, (uint32_t)i };
+    qsort(order, b->nterms, sizeof(*order), sort_key_cmp_);
+
+    for (size_t i = 0; i < b->nterms; i++) {
+        const term_t *e = &b->terms[order[i].idx];
+        size_t start = post.len;
+        for (uint32_t j = 0; j < e->n; j++) {
+            const posting_t *p = &e->v[j];
+            uint32_t pf = j ? e->v[j - 1].file : 0, pr = j ? e->v[j - 1].report : 0;
+            int new_file = j == 0 || p->file != pf;
+            if (buf_varint_(&post, p->file - pf) != 0 ||
+                buf_varint_(&post, new_file ? p->report : p->report - pr) != 0 ||
+                buf_varint_(&post, p->pos) != 0)
+                goto out;
+        }
+        dict[i] = (seg_term_t){ e->key_off, e->key_len, start, (uint32_t)(post.len - start), e->n };
+    }
+
+    seg_hdr_t h = { .nfiles = (uint32_t)b->nfiles, .nterms = (uint32_t)b->nterms };
+    memcpy(h.magic, SEG_MAGIC, 8);
+    size_t base = out->len;
+    if (buf_put_(out, &h, sizeof(h)) != 0) goto out;
+    h.files_off = out->len - base;
+    if (buf_put_(out, b->files, b->nfiles * sizeof(seg_file_t)) != 0) goto out;
+    h.dict_off = out->len - base;
+    if (buf_put_(out, dict, b->nterms * sizeof(seg_term_t)) != 0) goto out;
+    h.blob_off = out->len - base;
+    if (buf_put_(out, b->blob.p, b->blob.len) != 0 || buf_pad8_(out) != 0) goto out;
+    h.post_off = out->len - base;
+    if (buf_put_(out, post.p, post.len) != 0 || buf_pad8_(out) != 0) goto out;
+    h.bytes = out->len - base;
+    memcpy(out->p + base, &h, sizeof(h));
+    rc = 0;
+out:
+    free(order);
+    free(dict);
+    free(post.p);
+    return rc;
+}
+
+static int write_all_(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/* ================================= Build ================================= */
+int ridx_build(const char *index_path, char *const *files, int nfiles) {
+    builder_t b = { 0 };
+    buf_t seg = { 0 };
+    int rc = -1, fd = -1;
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", index_path) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    for (int i = 0; i < nfiles; i++)
+        if (builder_file_(&b, files[i], 0, 0) != 0) goto out;
+    if (builder_emit_(&b, &seg) != 0) goto out;
+
+    // Write-then-rename: a concurrent query sees the old or the new index.
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || write_all_(fd, seg.p, seg.len) != 0) goto out;
+    if (close(fd) != 0) { fd = -1; goto out; }
+    fd = -1;
+    if (rename(tmp, index_path) != 0) goto out;
+    rc = 0;
+out:
+    if (fd >= 0) close(fd);
+    if (rc != 0) unlink(tmp);
+    builder_free_(&b);
+    free(seg.p);
+    return rc;
+}
+
+/* ================================ Reader ================================= */
+struct ridx {
+    char *map;
+    size_t len, valid;          // valid: bytes covered by intact segments
+    int nseg;
+    const char **seg;
+};
+
+ridx_t *ridx_open(const char *index_path) {
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    ridx_t *ix = calloc(1, sizeof(*ix));
+    if (!ix || fstat(fd, &st) != 0) goto fail;
+    ix->len = (size_t)st.st_size;
+    if (ix->len) {
+        ix->map = mmap(NULL, ix->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ix->map == MAP_FAILED) { ix->map = NULL; goto fail; }
+    }
+    close(fd);
+    fd = -1;
+
+    // Walk the segment chain; a torn tail (crash mid-append) is ignored.
+    for (int pass = 0; pass < 2; pass++) {
+        int n = 0;
+        for (size_t off = 0; off + sizeof(seg_hdr_t) <= ix->len;) {
+            const seg_hdr_t *h = (const seg_hdr_t *)(ix->map + off);
+            if (memcmp(h->magic, SEG_MAGIC, 8) != 0 || h->bytes < sizeof(*h) ||
+                h->bytes % 8 || h->bytes > ix->len - off)
+                break;
+            if (pass) ix->seg[n] = ix->map + off;
+            n++;
+            off += h->bytes;
+            ix->valid = off;
+        }
+        if (!pass) {
+            ix->nseg = n;
+            ix->seg = calloc(n ? (size_t)n : 1, sizeof(*ix->seg));
+            if (!ix->seg) goto fail;
+        }
+    }
+    return ix;
+fail:
+    if (fd >= 0) close(fd);
+    ridx_close(ix);
+    return NULL;
+}
+
+void ridx_close(ridx_t *ix) {
+    if (!ix) return;
+    if (ix->map) munmap(ix->map, ix->len);
+    free(ix->seg);
+    free(ix);
+}
+
+static const seg_term_t *seg_find_(const char *seg, const char *tok, size_t len) {
+    const seg_hdr_t *h = (const seg_hdr_t *)seg;
+    const seg_term_t *d = (const seg_term_t *)(seg + h->dict_off);
+    const char *blob = seg + h->blob_off;
+    size_t lo = 0, hi = h->nterms;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = keycmp_(blob + d[mid].key_off, d[mid].key_len, tok, len);
+        if (c == 0) return &d[mid];
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return NULL;
+}
+
+size_t ridx_query(const ridx_t *ix, const char *tok, size_t len, ridx_hit_fn fn, void *arg) {
+    size_t count = 0;
+    for (int s = 0; s < ix->nseg; s++) {
+        const char *seg = ix->seg[s];
+        const seg_term_t *t = seg_find_(seg, tok, len);
+        if (!t) continue;
+        if (!fn) { count += t->nhits; continue; }
+        const seg_hdr_t *h = (const seg_hdr_t *)seg;
+        const seg_file_t *files = (const seg_file_t *)(seg + h->files_off);
+        const uint8_t *p = (const uint8_t *)seg + h->post_off + t->post_off, *end = p + t->post_len;
+        uint32_t file = 0, report = 0;
+        for (uint32_t i = 0; i < t->nhits; i++) {
+            uint64_t fd = get_varint_(&p, end), r = get_varint_(&p, end);
+            file += (uint32_t)fd;
+            report = (i == 0 || fd) ? (uint32_t)r : report + (uint32_t)r;
+            if (file >= h->nfiles) break;       // corrupt: stop rather than read wild
+            ridx_hit_t hit = { seg + h->blob_off + files[file].name_off, files[file].name_len,
+                               report, (uint32_t)get_varint_(&p, end) };
+            count++;
+            if (fn(&hit, arg)) return count;
+        }
+    }
+    return count;
+}
+
+void ridx_info(const ridx_t *ix, ridx_info_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->segments = ix->nseg;
+    out->bytes = ix->len;
+    for (int s = 0; s < ix->nseg; s++) {
+        const seg_hdr_t *h = (const seg_hdr_t *)ix->seg[s];
+        const seg_term_t *d = (const seg_term_t *)(ix->seg[s] + h->dict_off);
+        out->files += h->nfiles;
+        out->terms += h->nterms;
+        for (uint32_t t = 0; t < h->nterms; t++) out->postings += d[t].nhits;
+    }
+}
+
+/* ================================ Update ================================= */
+// Newest file-table entry for name across all segments, or NULL.
+static const seg_file_t *latest_file_(const ridx_t *ix, const char *name, size_t len) {
+    for (int s = ix->nseg - 1; s >= 0; s--) {
+        const seg_hdr_t *h = (const seg_hdr_t *)ix->seg[s];
+        const seg_file_t *f = (const seg_file_t *)(ix->seg[s] + h->files_off);
+        const char *blob = ix->seg[s] + h->blob_off;
+        for (uint32_t i = 0; i < h->nfiles; i++)
+            if (f[i].name_len == len && memcmp(blob + f[i].name_off, name, len) == 0) return &f[i];
+    }
+    return NULL;
+}
+
+// Still the file we indexed: at least as long, and the same first bytes.
+static int file_unchanged_(const char *path, const seg_file_t *e) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    text_t t;                                       // size only (a compressed file is decoded)
+    int ok = text_load_(f, UINT64_MAX, &t) == 0 && t.size >= e->upto && head_hash_(f, &t, e->upto) == e->head_hash;
+    free(t.mem);
+    fclose(f);
+    return ok;
+}
+
+// Every file the index knows plus the new ones, each once.
+static char **all_files_(const ridx_t *ix, char *const *files, int nfiles, int *n_out) {
+    size_t cap = (size_t)nfiles;
+    for (int s = 0; s < ix->nseg; s++) cap += ((const seg_hdr_t *)ix->seg[s])->nfiles;
+    char **all = calloc(cap ? cap : 1, sizeof(char *));
+    if (!all) return NULL;
+    int n = 0;
+    for (int s = 0; s < ix->nseg; s++) {
+        const seg_hdr_t *h = (const seg_hdr_t *)ix->seg[s];
+        const seg_file_t *f = (const seg_file_t *)(ix->seg[s] + h->files_off);
+        for (uint32_t i = 0; i < h->nfiles; i++) {
+            const char *name = ix->seg[s] + h->blob_off + f[i].name_off;
+            if (latest_file_(ix, name, f[i].name_len) != &f[i]) continue;   // older entry
+            if (!(all[n++] = strndup(name, f[i].name_len))) goto fail;
+        }
+    }
+    for (int i = 0; i < nfiles; i++) {
+        int dup = 0;
+        for (int j = 0; j < n && !dup; j++) dup = strcmp(all[j], files[i]) == 0;
+        if (!dup && !(all[n++] = strdup(files[i]))) goto fail;
+    }
+    *n_out = n;
+    return all;
+fail:
+    for (int j = 0; j < n; j++) free(all[j]);
+    free(all);
+    return NULL;
+}
+
+int ridx_update(const char *index_path, char *const *files, int nfiles, int *rebuilt) {
+    if (rebuilt) *rebuilt = 0;
+    ridx_t *ix = ridx_open(index_path);
+    if (!ix) return errno == ENOENT ? ridx_build(index_path, files, nfiles) : -1;
+
+    builder_t b = { 0 };
+    buf_t seg = { 0 };
+    int rc = -1, stale = 0;
+    for (int i = 0; i < nfiles && !stale; i++) {
+        size_t len = strlen(files[i]);
+        int seen = 0;                           // listed twice on this call
+        for (size_t j = 0; j < b.nfiles && !seen; j++)
+            seen = b.files[j].name_len == len && memcmp(b.blob.p + b.files[j].name_off, files[i], len) == 0;
+        if (seen) continue;
+        const seg_file_t *e = latest_file_(ix, files[i], len);
+        if (e && !file_unchanged_(files[i], e)) { stale = 1; break; }
+        if (builder_file_(&b, files[i], e ? e->upto : 0, e ? e->reports : 0) != 0) goto out;
+    }
+
+    if (stale) {
+        int n = 0;
+        char **all = all_files_(ix, files, nfiles, &n);
+        if (!all) goto out;
+        ridx_close(ix);
+        ix = NULL;
+        rc = ridx_build(index_path, all, n);
+        for (int j = 0; j < n; j++) free(all[j]);
+        free(all);
+        if (rc == 0 && rebuilt) *rebuilt = 1;
+        goto out;
+    }
+
+    rc = 0;
+    if (b.nfiles) {                             // something new: append a segment
+        int fd = open(index_path, O_WRONLY);
+        rc = -1;
+        if (fd >= 0) {
+            // Drop a torn tail first, or readers would stop before our segment.
+            if (builder_emit_(&b, &seg) == 0 && ftruncate(fd, (off_t)ix->valid) == 0 &&
+                lseek(fd, 0, SEEK_END) >= 0 && write_all_(fd, seg.p, seg.len) == 0)
+                rc = 0;
+            if (close(fd) != 0) rc = -1;
+        }
+    }
+out:
+    ridx_close(ix);
+    builder_free_(&b);
+    free(seg.p);
+    return rc;
+}
@@ -0,0 +1,70 @@
+// report_index.h
+// Inverted index over io_demo REPORT files: token -> (file, report, position).
+//
+// io_demo writes one REPORT block per run (more than one per file with -a):
+//     REPORT
+//     ...
+//     token[2]=42          <- indexed: token "42", position 2
+//     ...
+//     ---- END REPORT ----
+// Only complete blocks (up to the last END line) are indexed.
+//
+// On disk the index is a sequence of self-contained segments, each with
+//   - a file table: name, bytes covered so far, REPORT blocks seen so far,
+//     and a hash of the file's first bytes (to notice a rewrite),
+//   - a sorted term dictionary (binary search, fixed-size entries),
+//   - postings as delta-varints: file id delta, report delta within a
+//     file (absolute when the file changes), token position.
+// A query mmaps the file and binary-searches each segment's dictionary,
+// so nothing is parsed or copied up front.
+//
+// ridx_build writes a fresh single-segment index. ridx_update appends one
+// segment holding only the bytes appended since the last build/update
+// (e.g. `io_demo out.txt -a`) plus any new files. A file that shrank or
+// was rewritten (io_demo without -a) makes ridx_update rebuild instead.
+//
+// A compressed report (LZB framed, lzblock.h) is decoded and indexed as
+// its text; byte offsets count text bytes. An update decodes it again in
+// full, since appending rewrites its last block.
+
+#ifndef W4_REPORT_INDEX_H
+#define W4_REPORT_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ridx ridx_t;
+
+typedef struct {
+    const char *file;           // not NUL-terminated
+    size_t file_len;
+    uint32_t report;            // 1-based REPORT block within the file
+    uint32_t pos;               // i in token[i]
+} ridx_hit_t;
+
+// Return non-zero to stop the query early.
+typedef int (*ridx_hit_fn)(const ridx_hit_t *hit, void *arg);
+
+// 0 ok, -1 with errno set (perror-able).
+int ridx_build(const char *index_path, char *const *files, int nfiles);
+
+// Like ridx_build when index_path does not exist yet. *rebuilt (if not
+// NULL) is set to 1 when a rewritten file forced a full rebuild.
+int ridx_update(const char *index_path, char *const *files, int nfiles, int *rebuilt);
+
+// mmap an index for queries; NULL with errno set on failure.
+ridx_t *ridx_open(const char *index_path);
+void ridx_close(ridx_t *ix);
+
+// Calls fn (may be NULL) for every occurrence of the token, oldest segment
+// first; returns the number of occurrences visited.
+size_t ridx_query(const ridx_t *ix, const char *tok, size_t len, ridx_hit_fn fn, void *arg);
+
+typedef struct {
+    int segments;
+    size_t files, terms, postings, bytes;   // files/terms summed over segments
+} ridx_info_t;
+
+void ridx_info(const ridx_t *ix, ridx_info_t *out);
+
+#endif /* W4_REPORT_INDEX_H */
@@ -0,0 +1,245 @@
+// report_index_bench.c
+// Recitation extension: fgets-scanning REPORT files vs an mmap'd inverted index
+//
+// Build:  make report_index_bench
+// Run:    ./report_index_bench                  (2000 files x 3 reports x 32 tokens)
+//         ./report_index_bench -f 10000 -q 100000
+//
+// Generates io_demo-style REPORT files in a temp directory, then measures:
+//   build     index every file from scratch
+//   query     µs per "which reports contain X" (count only / walking every hit)
+//   scan      the fgets way: read every file looking for token[i]=X
+//   update    append one report to 10% of the files (io_demo -a) and
+//             index just the new bytes, vs rebuilding everything
+// and checks that the updated index answers exactly like a fresh build,
+// also after one file is rewritten from scratch (io_demo without -a).
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "report_index.h"
+
+static uint64_t rng = 0x853C49E6748FEA9Bull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static int vocab = 20000, tokens_per_report = 32;
+
+// Zipf-ish token: low ids far more common (id = vocab^u, u uniform).
+static void pick_token(char *out, size_t cap) {
+    double u = (double)(rnd() >> 11) / 9007199254740992.0;
+    unsigned id = (unsigned)exp(u * log((double)vocab)) - 1;
+    if (rnd() % 6 == 0) snprintf(out, cap, "%u", id);
+    else snprintf(out, cap, "tok%u", id);
+}
+
+// Same layout io_demo's Part 4 writes.
+static void write_report(FILE *f, const char *path) {
+    fprintf(f, "REPORT\nargv_count=2\nargv[0]=./io_demo\nargv[1]=%s\n", path);
+    fprintf(f, "line_tokens=%d\n", tokens_per_report);
+    for (int i = 0; i < tokens_per_report; i++) {
+        char tok[32];
+        pick_token(tok, sizeof(tok));
+        fprintf(f, "token[%d]=%s\n", i, tok);
+    }
+    fprintf(f, "numeric_tokens=0\n---- END REPORT ----\n");
+}
+
+static int write_file(const char *path, int reports, const char *mode) {
+    FILE *f = fopen(path, mode);
+    if (!f) { perror(path); return -1; }
+    for (int r = 0; r < reports; r++) write_report(f, path);
+    return fclose(f);
+}
+
+// The fgets way: every file, every line.
+static size_t scan_count(char **files, int nfiles, const char *tok) {
+    size_t n = 0, tl = strlen(tok);
+    char line[256];
+    for (int i = 0; i < nfiles; i++) {
+        FILE *f = fopen(files[i], "r");
+        if (!f) continue;
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "token[", 6) != 0) continue;
+            char *eq = strchr(line, '=');
+            if (eq && strncmp(eq + 1, tok, tl) == 0 && eq[1 + tl] == '\n') n++;
+        }
+        fclose(f);
+    }
+    return n;
+}
+
+// Order-independent digest of a token's hit list.
+static int digest_hit(const ridx_hit_t *h, void *arg) {
+    uint64_t x = h->report * 0x9E3779B97F4A7C15ull ^ h->pos * 0xC2B2AE3D27D4EB4Full;
+    for (size_t i = 0; i < h->file_len; i++) x = (x ^ (unsigned char)h->file[i]) * 0x100000001B3ull;
+    *(uint64_t *)arg += x;
+    return 0;
+}
+
+static int count_hit(const ridx_hit_t *h, void *arg) {
+    (void)h;
+    ++*(size_t *)arg;
+    return 0;
+}
+
+// Same answers from both indexes for a sample of tokens?
+static int same_answers(const ridx_t *a, const ridx_t *b, int samples) {
+    for (int i = 0; i < samples; i++) {
+        char tok[32];
+        pick_token(tok, sizeof(tok));
+        uint64_t da = 0, db = 0;
+        size_t na = ridx_query(a, tok, strlen(tok), digest_hit, &da);
+        size_t nb = ridx_query(b, tok, strlen(tok), digest_hit, &db);
+        if (na != nb || da != db) {
+            printf("❌ \"%s\": %zu hits vs %zu (digest %llx vs %llx)\n", tok, na, nb,
+                   (unsigned long long)da, (unsigned long long)db);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static double ms_since(uint64_t t0) { return (double)(timing_now_ns() - t0) / 1e6; }
+
+int main(int argc, char **argv) {
+    int nfiles = 2000, reports = 3, queries = 20000, opt, rc = 1;
+    char (*sample)[32] = NULL;
+    char **upd = NULL;
+    while ((opt = getopt(argc, argv, "f:r:t:V:q:")) != -1) {
+        switch (opt) {
+            case 'f': nfiles = atoi(optarg); break;
+            case 'r': reports = atoi(optarg); break;
+            case 't': tokens_per_report = atoi(optarg); break;
+            case 'V': vocab = atoi(optarg); break;
+            case 'q': queries = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f files] [-r reports] [-t tokens] [-V vocab] [-q queries]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (nfiles < 10 || reports < 1 || vocab < 2 || queries < 1) { fprintf(stderr, "bad arguments\n"); return 2; }
+
+    char dir[] = "/tmp/report_index_bench.XXXXXX";
+    if (!mkdtemp(dir)) { perror("mkdtemp"); return 1; }
+    char **files = calloc((size_t)nfiles, sizeof(char *));
+    if (!files) { perror("calloc"); rmdir(dir); return 1; }
+    char idx[64], fresh[64];
+    snprintf(idx, sizeof(idx), "%s/reports.idx", dir);
+    snprintf(fresh, sizeof(fresh), "%s/fresh.idx", dir);
+    size_t report_bytes = 0;
+    for (int i = 0; i < nfiles; i++) {
+        files[i] = malloc(64);
+        if (!files[i]) goto out;
+        snprintf(files[i], 64, "%s/out%05d.txt", dir, i);
+        if (write_file(files[i], reports, "w") != 0) goto out;
+    }
+    for (int i = 0; i < nfiles; i++) {
+        FILE *f = fopen(files[i], "r");
+        fseek(f, 0, SEEK_END);
+        report_bytes += (size_t)ftell(f);
+        fclose(f);
+    }
+
+    printf("=== REPORT index: %d files x %d reports x %d tokens (%.1f MiB), vocab %d ===\n\n",
+           nfiles, reports, tokens_per_report, (double)report_bytes / (1 << 20), vocab);
+    uint64_t t0 = timing_now_ns();
+    if (ridx_build(idx, files, nfiles) != 0) { perror("ridx_build"); goto out; }
+    printf("build            %9.2f ms\n", ms_since(t0));
+
+    ridx_t *ix = ridx_open(idx);
+    if (!ix) { perror("ridx_open"); goto out; }
+    ridx_info_t in;
+    ridx_info(ix, &in);
+    printf("index            %9.2f MiB  (%zu terms, %zu postings, %.2f B/posting)\n",
+           (double)in.bytes / (1 << 20), in.terms, in.postings, (double)in.bytes / (double)in.postings);
+
+    // Queries: a fixed token sample, so count-only and walk see the same work.
+    sample = malloc((size_t)queries * sizeof(*sample));
+    if (!sample) { perror("malloc"); goto out; }
+    for (int q = 0; q < queries; q++) pick_token(sample[q], 32);
+    size_t total = 0, walked = 0;
+    t0 = timing_now_ns();
+    for (int q = 0; q < queries; q++) total += ridx_query(ix, sample[q], strlen(sample[q]), NULL, NULL);
+    double us_count = (double)(timing_now_ns() - t0) / 1e3 / queries;
+    t0 = timing_now_ns();
+    for (int q = 0; q < queries; q++) ridx_query(ix, sample[q], strlen(sample[q]), count_hit, &walked);
+    double us_walk = (double)(timing_now_ns() - t0) / 1e3 / queries;
+    printf("query (count)    %9.2f µs   avg %.1f hits\n", us_count, (double)total / queries);
+    printf("query (walk)     %9.2f µs\n", us_walk);
+    if (walked != total) { printf("❌ walked %zu hits, counted %zu\n", walked, total); goto out; }
+
+    int scans = queries < 20 ? queries : 20;
+    t0 = timing_now_ns();
+    for (int q = 0; q < scans; q++) {
+        size_t want = ridx_query(ix, sample[q], strlen(sample[q]), NULL, NULL);
+        size_t got = scan_count(files, nfiles, sample[q]);
+        if (got != want) { printf("❌ scan found %zu \"%s\", index %zu\n", got, sample[q], want); goto out; }
+    }
+    double us_scan = (double)(timing_now_ns() - t0) / 1e3 / scans;
+    printf("fgets scan       %9.0f µs   (%.0fx slower than the index)\n", us_scan, us_scan / us_count);
+    ridx_close(ix);
+
+    // Incremental: io_demo -a on 10% of the files.
+    int touched = nfiles / 10;
+    upd = malloc((size_t)touched * sizeof(char *));
+    if (!upd) { perror("malloc"); goto out; }
+    for (int i = 0; i < touched; i++) {
+        upd[i] = files[(size_t)i * 10];
+        if (write_file(upd[i], 1, "a") != 0) goto out;
+    }
+    t0 = timing_now_ns();
+    int rebuilt = 0;
+    if (ridx_update(idx, upd, touched, &rebuilt) != 0) { perror("ridx_update"); goto out; }
+    double ms_upd = ms_since(t0);
+    t0 = timing_now_ns();
+    if (ridx_build(fresh, files, nfiles) != 0) { perror("ridx_build"); goto out; }
+    double ms_full = ms_since(t0);
+    printf("\nappend 1 report to %d files:\n", touched);
+    printf("update           %9.2f ms%s\n", ms_upd, rebuilt ? "  (rebuilt!)" : "");
+    printf("full rebuild     %9.2f ms   (%.0fx the update)\n", ms_full, ms_full / ms_upd);
+
+    ridx_t *a = ridx_open(idx), *b = ridx_open(fresh);
+    if (!a || !b || !same_answers(a, b, 5000)) goto out;
+    ridx_info(a, &in);
+    printf("✅ updated index (%d segments) answers like a fresh build\n", in.segments);
+    ridx_close(a);
+    ridx_close(b);
+
+    // io_demo without -a truncates: the old postings for that file are wrong.
+    if (write_file(files[1], 1, "w") != 0) goto out;
+    if (ridx_update(idx, &files[1], 1, &rebuilt) != 0 || ridx_build(fresh, files, nfiles) != 0) {
+        perror("update/build");
+        goto out;
+    }
+    a = ridx_open(idx);
+    b = ridx_open(fresh);
+    if (!a || !b || !rebuilt || !same_answers(a, b, 5000)) {
+        if (!rebuilt) printf("❌ rewritten file not detected\n");
+        goto out;
+    }
+    printf("✅ rewritten file detected; rebuilt index matches\n");
+    ridx_close(a);
+    ridx_close(b);
+
+    printf("\nTakeaway:\n");
+    printf("  • The index turns a scan of every file into one binary search per\n"
+           "    segment over an mmap'd dictionary: no parsing or allocation per query.\n");
+    printf("  • Appends cost O(new bytes): each update adds a small segment.\n\n");
+    rc = 0;
+out:
+    for (int i = 0; i < nfiles && files[i]; i++) { unlink(files[i]); free(files[i]); }
+    unlink(idx);
+    unlink(fresh);
+    rmdir(dir);
+    free(files);
+    free(sample);
+    free(upd);
+    return rc;
+}
@@ -0,0 +1,246 @@
+// reportsum.c
+// Per-record and per-file CRC32C for REPORT files. See reportsum.h; used by
+// io_demo.c (Parts 4 and 5) and crc32c_bench.c.
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/crc32c.h"
+#include "lzblock.h"
+#include "reportsum.h"
+
+#define END_LINE      "---- END REPORT ----\n"
+#define FOOTER_PREFIX "FOOTER crc32c="
+
+static bool parse_footer_(const char *p, size_t n, uint32_t *crc, uint64_t *bytes) {
+    if (n != RSUM_FOOTER_LEN || p[n - 1] != '\n' || memcmp(p, FOOTER_PREFIX, sizeof(FOOTER_PREFIX) - 1) != 0)
+        return false;
+    char tmp[RSUM_FOOTER_LEN + 1];
+    memcpy(tmp, p, n);
+    tmp[n] = '\0';
+    unsigned c;
+    unsigned long long b;
+    if (sscanf(tmp, FOOTER_PREFIX "%8x bytes=%20llu", &c, &b) != 2) return false;
+    *crc = c;
+    *bytes = b;
+    return true;
+}
+
+void rsum_verify_init(rsum_verify_t *v, uint64_t offset, uint32_t crc) {
+    v->file_crc = crc;
+    v->bytes = offset;
+    v->rec_base = 0;
+    v->rec_len = 0;
+    v->in_record = false;
+    v->line_start = true;
+    v->records_ok = v->records_bad = v->records_unchecked = 0;
+    v->footer = 0;
+}
+
+uint32_t rsum_verify_crc(rsum_verify_t *v) {
+    return v->file_crc;
+}
+
+// CRC32C of a record body from the file CRC before it (base) and after it
+// (end). Continuing a CRC is affine in the start value:
+//     crc32c(base, body) == crc32c(0, body) ^ ~crc32c(~base, len zero bytes)
+// so one pass over zeros per record replaces a second CRC call per line.
+static uint32_t record_crc_(uint32_t base, uint32_t end, uint64_t len) {
+    static const unsigned char zero[4096];
+    uint32_t c = ~base;
+    while (len) {
+        size_t k = len < sizeof(zero) ? (size_t)len : sizeof(zero);
+        c = crc32c(c, zero, k);
+        len -= k;
+    }
+    return end ^ ~c;
+}
+
+// The 8 hex digits of a crc32c= line; false if any is missing.
+static bool parse_hex8_(const char *p, size_t n, uint32_t *out) {
+    if (n < 8) return false;
+    uint32_t x = 0;
+    for (int i = 0; i < 8; i++) {
+        unsigned c = (unsigned char)p[i], d;
+        if (c - '0' < 10) d = c - '0';
+        else if ((c | 0x20) - 'a' < 6) d = (c | 0x20) - 'a' + 10;
+        else return false;
+        x = x << 4 | d;
+    }
+    *out = x;
+    return true;
+}
+
+bool rsum_verify_feed(rsum_verify_t *v, const char *p, size_t n) {
+    if (!n) return false;
+    bool start = v->line_start;
+    v->line_start = p[n - 1] == '\n';
+    // Only a line starting with F, R, c or - can be special: field lines,
+    // nearly all of them, skip every comparison.
+    if (start && p[0] == 'F' && n >= sizeof(FOOTER_PREFIX) - 1 &&
+        memcmp(p, FOOTER_PREFIX, sizeof(FOOTER_PREFIX) - 1) == 0) {
+        uint32_t crc;
+        uint64_t bytes;
+        bool ok = parse_footer_(p, n, &crc, &bytes) && crc == v->file_crc && bytes == v->bytes;
+        v->footer = ok ? 1 : -1;
+        return true;
+    }
+    v->footer = 0;                              // data after a footer: it no longer covers the file
+
+    if (start && p[0] == 'R' && n == 7 && memcmp(p, "REPORT\n", 7) == 0) {
+        if (v->in_record) v->records_unchecked++;   // previous record never finished
+        v->in_record = true;
+        v->rec_base = v->file_crc;
+        v->rec_len = 0;
+    } else if (v->in_record && start && p[0] == 'c' && n > 7 && memcmp(p, "crc32c=", 7) == 0) {
+        uint32_t want;
+        bool ok = parse_hex8_(p + 7, n - 7, &want) && want == record_crc_(v->rec_base, v->file_crc, v->rec_len);
+        if (ok) v->records_ok++;
+        else v->records_bad++;
+        v->in_record = false;
+    } else if (v->in_record && start && p[0] == '-' && n == sizeof(END_LINE) - 1 && memcmp(p, END_LINE, n) == 0) {
+        v->records_unchecked++;                 // written before records had checksums
+        v->in_record = false;
+    }
+    // One CRC call, on the bytes where the caller already has them.
+    v->file_crc = crc32c(v->file_crc, p, n);
+    v->bytes += n;
+    if (v->in_record) v->rec_len += n;
+    return false;
+}
+
+// Where the next record goes, the CRC of everything before it and the data
+// byte count: the footer says so if it is intact, otherwise read the whole
+// file once.
+static int tail_(int fd, const char *path, uint64_t *end, uint32_t *crc, uint64_t *count) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    uint64_t size = (uint64_t)st.st_size;
+    *end = *count = size;
+    *crc = 0;
+    if (size == 0) return 0;
+    char foot[RSUM_FOOTER_LEN];
+    uint64_t bytes;
+    if (size >= RSUM_FOOTER_LEN &&
+        pread(fd, foot, sizeof(foot), (off_t)(size - RSUM_FOOTER_LEN)) == (ssize_t)sizeof(foot) &&
+        parse_footer_(foot, sizeof(foot), crc, &bytes) && bytes == size - RSUM_FOOTER_LEN) {
+        *end = *count = bytes;
+        return 0;
+    }
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    rsum_verify_t v;
+    rsum_verify_init(&v, 0, 0);
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while ((n = getline(&line, &cap, f)) > 0) rsum_verify_feed(&v, line, (size_t)n);
+    free(line);
+    fclose(f);
+    *crc = rsum_verify_crc(&v);
+    *count = v.bytes;                               // a damaged old footer is not data
+    return 0;
+}
+
+// The same for a compressed file, where the footer ends the last block:
+// *tail gets that block's text without the footer (malloc'd), which the
+// caller rewrites from *off (file) / *raw_off (text) with the new record.
+static int lz_tail_(int fd, uint64_t *off, uint64_t *raw_off, char **tail, size_t *tail_len,
+                    uint32_t *crc, uint64_t *count) {
+    lzb_span_t sp;
+    uint64_t bytes;
+    if (lzb_last_block(fd, off) != 0 || lzb_read(fd, *off, 1, &sp) != 0) return -1;
+    if (sp.len >= RSUM_FOOTER_LEN &&
+        parse_footer_(sp.data + sp.len - RSUM_FOOTER_LEN, RSUM_FOOTER_LEN, crc, &bytes) &&
+        bytes == sp.raw_off + sp.len - RSUM_FOOTER_LEN) {
+        *raw_off = sp.raw_off;
+        *tail = sp.data;
+        *tail_len = sp.len - RSUM_FOOTER_LEN;
+        *count = bytes;
+        return 0;
+    }
+    free(sp.data);
+    if (lzb_read(fd, 0, 1, &sp) != 0) return -1;
+    rsum_verify_t v;
+    rsum_verify_init(&v, 0, 0);
+    for (size_t i = 0; i < sp.len;) {
+        const char *nl = memchr(sp.data + i, '\n', sp.len - i);
+        size_t n = nl ? (size_t)(nl - sp.data - i) + 1 : sp.len - i;
+        rsum_verify_feed(&v, sp.data + i, n);
+        i += n;
+    }
+    *crc = rsum_verify_crc(&v);
+    *count = v.bytes;
+    *off = sp.last_off;
+    *raw_off = sp.last_raw;
+    *tail_len = sp.len - (size_t)(sp.last_raw - sp.raw_off);
+    memmove(sp.data, sp.data + (sp.last_raw - sp.raw_off), *tail_len);
+    *tail = sp.data;
+    return 0;
+}
+
+static int pwrite_all_(int fd, const char *p, size_t n, uint64_t off) {
+    while (n) {
+        ssize_t w = pwrite(fd, p, n, (off_t)off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) return -1;
+        p += w;
+        n -= (size_t)w;
+        off += (uint64_t)w;
+    }
+    return 0;
+}
+
+int rsum_write_report(const char *path, int flags, const char *body, size_t len) {
+    int fd = open(path, O_RDWR | O_CREAT | (flags & RSUM_APPEND ? 0 : O_TRUNC), 0644);
+    if (fd < 0) return -1;
+    uint64_t end = 0, raw_off = 0, count = 0;
+    uint32_t fcrc = 0;
+    char *tail = NULL, *rec = NULL;
+    size_t tail_len = 0;
+    int rc = -1;
+    // An existing file keeps its format; a new (or truncated) one is
+    // compressed if the caller asked for it.
+    struct stat st;
+    if (fstat(fd, &st) != 0) goto out;
+    int framed = st.st_size > 0 ? lzb_is_framed(fd) : (flags & RSUM_COMPRESS) != 0;
+    if (framed < 0) goto out;
+    if (st.st_size > 0) {
+        if (framed && lz_tail_(fd, &end, &raw_off, &tail, &tail_len, &fcrc, &count) != 0) goto out;
+        if (!framed && tail_(fd, path, &end, &fcrc, &count) != 0) goto out;
+    }
+
+    // [old tail |] body | crc32c=... | END line | footer, written over the old footer
+    // (or, compressed, over the old last block).
+    size_t data = len + 16 + sizeof(END_LINE) - 1;
+    rec = malloc(tail_len + data + RSUM_FOOTER_LEN + 1);
+    if (!rec) goto out;
+    char *p = rec + tail_len;
+    if (tail_len) memcpy(rec, tail, tail_len);
+    memcpy(p, body, len);
+    snprintf(p + len, 17, "crc32c=%08x\n", crc32c(0, body, len));
+    memcpy(p + len + 16, END_LINE, sizeof(END_LINE) - 1);
+    fcrc = crc32c(fcrc, p, data);
+    snprintf(p + data, RSUM_FOOTER_LEN + 1, FOOTER_PREFIX "%08x bytes=%020llu\n", fcrc,
+             (unsigned long long)(count + data));
+    size_t total = tail_len + data + RSUM_FOOTER_LEN;
+    if (framed) {
+        if (lzb_write(fd, end, raw_off, rec, total, &end) != 0) goto out;
+    } else {
+        if (pwrite_all_(fd, rec, total, end) != 0) goto out;
+        end += total;
+    }
+    if (ftruncate(fd, (off_t)end) != 0) goto out;
+    rc = 0;
+out:
+    free(tail);
+    free(rec);
+    if (close(fd) != 0) rc = -1;
+    return rc;
+}
@@ -0,0 +1,67 @@
+// reportsum.h
+// CRC32C integrity for io_demo REPORT files (common/crc32c.h).
+//
+// Per record: a checksum line just before the END line,
+//     REPORT
+//     ...fields...
+//     crc32c=1a2b3c4d                  CRC32C of "REPORT\n" through the last field line
+//     ---- END REPORT ----
+// Per file: one fixed-width footer, always the last line,
+//     FOOTER crc32c=9f8e7d6c bytes=00000000000000004321
+// covering every byte before it. Appending a report overwrites the footer
+// with the record and writes a new one; CRC32C can be continued, so the new
+// file CRC is the old one extended over the new bytes and nothing already
+// in the file is read again (only a file without a valid footer, e.g. one
+// written by an older io_demo, is checksummed once in full).
+//
+// With RSUM_COMPRESS a new file is written as LZ blocks (lzblock.h): the
+// text, checksums included, is the same, and an append rewrites only the
+// last block, which holds the footer.
+//
+// rsum_verify_t checks a file as it is read line by line (Part 5): feed it
+// every byte in order, as whole lines or fgets pieces (the REPORT, crc32c=
+// and FOOTER lines are short and must each arrive in one piece). It can
+// start at a checkpoint if it is given the CRC of the bytes before it.
+// Each piece gets one CRC call where the caller's buffer already holds it
+// (no staging copy) and extends only the file CRC; a record's own CRC is
+// derived from the file CRCs at its two ends. Only lines starting with F,
+// R, c or - are compared against anything.
+
+#ifndef W4_REPORTSUM_H
+#define W4_REPORTSUM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RSUM_FOOTER_LEN 50      // "FOOTER crc32c=%08x bytes=%020llu\n"
+
+#define RSUM_APPEND   1        // add to the file instead of replacing it
+#define RSUM_COMPRESS 2         // compress a new file; an existing one keeps its format
+
+// Write one record to path (created, or appended to with RSUM_APPEND).
+// body is "REPORT\n" plus its field lines; the crc32c= and END lines and the
+// footer are added here. Returns 0, or -1 with errno set.
+int rsum_write_report(const char *path, int flags, const char *body, size_t len);
+
+typedef struct {
+    uint32_t file_crc;          // CRC32C of the non-footer bytes so far
+    uint64_t bytes;             // non-footer bytes so far
+    uint32_t rec_base;          // file_crc where the open record started
+    uint64_t rec_len;           // the open record's body bytes so far
+    bool in_record, line_start;
+    uint64_t records_ok, records_bad, records_unchecked;
+    int footer;                 // 1 matches, -1 mismatch, 0 none (or data after it)
+} rsum_verify_t;
+
+// Start verifying at byte `offset` whose prefix has CRC32C `crc` (0, 0 for a full read).
+void rsum_verify_init(rsum_verify_t *v, uint64_t offset, uint32_t crc);
+
+// Feed the next bytes. Returns true if they were the footer line, which is
+// not part of the data (Part 5 does not checkpoint past it).
+bool rsum_verify_feed(rsum_verify_t *v, const char *p, size_t n);
+
+// CRC32C of every non-footer byte fed so far (what ckpt_commit_crc records).
+uint32_t rsum_verify_crc(rsum_verify_t *v);
+
+#endif /* W4_REPORTSUM_H */
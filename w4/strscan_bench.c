@@ -0,0 +1,168 @@
+// strscan_bench.c
+// Recitation extension: bounded SIMD string scans (common/strscan.h) vs libc.
+//
+// Build:  make strscan_bench
+// Run:    ./strscan_bench              (fuzz every kernel, then benchmark)
+//         ./strscan_bench -f 2000000   (more fuzz cases, no benchmark)
+//
+// Fuzz: random lengths, alignments, needles and NUL positions. Every buffer
+// is placed so it ends exactly at a PROT_NONE guard page (and starts right
+// after one), so a kernel that over-reads across a page boundary crashes
+// instead of passing. Results must match libc's strnlen / memchr, and a
+// memchr-per-set-byte reference for find_any.
+//
+// Bench: short strings (< 32 B, where call overhead and libc's generic
+// entry paths dominate) and long ones (bandwidth), ns/call per kernel.
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../common/strscan.h"
+#include "../common/timing.h"
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+/* --------------------------- Guarded buffers ---------------------------- */
+// [guard][ data pages ][guard]: both neighbours fault on access.
+static char *arena;
+static size_t arena_len;
+#define ARENA_PAGES 4
+
+static int arena_init(void) {
+    long pg = sysconf(_SC_PAGESIZE);
+    arena_len = (size_t)pg * ARENA_PAGES;
+    char *m = mmap(NULL, arena_len + 2 * (size_t)pg, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) return -1;
+    mprotect(m, (size_t)pg, PROT_NONE);
+    mprotect(m + (size_t)pg + arena_len, (size_t)pg, PROT_NONE);
+    arena = m + pg;
+    return 0;
+}
+
+static size_t ref_find_any(const char *p, size_t n, const char *set, size_t setlen) {
+    size_t best = n;
+    for (size_t j = 0; j < setlen; j++) {
+        const char *hit = memchr(p, set[j], best);
+        if (hit) best = (size_t)(hit - p);
+    }
+    return best;
+}
+
+static int fuzz(long cases) {
+    char set[STRSCAN_SET_MAX + 8];
+    for (size_t k = 0; k < STRSCAN_NIMPLS; k++) {
+        if (strscan_use(strscan_impls_[k].name) != 0) {
+            printf("  %-7s skipped (CPU lacks it)\n", strscan_impls_[k].name);
+            continue;
+        }
+        for (long c = 0; c < cases; c++) {
+            size_t n = (size_t)(rnd() % 3 == 0 ? rnd() % 40 : rnd() % 700);
+            // Half the cases end flush against the trailing guard page,
+            // half start flush against the leading one.
+            char *p = (c & 1) ? arena + arena_len - n : arena + rnd() % 64;
+            int alpha = 2 + (int)(rnd() % 6);        // small alphabet → frequent hits
+            for (size_t i = 0; i < n; i++) p[i] = (char)('a' + rnd() % (uint64_t)alpha);
+            if (n && rnd() % 2) p[rnd() % n] = '\0';
+            int needle = (rnd() % 8 == 0) ? 0 : 'a' + (int)(rnd() % (uint64_t)(alpha + 1));
+            size_t max = n ? (size_t)(rnd() % (n + 1)) : 0;
+            size_t setlen = (size_t)(rnd() % (STRSCAN_SET_MAX + 4));
+            for (size_t j = 0; j < setlen; j++) set[j] = (char)('a' + rnd() % 12);
+
+            size_t a = strscan_strnlen(p, max), b = strnlen(p, max);
+            const void *x = strscan_memchr(p, needle, n), *y = memchr(p, needle, n);
+            size_t f = strscan_find_any(p, n, set, setlen), g = ref_find_any(p, n, set, setlen);
+            if (a != b || x != y || f != g) {
+                printf("❌ %s mismatch: n=%zu max=%zu off=%zu | strnlen %zu vs %zu | memchr %td vs %td"
+                       " | find_any %zu vs %zu\n", strscan_isa(), n, max, (size_t)((uintptr_t)p & 63),
+                       a, b, x ? (const char *)x - p : -1, y ? (const char *)y - p : -1, f, g);
+                return -1;
+            }
+        }
+        printf("  %-7s ok (%ld cases)\n", strscan_impls_[k].name, cases);
+    }
+    return 0;
+}
+
+/* ------------------------------ Benchmark ------------------------------- */
+typedef enum { OP_STRNLEN, OP_MEMCHR, OP_FIND_ANY } op_t;
+static const char *op_name[] = { "strnlen", "memchr", "find_any(\" \\t\\r\\n\")" };
+static volatile size_t sink;
+
+// ns per call over 64 rotating alignments; kernel = -1 means libc.
+static double bench_one(op_t op, int kernel, size_t len) {
+    static const char ws[] = " \t\r\n";
+    char *buf = arena;                          // len + 64 <= arena
+    memset(buf, 'x', len + 64);
+    for (int o = 0; o < 64; o++) buf[o + len] = (op == OP_STRNLEN) ? '\0' : ' ';
+    if (kernel >= 0) strscan_use(strscan_impls_[kernel].name);
+    long iters = (long)((32u << 20) / (len + 16));
+    uint64_t t0 = timing_now_ns();
+    for (long i = 0; i < iters; i++) {
+        const char *p = buf + (i & 63);
+        size_t r;
+        switch (op) {
+            case OP_STRNLEN:
+                r = kernel < 0 ? strnlen(p, len + 64) : strscan_strnlen(p, len + 64);
+                break;
+            case OP_MEMCHR: {
+                const void *h = kernel < 0 ? memchr(p, ' ', len + 64) : strscan_memchr(p, ' ', len + 64);
+                r = (size_t)((const char *)h - p);
+                break;
+            }
+            default:
+                r = kernel < 0 ? strcspn(p, ws) : strscan_find_any(p, len + 64, ws, 4);
+                break;
+        }
+        sink += r;
+    }
+    return (double)(timing_now_ns() - t0) / (double)iters;
+}
+
+int main(int argc, char **argv) {
+    long cases = 200000;
+    int bench = 1, opt;
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        switch (opt) {
+            case 'f': cases = atol(optarg); bench = 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-f fuzz_cases]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (arena_init() != 0) { perror("mmap"); return 1; }
+
+    printf("=== strscan: fuzz vs libc (guard pages on both sides) ===\n");
+    if (fuzz(cases) != 0) return 1;
+    if (!bench) return 0;
+
+    static const size_t lens[] = { 7, 15, 31, 256, 4096, 12000 };
+    printf("\n=== ns/call (match at offset len; 64 rotating alignments) ===\n");
+    for (int op = OP_STRNLEN; op <= OP_FIND_ANY; op++) {
+        printf("\n%s\n%8s %9s", op_name[op], "len", op == OP_FIND_ANY ? "strcspn" : "libc");
+        for (size_t k = 0; k < STRSCAN_NIMPLS; k++)
+            if (strscan_use(strscan_impls_[k].name) == 0) printf(" %9s", strscan_impls_[k].name);
+        printf("\n");
+        for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+            printf("%8zu %9.1f", lens[l], bench_one((op_t)op, -1, lens[l]));
+            for (size_t k = 0; k < STRSCAN_NIMPLS; k++)
+                if (strscan_use(strscan_impls_[k].name) == 0)
+                    printf(" %9.1f", bench_one((op_t)op, (int)k, lens[l]));
+            printf("\n");
+        }
+    }
+    strscan_active_ = NULL;                     // back to auto-dispatch
+    printf("\nauto-dispatch picks: %s (override with STRSCAN_ISA=...)\n", strscan_isa());
+    printf("Takeaway:\n");
+    printf("  • Aligned loads never cross a page, so a SIMD scan can safely read\n"
+           "    a few bytes past the end of a string that touches an unmapped page.\n");
+    printf("  • Under ~32 B everything is call overhead; width pays off on long scans.\n");
+    printf("  • find_any vs strcspn: a bounded scan also skips strcspn's NUL check.\n\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+// strslice_bench.c
+// Recitation extension: what do repeated strlen() scans cost on long lines?
+//
+// Build:  make strslice_bench
+// Run:    ./strslice_bench
+//
+// Both pipelines do the same work on every line and must produce identical
+// bytes (checked):
+//   chomp -> trim -> split on ' ' -> per token: reverse + uppercase
+//   -> scramble (+1) and unscramble (-1) the whole line
+//
+//   cstr   the original helpers: chomp_newline / trim_spaces (io_demo.c),
+//          reverse_in_place (syscall_demo.c), demo.c's scramble loops —
+//          each one rescans for '\0', and trim memmoves the whole line
+//   slice  common/strslice.h: measure once, then pass (ptr, len) around
+
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../common/strslice.h"
+#include "../common/timing.h"
+
+/* -------------------- Original NUL-scanning helpers --------------------- */
+static void chomp_newline(char *s) {
+    size_t n = strlen(s);
+    if (n && s[n - 1] == '\n') s[n - 1] = '\0';
+}
+
+static void trim_spaces(char *s) {
+    size_t i = 0;
+    while (isspace((unsigned char)s[i])) i++;
+    if (i) memmove(s, s + i, strlen(s + i) + 1);
+
+    size_t n = strlen(s);
+    while (n && isspace((unsigned char)s[n - 1])) s[--n] = '\0';
+}
+
+static void reverse_in_place(char *s) {
+    size_t i = 0, j = strlen(s);
+    if (j == 0) return;
+    j--;
+    while (i < j) {
+        char tmp = s[i];
+        s[i] = s[j];
+        s[j] = tmp;
+        i++; j--;
+    }
+}
+
+static void upper_in_place(char *s) {
+    for (; *s; s++) *s = (char)toupper((unsigned char)*s);
+}
+
+static void scramble(char *s) {
+    for (char *p = s; *p; ++p) *p += 1;
+    size_t n = strlen(s);
+    if (n > 0) {
+        for (char *p = s + n - 1; ; --p) {
+            *p -= 1;
+            if (p == s) break;
+        }
+    }
+}
+
+// Returns a checksum over the tokens so the work cannot be optimized away.
+static uint64_t pipeline_cstr(char *line) {
+    chomp_newline(line);
+    trim_spaces(line);
+    scramble(line);
+    uint64_t h = 0;
+    char *save = NULL;
+    for (char *t = strtok_r(line, " ", &save); t; t = strtok_r(NULL, " ", &save)) {
+        reverse_in_place(t);
+        upper_in_place(t);
+        h = h * 31 + (unsigned char)t[0] + strlen(t);
+    }
+    return h;
+}
+
+static uint64_t pipeline_slice(char *line, size_t len) {
+    slice_t ls = slice_trim(slice_chomp(slice_from(line, len)));
+    slice_add(ls, +1);
+    slice_add(ls, -1);
+    uint64_t h = 0;
+    slice_t tok;
+    while (slice_split(&ls, ' ', &tok)) {
+        slice_reverse(tok);
+        slice_upper(tok);
+        h = h * 31 + (unsigned char)tok.ptr[0] + tok.len;
+    }
+    return h;
+}
+
+/* -------------------------------- Driver -------------------------------- */
+// "   w0 w1 w2 ... wN   \n": leading/trailing blanks make trim do real work.
+static size_t make_line(char *buf, size_t target) {
+    size_t n = 0;
+    for (int i = 0; i < 16; i++) buf[n++] = ' ';
+    for (unsigned w = 0; n + 24 < target; w++) n += (size_t)sprintf(buf + n, "word%u ", w * 2654435761u % 100000);
+    for (int i = 0; i < 8; i++) buf[n++] = ' ';
+    buf[n++] = '\n';
+    buf[n] = '\0';
+    return n;
+}
+
+int main(void) {
+    static const size_t sizes[] = { 80, 4096, 65536, 1u << 20 };
+    printf("=== strlen rescans vs (ptr, len) slices ===\n\n");
+    printf("%10s %14s %14s %9s\n", "line bytes", "cstr MB/s", "slice MB/s", "speedup");
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t cap = sizes[k] + 64;
+        char *tmpl = malloc(cap), *a = malloc(cap), *b = malloc(cap);
+        if (!tmpl || !a || !b) { perror("malloc"); return 1; }
+        size_t len = make_line(tmpl, sizes[k]);
+        // ~64 MiB of input per size so short and long lines get similar time
+        int reps = (int)((64u << 20) / len) + 1;
+
+        uint64_t hc = 0, hs = 0;
+        uint64_t t0 = timing_now_ns();
+        for (int r = 0; r < reps; r++) { memcpy(a, tmpl, len + 1); hc += pipeline_cstr(a); }
+        uint64_t t1 = timing_now_ns();
+        for (int r = 0; r < reps; r++) { memcpy(b, tmpl, len + 1); hs += pipeline_slice(b, len); }
+        uint64_t t2 = timing_now_ns();
+
+        if (hc != hs) { printf("❌ pipelines disagree at %zu bytes\n", len); return 1; }
+        double mb = (double)len * reps / 1e6;
+        double cstr = mb / ((double)(t1 - t0) / 1e9), slice = mb / ((double)(t2 - t1) / 1e9);
+        printf("%10zu %14.0f %14.0f %8.2fx\n", len, cstr, slice, slice / cstr);
+        free(tmpl); free(a); free(b);
+    }
+    printf("\n✅ identical token checksums for both pipelines\n");
+    printf("Takeaway:\n");
+    printf("  • Every strlen/NUL-walk is another full pass; slices measure once.\n");
+    printf("  • trim without memmove is O(trimmed bytes), not O(line).\n\n");
+    return 0;
+}
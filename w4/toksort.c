@@ -0,0 +1,167 @@
+// toksort.c
+// Arena-collected tokens, MSD radix sort, dedup with counts. See toksort.h;
+// used by io_demo.c, batch.c and toksort_bench.c.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "toksort.h"
+
+#define BLOCK_BYTES (1u << 20)
+
+struct toksort_block_ {
+    toksort_block_t *next;
+    size_t used, cap;
+    char data[];
+};
+
+/* ---------------------------------- Arena --------------------------------- */
+int toksort_add(toksort_t *t, const char *s, size_t len) {
+    toksort_block_t *b = t->arena;
+    if (!b || b->cap - b->used < len + 1) {
+        size_t cap = len + 1 > BLOCK_BYTES ? len + 1 : BLOCK_BYTES;
+        toksort_block_t *nb = malloc(sizeof(*nb) + cap);
+        if (!nb) return -1;
+        nb->next = b;
+        nb->used = 0;
+        nb->cap = cap;
+        t->arena = b = nb;
+    }
+    if (t->n == t->cap) {
+        size_t cap = t->cap ? 2 * t->cap : 4096;
+        char **k = realloc(t->keys, cap * sizeof(*k));
+        if (!k) return -1;
+        t->keys = k;
+        t->cap = cap;
+    }
+    char *dst = b->data + b->used;
+    memcpy(dst, s, len);
+    dst[len] = '\0';
+    b->used += len + 1;
+    t->bytes += len + 1;
+    t->keys[t->n++] = dst;
+    return 0;
+}
+
+void toksort_free(toksort_t *t) {
+    for (toksort_block_t *b = t->arena, *next; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+    free(t->keys);
+    free(t->counts);
+    memset(t, 0, sizeof(*t));
+}
+
+/* ---------------------------------- Sort ---------------------------------- */
+// strcmp on the bytes from depth on; everything before it is equal.
+static int cmp_from_(const char *a, const char *b, size_t depth) {
+    const unsigned char *x = (const unsigned char *)a + depth, *y = (const unsigned char *)b + depth;
+    while (*x && *x == *y) x++, y++;
+    return (int)*x - (int)*y;
+}
+
+static void insertion_(char **k, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; i++) {
+        char *x = k[i];
+        size_t j = i;
+        while (j > 0 && cmp_from_(k[j - 1], x, depth) > 0) {
+            k[j] = k[j - 1];
+            j--;
+        }
+        k[j] = x;
+    }
+}
+
+static int cmp_keys_(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+typedef struct { size_t lo, n, depth; } job_t;
+
+void toksort_radix(char **keys, size_t n) {
+    if (n < TOKSORT_SMALL) {
+        insertion_(keys, n, 0);
+        return;
+    }
+    char **tmp = malloc(n * sizeof(*tmp));
+    unsigned char *byte = malloc(n);
+    size_t cap = 1024, top = 0;
+    job_t *stack = malloc(cap * sizeof(*stack));
+    if (!tmp || !byte || !stack) {                  // same order, just slower
+        qsort(keys, n, sizeof(*keys), cmp_keys_);
+        goto out;
+    }
+    stack[top++] = (job_t){ 0, n, 0 };
+    while (top) {
+        job_t j = stack[--top];
+        char **k = keys + j.lo;
+        if (j.n < TOKSORT_SMALL) {
+            insertion_(k, j.n, j.depth);
+            continue;
+        }
+        size_t count[256] = { 0 };
+        for (size_t i = 0; i < j.n; i++) count[byte[i] = (unsigned char)k[i][j.depth]]++;
+        if (count[byte[0]] == j.n) {                // one shared byte: no scatter
+            if (byte[0]) stack[top++] = (job_t){ j.lo, j.n, j.depth + 1 };
+            continue;
+        }
+        size_t pos[256], at = 0;
+        for (int c = 0; c < 256; c++) {
+            pos[c] = at;
+            at += count[c];
+        }
+        for (size_t i = 0; i < j.n; i++) tmp[pos[byte[i]]++] = k[i];
+        memcpy(k, tmp, j.n * sizeof(*k));
+        // pos[c] is now the end of bucket c. Bucket 0 ended here: all equal.
+        if (top + 255 > cap) {
+            job_t *s = realloc(stack, 2 * cap * sizeof(*s));
+            if (!s) {                               // finish this range the slow way
+                for (int c = 1; c < 256; c++) {
+                    if (count[c] > 1) qsort(k + pos[c] - count[c], count[c], sizeof(*k), cmp_keys_);
+                }
+                continue;
+            }
+            stack = s;
+            cap *= 2;
+        }
+        for (int c = 255; c >= 1; c--) {
+            if (count[c] > 1) stack[top++] = (job_t){ j.lo + pos[c] - count[c], count[c], j.depth + 1 };
+        }
+    }
+out:
+    free(stack);
+    free(byte);
+    free(tmp);
+}
+
+/* --------------------------------- Unique --------------------------------- */
+int toksort_unique(toksort_t *t) {
+    toksort_radix(t->keys, t->n);
+    free(t->counts);
+    t->counts = NULL;
+    if (t->n == 0) return 0;
+    size_t u = 1;
+    for (size_t i = 1; i < t->n; i++) u += strcmp(t->keys[i - 1], t->keys[i]) != 0;
+    t->counts = malloc(u * sizeof(*t->counts));
+    if (!t->counts) return -1;
+    size_t w = 0;
+    t->counts[0] = 1;
+    for (size_t i = 1; i < t->n; i++) {
+        if (strcmp(t->keys[w], t->keys[i]) == 0) {
+            t->counts[w]++;
+        } else {
+            t->keys[++w] = t->keys[i];
+            t->counts[w] = 1;
+        }
+    }
+    t->n = u;
+    return 0;
+}
+
+int toksort_write(const toksort_t *t, FILE *out) {
+    for (size_t i = 0; i < t->n; i++) {
+        if (fprintf(out, "%s %llu\n", t->keys[i], (unsigned long long)(t->counts ? t->counts[i] : 1)) < 0) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+// toksort.h
+// Sorted, deduplicated tokens with counts: what `sort | uniq -c` gives, for
+// io_demo's TOKEN_ORDER=sorted report and `io_demo -p -u tokens.txt`.
+//
+// toksort_add() copies each token into an arena (1 MiB blocks, never moved,
+// so the key pointers stay valid) and appends a pointer to it. No hashing,
+// no per-token malloc: collecting is a memcpy and a store.
+//
+// toksort_radix() is an MSD radix sort on the key bytes, in strcmp order:
+//   - one pass reads byte `depth` of every key into a byte array (the only
+//     pass that touches the strings), counts the 256 buckets from it and
+//     scatters the pointers through a scratch array;
+//   - bucket 0 holds keys that ended at `depth`: all equal, done;
+//   - a range where every key shares the byte skips the scatter (long common
+//     prefixes like "/api/v2/items/" cost one counting pass per byte);
+//   - ranges under TOKSORT_SMALL keys are insertion-sorted from `depth`:
+//     they fit in cache and a 256-bucket pass would be mostly empty buckets.
+// Work is an explicit stack, not recursion: a 1 MiB token cannot overflow it.
+//
+// toksort_unique() sorts, then collapses equal neighbours into one key with
+// a count.
+
+#ifndef W4_TOKSORT_H
+#define W4_TOKSORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TOKSORT_SMALL 32        // insertion sort below this many keys
+
+typedef struct toksort_block_ toksort_block_t;
+
+typedef struct {
+    char **keys;                // NUL-terminated, in the arena
+    uint64_t *counts;           // counts[i] for keys[i], once toksort_unique has run
+    size_t n, cap;
+    uint64_t bytes;             // arena bytes in use
+    toksort_block_t *arena;
+} toksort_t;
+
+// t must start zeroed. Returns 0, or -1 if out of memory.
+int toksort_add(toksort_t *t, const char *s, size_t len);
+
+// Sort keys[0..n) in strcmp order.
+void toksort_radix(char **keys, size_t n);
+
+// Sort t->keys and keep one of each, with counts. Returns 0, or -1 if out
+// of memory (t is then sorted but not deduplicated).
+int toksort_unique(toksort_t *t);
+
+// "token count" per line, after toksort_unique. Returns 0, or -1 on a
+// write error.
+int toksort_write(const toksort_t *t, FILE *out);
+
+void toksort_free(toksort_t *t);
+
+#endif /* W4_TOKSORT_H */
@@ -0,0 +1,157 @@
+// toksort_bench.c
+// Recitation extension: sorted unique tokens (toksort.c), radix sort vs qsort
+//
+// Build:  make toksort_bench
+// Run:    ./toksort_bench                   (10M tokens)
+//         ./toksort_bench -n 100M -v 1M     (the full run: ~2.5 GB of RAM)
+//
+// 1. Generates -n tokens like io_demo's input: words drawn Zipf-style from a
+//    vocabulary of -v, API paths with long shared prefixes, integers. Each
+//    is copied into the toksort arena (toksort_add).
+// 2. Sorts the key pointers with toksort_radix (MSD radix, insertion sort
+//    under TOKSORT_SMALL) and a copy with qsort + strcmp: the two orders
+//    must be identical.
+// 3. Sorts the same keys again with each (already sorted input), then
+//    deduplicates with counts (toksort_unique) and checks the counts add up.
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "toksort.h"
+
+static uint64_t rng = 0x082EFA98EC4E6C89ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+static double rnd01(void) { return (double)(rnd() >> 11) / 9007199254740992.0; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1e3; break;
+        case 'm': case 'M': v *= 1e6; break;
+        case 'g': case 'G': v *= 1e9; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* --------------------------------- Tokens --------------------------------- */
+// Word number r of the vocabulary: 3-10 lowercase letters, fixed per r.
+static int word(uint64_t r, char *out) {
+    uint64_t h = r * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull;
+    int len = 3 + (int)(h % 8);
+    for (int i = 0; i < len; i++) {
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        out[i] = (char)('a' + (h >> 40) % 26);
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static void generate(toksort_t *t, size_t n, size_t vocab) {
+    char buf[64];
+    double lv = log((double)vocab);
+    for (size_t i = 0; i < n; i++) {
+        int len;
+        switch (rnd() % 3) {
+            case 0:                                 // Zipf-ish: log-uniform rank
+                len = word((uint64_t)exp(rnd01() * lv), buf);
+                break;
+            case 1:
+                len = snprintf(buf, sizeof(buf), "/api/v%u/items/%u", (unsigned)(rnd() % 4),
+                               (unsigned)(rnd() % 100000));
+                break;
+            default:
+                len = snprintf(buf, sizeof(buf), "%u", (unsigned)(rnd() % 1000000));
+                break;
+        }
+        if (toksort_add(t, buf, (size_t)len) != 0) { perror("toksort_add"); exit(1); }
+    }
+}
+
+static int cmp_keys(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int main(int argc, char **argv) {
+    size_t n = 10000000, vocab = 100000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:v:")) != -1) {
+        switch (opt) {
+            case 'n': n = parse_size(optarg); break;
+            case 'v': vocab = parse_size(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n tokens] [-v vocabulary]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (n < 1 || vocab < 2) return 2;
+    printf("=== Sorted unique tokens: %zu tokens, vocabulary %zu ===\n\n", n, vocab);
+
+    toksort_t t = { 0 };
+    uint64_t t0 = timing_now_ns();
+    generate(&t, n, vocab);
+    double s_gen = (double)(timing_now_ns() - t0) / 1e9;
+    printf("arena: %.1f MiB of keys + %.1f MiB of pointers, collected in %.3f s\n\n",
+           (double)t.bytes / (1 << 20), (double)(n * sizeof(char *)) / (1 << 20), s_gen);
+
+    char **copy = malloc(n * sizeof(*copy));
+    if (!copy) { perror("malloc"); return 1; }
+    memcpy(copy, t.keys, n * sizeof(*copy));
+
+    printf("%-22s %10s %12s %10s\n", "sort", "seconds", "Mkeys/s", "speedup");
+    t0 = timing_now_ns();
+    qsort(copy, n, sizeof(*copy), cmp_keys);
+    double s_q = (double)(timing_now_ns() - t0) / 1e9;
+    t0 = timing_now_ns();
+    toksort_radix(t.keys, n);
+    double s_r = (double)(timing_now_ns() - t0) / 1e9;
+    int ok = 1;
+    for (size_t i = 0; i < n && ok; i++) ok = strcmp(t.keys[i], copy[i]) == 0;
+    printf("%-22s %10.3f %12.2f %10s\n", "qsort + strcmp", s_q, (double)n / s_q / 1e6, "1.00x");
+    printf("%-22s %10.3f %12.2f %9.2fx %s\n", "MSD radix", s_r, (double)n / s_r / 1e6, s_q / s_r,
+           ok ? "✅ same order" : "❌ order differs");
+
+    // Already sorted: qsort's comparisons now run over long equal prefixes.
+    t0 = timing_now_ns();
+    qsort(copy, n, sizeof(*copy), cmp_keys);
+    double s_q2 = (double)(timing_now_ns() - t0) / 1e9;
+    t0 = timing_now_ns();
+    toksort_radix(t.keys, n);
+    double s_r2 = (double)(timing_now_ns() - t0) / 1e9;
+    printf("%-22s %10.3f %12.2f %10s\n", "qsort, sorted input", s_q2, (double)n / s_q2 / 1e6, "1.00x");
+    printf("%-22s %10.3f %12.2f %9.2fx\n", "radix, sorted input", s_r2, (double)n / s_r2 / 1e6, s_q2 / s_r2);
+    free(copy);
+
+    t0 = timing_now_ns();
+    if (toksort_unique(&t) != 0) { perror("toksort_unique"); return 1; }
+    double s_u = (double)(timing_now_ns() - t0) / 1e9;
+    uint64_t total = 0;
+    for (size_t i = 0; i < t.n; i++) total += t.counts[i];
+    int counts_ok = total == n;
+    ok &= counts_ok;
+    for (size_t i = 1; i < t.n && ok; i++) ok = strcmp(t.keys[i - 1], t.keys[i]) < 0;
+    printf("\nsort + dedup: %zu unique tokens in %.3f s, counts sum to %llu %s\n", t.n, s_u,
+           (unsigned long long)total, ok ? "✅" : "❌");
+    size_t best = 0;
+    for (size_t i = 1; i < t.n; i++) best = t.counts[i] > t.counts[best] ? i : best;
+    printf("most frequent: \"%s\" x%llu\n", t.keys[best], (unsigned long long)t.counts[best]);
+    toksort_free(&t);
+
+    printf("\nTakeaway:\n");
+    printf("  • qsort + strcmp is an indirect call and a string walk from byte 0 per\n"
+           "    comparison, n log n times. Radix looks at each key byte about once.\n");
+    printf("  • Shared prefixes (\"/api/v2/items/\") are where MSD radix wins most: one\n"
+           "    counting pass per byte instead of re-comparing the prefix every time.\n");
+    printf("  • The second radix run does the same work but is slower: sorted pointers no\n"
+           "    longer walk the arena in order, so every first-byte read is a cache miss.\n");
+    printf("  • Once sorted, dedup with counts is a single linear pass.\n\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,471 @@
+// tokstats.c
+// Streaming token counts (exact hash map or Space-Saving + Count-Min) and
+// numeric statistics. See tokstats.h; used by io_demo.c and tokstats_bench.c.
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tokstats.h"
+
+#define CMS_ROWS 4
+#define HLL_BITS 12             // 4096 HyperLogLog registers: ~1.6% standard error
+#define HLL_REGS (1u << HLL_BITS)
+#define EXACT_MIN_CAP 64
+#define INLINE_KEY 12           // keys up to this long live in the slot itself
+
+// Exact map slot, 32 bytes (two per cache line); hash 0 marks an empty slot.
+// Short keys are stored inline so a hit costs one cache miss, not two (slot
+// + arena). Longer keys keep their arena offset in key[0..8).
+typedef struct {
+    uint64_t hash, count;
+    uint32_t len;
+    char key[INLINE_KEY];
+} slot_t;
+
+typedef struct {                // Space-Saving counter, kept in a min-heap
+    uint64_t hash, count, err;
+    uint32_t len, slot;         // slot: position in ts->idx pointing back here
+    char key[TOKSTATS_KEY_MAX];
+} ss_entry_t;
+
+struct tokstats {
+    tokstats_mode_t mode;
+    uint64_t total;
+    tokstats_num_t num;
+
+    // TOKSTATS_EXACT
+    slot_t *slots;
+    size_t cap, used;           // cap is a power of two, used <= 3/4 cap
+    char *arena;
+    size_t arena_len, arena_cap;
+
+    // TOKSTATS_SKETCH
+    uint64_t *cms;              // CMS_ROWS x width counters
+    size_t width;
+    ss_entry_t *heap;           // min-heap on count: heap[0] is evicted next
+    size_t k, n;
+    uint32_t *idx;              // hash -> heap position + 1 (0 = empty)
+    size_t idx_cap;
+    uint8_t *hll;               // HLL_REGS registers: max rank seen per bucket
+};
+
+/* ================================ Hashing ================================ */
+static inline uint64_t load64_(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 64x64 -> 128-bit multiply, folded: one multiply mixes all 64 input bits.
+static inline uint64_t mix_(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+// Two independent 8-byte lanes per 16-byte step, so the multiplies overlap.
+// Tokens are mostly < 16 bytes, which leaves only the tail load and the
+// final mix.
+uint64_t tokstats_hash(const char *s, size_t len) {
+    const uint64_t K0 = 0xa0761d6478bd642full, K1 = 0xe7037ed1a0b428dbull, K2 = 0x8ebc6af09c88c6e3ull;
+    uint64_t a = K0 ^ len, b = K1;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        a = mix_(load64_(s + i) ^ K1, a ^ K2);
+        b = mix_(load64_(s + i + 8) ^ K2, b ^ K0);
+    }
+    uint64_t t[2] = { 0, 0 };
+    memcpy(t, s + i, len - i);
+    return mix_(mix_(a ^ t[0] ^ K1, b ^ t[1] ^ K2) ^ K0, len ^ K1);
+}
+
+/* ============================ Numeric tokens ============================= */
+bool tokstats_parse_i64(const char *s, size_t len, int64_t *out) {
+    size_t i = 0;
+    bool neg = false;
+    if (len && (s[0] == '+' || s[0] == '-')) { neg = s[0] == '-'; i = 1; }
+    if (i == len) return false;
+    uint64_t limit = neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX, acc = 0;
+    for (; i < len; i++) {
+        unsigned d = (unsigned)(unsigned char)s[i] - '0';
+        if (d > 9 || acc > (limit - d) / 10) return false;
+        acc = acc * 10 + d;
+    }
+    *out = neg ? (acc ? -(int64_t)(acc - 1) - 1 : 0) : (int64_t)acc;
+    return true;
+}
+
+static void num_add_(tokstats_num_t *s, int64_t v) {
+    if (s->n++ == 0) s->min = s->max = v;
+    if (v < s->min) s->min = v;
+    if (v > s->max) s->max = v;
+    double d = (double)v - s->mean;
+    s->mean += d / (double)s->n;
+    s->m2 += d * ((double)v - s->mean);
+    uint64_t mag = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    if (v < 0) s->neg++;
+    s->hist[mag ? 64 - __builtin_clzll(mag) : 0]++;
+}
+
+/* =============================== Exact map =============================== */
+static inline const char *slot_key_(const tokstats_t *ts, const slot_t *e) {
+    if (e->len <= INLINE_KEY) return e->key;
+    uint64_t off;
+    memcpy(&off, e->key, sizeof(off));
+    return ts->arena + off;
+}
+
+static inline bool slot_eq_(const tokstats_t *ts, const slot_t *e, const char *tok, size_t len, uint64_t h) {
+    return e->hash == h && e->len == len && memcmp(slot_key_(ts, e), tok, len) == 0;
+}
+
+static int exact_grow_(tokstats_t *ts) {
+    size_t ncap = ts->cap ? ts->cap * 2 : EXACT_MIN_CAP;
+    slot_t *ns = calloc(ncap, sizeof(slot_t));
+    if (!ns) return -1;
+    for (size_t i = 0; i < ts->cap; i++) {
+        if (!ts->slots[i].hash) continue;
+        size_t j = ts->slots[i].hash & (ncap - 1);
+        while (ns[j].hash) j = (j + 1) & (ncap - 1);
+        ns[j] = ts->slots[i];
+    }
+    free(ts->slots);
+    ts->slots = ns;
+    ts->cap = ncap;
+    return 0;
+}
+
+static int exact_add_(tokstats_t *ts, const char *tok, size_t len, uint64_t h) {
+    if ((ts->used + 1) * 4 > ts->cap * 3 && exact_grow_(ts) != 0) return -1;
+    size_t mask = ts->cap - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        slot_t *e = &ts->slots[i];
+        if (slot_eq_(ts, e, tok, len, h)) {
+            e->count++;
+            return 0;
+        }
+        if (e->hash) continue;
+        *e = (slot_t){ .hash = h, .count = 1, .len = (uint32_t)len };
+        ts->used++;
+        if (len <= INLINE_KEY) {
+            memcpy(e->key, tok, len);
+            return 0;
+        }
+        if (ts->arena_len + len > ts->arena_cap) {
+            size_t ncap = ts->arena_cap ? ts->arena_cap * 2 : 4096;
+            while (ncap < ts->arena_len + len) ncap *= 2;
+            char *na = realloc(ts->arena, ncap);
+            if (!na) { e->hash = 0; ts->used--; return -1; }
+            ts->arena = na;
+            ts->arena_cap = ncap;
+        }
+        uint64_t off = ts->arena_len;
+        memcpy(e->key, &off, sizeof(off));
+        memcpy(ts->arena + off, tok, len);
+        ts->arena_len += len;
+        return 0;
+    }
+}
+
+static const slot_t *exact_find_(const tokstats_t *ts, const char *tok, size_t len, uint64_t h) {
+    if (!ts->cap) return NULL;
+    size_t mask = ts->cap - 1;
+    for (size_t i = h & mask; ts->slots[i].hash; i = (i + 1) & mask) {
+        const slot_t *e = &ts->slots[i];
+        if (slot_eq_(ts, e, tok, len, h)) return e;
+    }
+    return NULL;
+}
+
+/* ========================= Count-Min Sketch ============================== */
+// Row r uses column (h1 + r*h2) mod width: two halves of one hash stand in
+// for CMS_ROWS independent hash functions.
+static uint64_t cms_update_(tokstats_t *ts, uint64_t h) {
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    uint64_t *c[CMS_ROWS], min = UINT64_MAX;
+    for (uint32_t r = 0; r < CMS_ROWS; r++) {
+        c[r] = &ts->cms[r * ts->width + ((h1 + r * h2) & (ts->width - 1))];
+        if (*c[r] < min) min = *c[r];
+    }
+    // Conservative update: only the counters at the minimum can be too low.
+    for (int r = 0; r < CMS_ROWS; r++)
+        if (*c[r] == min) (*c[r])++;
+    return min + 1;
+}
+
+/* ============================== HyperLogLog ============================== */
+// The top HLL_BITS of the hash pick a register; it keeps the longest run of
+// leading zeros (+1) seen in the remaining bits. Large runs are rare, so
+// their size says how many different hashes went by.
+static void hll_add_(tokstats_t *ts, uint64_t h) {
+    uint64_t rest = h << HLL_BITS | (1ull << (HLL_BITS - 1));   // guard bit bounds the rank
+    uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+    uint8_t *r = &ts->hll[h >> (64 - HLL_BITS)];
+    if (rank > *r) *r = rank;
+}
+
+// Harmonic mean of 2^-register (Flajolet et al.), with linear counting on
+// the empty registers while the set is small.
+static double hll_estimate_(const tokstats_t *ts) {
+    double sum = 0.0, m = HLL_REGS;
+    size_t zeros = 0;
+    for (size_t i = 0; i < HLL_REGS; i++) {
+        sum += ldexp(1.0, -(int)ts->hll[i]);
+        zeros += ts->hll[i] == 0;
+    }
+    double est = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    if (est <= 2.5 * m && zeros) est = m * log(m / (double)zeros);
+    return est;
+}
+
+static uint64_t cms_query_(const tokstats_t *ts, uint64_t h) {
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    uint64_t min = UINT64_MAX;
+    for (uint32_t r = 0; r < CMS_ROWS; r++) {
+        uint64_t v = ts->cms[r * ts->width + ((h1 + r * h2) & (ts->width - 1))];
+        if (v < min) min = v;
+    }
+    return min;
+}
+
+/* ============================= Space-Saving ============================== */
+static void ss_swap_(tokstats_t *ts, size_t i, size_t j) {
+    ss_entry_t t = ts->heap[i];
+    ts->heap[i] = ts->heap[j];
+    ts->heap[j] = t;
+    ts->idx[ts->heap[i].slot] = (uint32_t)i + 1;
+    ts->idx[ts->heap[j].slot] = (uint32_t)j + 1;
+}
+
+static void ss_sift_up_(tokstats_t *ts, size_t i) {
+    while (i && ts->heap[(i - 1) / 2].count > ts->heap[i].count) {
+        ss_swap_(ts, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void ss_sift_down_(tokstats_t *ts, size_t i) {
+    for (;;) {
+        size_t m = i, l = 2 * i + 1, r = l + 1;
+        if (l < ts->n && ts->heap[l].count < ts->heap[m].count) m = l;
+        if (r < ts->n && ts->heap[r].count < ts->heap[m].count) m = r;
+        if (m == i) return;
+        ss_swap_(ts, i, m);
+        i = m;
+    }
+}
+
+// Heap position of hash h, or SIZE_MAX; *slot gets its (or the free) idx slot.
+static size_t ss_find_(const tokstats_t *ts, uint64_t h, size_t *slot) {
+    size_t mask = ts->idx_cap - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        if (!ts->idx[i]) { *slot = i; return SIZE_MAX; }
+        if (ts->heap[ts->idx[i] - 1].hash == h) { *slot = i; return ts->idx[i] - 1; }
+    }
+}
+
+// Linear-probing delete by backward shift (no tombstones to clean up later).
+static void ss_idx_del_(tokstats_t *ts, size_t i) {
+    size_t mask = ts->idx_cap - 1;
+    for (size_t j = i;;) {
+        j = (j + 1) & mask;
+        if (!ts->idx[j]) break;
+        size_t home = ts->heap[ts->idx[j] - 1].hash & mask;
+        // j may fill the hole at i unless its home lies cyclically in (i, j]
+        if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) continue;
+        ts->idx[i] = ts->idx[j];
+        ts->heap[ts->idx[i] - 1].slot = (uint32_t)i;
+        i = j;
+    }
+    ts->idx[i] = 0;
+}
+
+static void ss_set_key_(ss_entry_t *e, const char *tok, size_t len, uint64_t h) {
+    e->hash = h;
+    e->len = (uint32_t)(len < TOKSTATS_KEY_MAX ? len : TOKSTATS_KEY_MAX);
+    memcpy(e->key, tok, e->len);
+}
+
+// est: this token's Count-Min estimate after counting it (>= true count).
+static void ss_add_(tokstats_t *ts, const char *tok, size_t len, uint64_t h, uint64_t est) {
+    size_t slot, pos = ss_find_(ts, h, &slot);
+    if (pos != SIZE_MAX) {                      // monitored: count it
+        ts->heap[pos].count++;
+        ss_sift_down_(ts, pos);
+        return;
+    }
+    if (ts->n < ts->k) {                        // free counter
+        pos = ts->n++;
+        ss_entry_t *e = &ts->heap[pos];
+        ss_set_key_(e, tok, len, h);
+        e->count = 1;
+        e->err = 0;
+        e->slot = (uint32_t)slot;
+        ts->idx[slot] = (uint32_t)pos + 1;
+        ss_sift_up_(ts, pos);
+        return;
+    }
+    // Plain Space-Saving would evict the minimum for every unmonitored token,
+    // so on a long tail nearly every token churns the heap. Filter with the
+    // sketch: a token whose estimate cannot beat the minimum would be the
+    // next one evicted anyway. Admitted tokens start at the estimate, an
+    // upper bound, with err = est - 1 (at least this one occurrence is real).
+    ss_entry_t *e = &ts->heap[0];
+    if (est <= e->count) return;
+    ss_idx_del_(ts, e->slot);
+    ss_find_(ts, h, &slot);                     // the shift may have moved our slot
+    e->count = est;
+    e->err = est - 1;
+    ss_set_key_(e, tok, len, h);
+    e->slot = (uint32_t)slot;
+    ts->idx[slot] = 1;
+    ss_sift_down_(ts, 0);
+}
+
+/* ================================ Public ================================= */
+static size_t pow2_at_least_(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+tokstats_t *tokstats_new(tokstats_mode_t mode, size_t k, size_t width) {
+    tokstats_t *ts = calloc(1, sizeof(*ts));
+    if (!ts) return NULL;
+    ts->mode = mode;
+    if (mode == TOKSTATS_SKETCH) {
+        ts->k = k ? k : 1;
+        ts->width = pow2_at_least_(width ? width : 65536);
+        ts->idx_cap = pow2_at_least_(ts->k * 2);
+        ts->cms = calloc(CMS_ROWS * ts->width, sizeof(uint64_t));
+        ts->heap = calloc(ts->k, sizeof(ss_entry_t));
+        ts->idx = calloc(ts->idx_cap, sizeof(uint32_t));
+        ts->hll = calloc(HLL_REGS, 1);
+        if (!ts->cms || !ts->heap || !ts->idx || !ts->hll) { tokstats_free(ts); return NULL; }
+    }
+    return ts;
+}
+
+void tokstats_free(tokstats_t *ts) {
+    if (!ts) return;
+    free(ts->slots);
+    free(ts->arena);
+    free(ts->cms);
+    free(ts->heap);
+    free(ts->idx);
+    free(ts->hll);
+    free(ts);
+}
+
+int tokstats_add(tokstats_t *ts, const char *tok, size_t len, int64_t *num) {
+    uint64_t h = tokstats_hash(tok, len);
+    h |= (h == 0);                              // 0 marks empty slots
+    if (ts->mode == TOKSTATS_EXACT) {
+        if (exact_add_(ts, tok, len, h) != 0) return -1;
+    } else {
+        ss_add_(ts, tok, len, h, cms_update_(ts, h));
+        hll_add_(ts, h);
+    }
+    ts->total++;
+    int64_t v;
+    if (!len || (unsigned)(unsigned char)tok[len - 1] - '0' > 9 || !tokstats_parse_i64(tok, len, &v)) return 0;
+    num_add_(&ts->num, v);
+    if (num) *num = v;
+    return 1;
+}
+
+uint64_t tokstats_count(const tokstats_t *ts, const char *tok, size_t len) {
+    uint64_t h = tokstats_hash(tok, len);
+    h |= (h == 0);
+    if (ts->mode == TOKSTATS_SKETCH) return cms_query_(ts, h);
+    const slot_t *e = exact_find_(ts, tok, len, h);
+    return e ? e->count : 0;
+}
+
+// Highest count first; ties broken by key so output is stable across runs.
+static int top_cmp_(const void *pa, const void *pb) {
+    const tokstat_t *a = pa, *b = pb;
+    if (a->count != b->count) return a->count < b->count ? 1 : -1;
+    size_t n = a->len < b->len ? a->len : b->len;
+    int c = memcmp(a->key, b->key, n);
+    return c ? c : (a->len > b->len) - (a->len < b->len);
+}
+
+// Min-heap of the best k seen so far, ordered by top_cmp_ (root = worst).
+static void top_offer_(tokstat_t *h, size_t *n, size_t k, tokstat_t e) {
+    size_t i;
+    if (*n < k) {
+        i = (*n)++;
+        while (i && top_cmp_(&h[(i - 1) / 2], &e) < 0) { h[i] = h[(i - 1) / 2]; i = (i - 1) / 2; }
+        h[i] = e;
+        return;
+    }
+    if (top_cmp_(&e, &h[0]) >= 0) return;       // not better than the worst kept
+    for (i = 0;;) {
+        size_t m = 2 * i + 1;
+        if (m >= *n) break;
+        if (m + 1 < *n && top_cmp_(&h[m + 1], &h[m]) > 0) m++;
+        if (top_cmp_(&h[m], &e) <= 0) break;
+        h[i] = h[m];
+        i = m;
+    }
+    h[i] = e;
+}
+
+size_t tokstats_top(const tokstats_t *ts, tokstat_t *out, size_t k) {
+    size_t n = 0;
+    if (!k) return 0;
+    if (ts->mode == TOKSTATS_EXACT) {
+        for (size_t i = 0; i < ts->cap; i++) {
+            const slot_t *e = &ts->slots[i];
+            if (e->hash)
+                top_offer_(out, &n, k, (tokstat_t){ slot_key_(ts, e), e->len, e->count, 0 });
+        }
+    } else {
+        for (size_t i = 0; i < ts->n; i++) {
+            const ss_entry_t *e = &ts->heap[i];
+            top_offer_(out, &n, k, (tokstat_t){ e->key, e->len, e->count, e->err });
+        }
+    }
+    qsort(out, n, sizeof(*out), top_cmp_);
+    return n;
+}
+
+uint64_t tokstats_total(const tokstats_t *ts) { return ts->total; }
+
+size_t tokstats_distinct(const tokstats_t *ts) {
+    return ts->mode == TOKSTATS_EXACT ? ts->used : ts->n;
+}
+
+size_t tokstats_cardinality(const tokstats_t *ts) {
+    if (ts->mode == TOKSTATS_EXACT) return ts->used;
+    return ts->total ? (size_t)(hll_estimate_(ts) + 0.5) : 0;
+}
+
+size_t tokstats_bytes(const tokstats_t *ts) {
+    return sizeof(*ts) + ts->cap * sizeof(slot_t) + ts->arena_cap +
+           CMS_ROWS * ts->width * sizeof(uint64_t) + ts->k * sizeof(ss_entry_t) +
+           ts->idx_cap * sizeof(uint32_t) + (ts->hll ? HLL_REGS : 0);
+}
+
+const tokstats_num_t *tokstats_numeric(const tokstats_t *ts) { return &ts->num; }
+
+void tokstats_print_numeric(const tokstats_t *ts, FILE *out) {
+    const tokstats_num_t *s = &ts->num;
+    if (!s->n) {
+        fprintf(out, "  (no numeric tokens)\n");
+        return;
+    }
+    double sd = s->n > 1 ? sqrt(s->m2 / (double)(s->n - 1)) : 0.0;
+    fprintf(out, "  numeric: n=%llu min=%lld max=%lld mean=%.3f stddev=%.3f (%llu negative)\n",
+            (unsigned long long)s->n, (long long)s->min, (long long)s->max, s->mean, sd,
+            (unsigned long long)s->neg);
+    for (int b = 0; b < 65; b++) {
+        if (!s->hist[b]) continue;
+        if (b == 0)
+            fprintf(out, "    |v| = 0                : %llu\n", (unsigned long long)s->hist[b]);
+        else
+            fprintf(out, "    |v| in [2^%-2d, 2^%-2d)   : %llu\n", b - 1, b,
+                    (unsigned long long)s->hist[b]);
+    }
+}
@@ -0,0 +1,88 @@
+// tokstats.h
+// Streaming token aggregation for io_demo and tokstats_bench.
+//
+// Every token is counted; tokens that parse as base-10 integers also feed
+// min/max/mean/stddev and a log2 histogram of their magnitudes.
+//
+// Two counting modes:
+//   TOKSTATS_EXACT   open-addressing hash map (linear probing, stored hashes,
+//                    short keys inline, longer ones in a growable arena).
+//                    Memory grows with the number of distinct tokens.
+//   TOKSTATS_SKETCH  fixed memory, chosen up front:
+//                    - Count-Min Sketch (4 rows, conservative update) answers
+//                      "how often did X occur?" for any token, never below
+//                      the true count.
+//                    - Space-Saving keeps the k heaviest tokens, filtered by
+//                      the sketch: an unmonitored token only replaces the
+//                      smallest counter once its estimate is larger. A count
+//                      may overshoot the truth by at most `err`.
+//                    - HyperLogLog (4096 one-byte registers) estimates how
+//                      many distinct tokens went by, within ~1.6%.
+//                    Keys longer than TOKSTATS_KEY_MAX are stored truncated
+//                    and are told apart by their 64-bit hash.
+
+#ifndef W4_TOKSTATS_H
+#define W4_TOKSTATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TOKSTATS_KEY_MAX 31     // bytes of key kept per sketch entry
+
+typedef enum { TOKSTATS_EXACT, TOKSTATS_SKETCH } tokstats_mode_t;
+
+typedef struct tokstats tokstats_t;
+
+typedef struct {
+    const char *key;            // not NUL-terminated; valid until the next add
+    size_t len;
+    uint64_t count;             // exact, or an upper bound in sketch mode
+    uint64_t err;               // count - err <= true count (0 when exact)
+} tokstat_t;
+
+typedef struct {
+    uint64_t n;                 // numeric tokens seen
+    int64_t min, max;
+    double mean, m2;            // Welford running mean / sum of squares
+    uint64_t neg;               // how many were < 0
+    uint64_t hist[65];          // hist[b]: |v| has bit length b (hist[0]: v == 0)
+} tokstats_num_t;
+
+// k: heavy hitters kept (sketch mode; ignored when exact).
+// width: Count-Min columns per row, rounded up to a power of two (0 = 65536).
+// Returns NULL if allocation fails.
+tokstats_t *tokstats_new(tokstats_mode_t mode, size_t k, size_t width);
+void tokstats_free(tokstats_t *ts);
+
+// Count tok and, if it is an integer, add it to the numeric stats. Returns
+// 1 if it was one (*num, if not NULL, gets the value, so callers need not
+// parse it again), 0 if not, -1 if growing the exact map failed (the token
+// is not counted).
+int tokstats_add(tokstats_t *ts, const char *tok, size_t len, int64_t *num);
+
+// Up to k most frequent tokens, highest count first. Returns how many.
+size_t tokstats_top(const tokstats_t *ts, tokstat_t *out, size_t k);
+
+// Count of one token: exact, or the Count-Min estimate.
+uint64_t tokstats_count(const tokstats_t *ts, const char *tok, size_t len);
+
+uint64_t tokstats_total(const tokstats_t *ts);      // tokens added
+size_t tokstats_distinct(const tokstats_t *ts);     // keys held in memory
+// Distinct tokens seen: exact, or the HyperLogLog estimate in sketch mode
+// (tokstats_distinct is then only the k heavy hitters held).
+size_t tokstats_cardinality(const tokstats_t *ts);
+size_t tokstats_bytes(const tokstats_t *ts);        // heap bytes in use
+const tokstats_num_t *tokstats_numeric(const tokstats_t *ts);
+
+// min/max/mean/stddev plus non-empty histogram buckets.
+void tokstats_print_numeric(const tokstats_t *ts, FILE *out);
+
+// Strict base-10 integer on (ptr, len): optional sign, digits only, no overflow.
+bool tokstats_parse_i64(const char *s, size_t len, int64_t *out);
+
+// 64-bit string hash, 16 bytes per step in two independent lanes.
+uint64_t tokstats_hash(const char *s, size_t len);
+
+#endif /* W4_TOKSTATS_H */
@@ -0,0 +1,192 @@
+// tokstats_bench.c
+// Recitation extension: exact token counts vs a fixed-memory sketch (tokstats.c)
+//
+// Build:  make tokstats_bench
+// Run:    ./tokstats_bench                 (1 GiB token stream, k = 1000)
+//         ./tokstats_bench -s 10G -k 1000  (the full log-analytics sized run)
+//
+// Stream: a 64 MiB corpus of space-separated tokens is generated once and
+// fed repeatedly until -s bytes have gone through. Words follow a Zipf(1.0)
+// law over -V distinct words (a few words dominate, like log keywords);
+// 1 token in 8 is a random integer, so the distinct count keeps growing and
+// the numeric statistics have work to do.
+//
+// Reported per mode: MB/s and Mtokens/s, bytes held by the counter, and
+// for the sketch how well it matches the exact answer:
+//   top-k recall   fraction of the exact top-10 the sketch also ranks top-10
+//   SS overshoot   Space-Saving count vs the exact count for those tokens
+//   CMS error      Count-Min estimate vs exact for mid-frequency words
+
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../common/strscan.h"
+#include "../common/timing.h"
+#include "tokstats.h"
+
+#define CORPUS_BYTES (64u << 20)
+#define TOP 10
+
+static uint64_t rng = 0x2545F4914F6CDD1Dull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* ------------------------------- Corpus --------------------------------- */
+static size_t make_corpus(char *buf, size_t cap, size_t vocab) {
+    double *cdf = malloc(vocab * sizeof(double));
+    if (!cdf) return 0;
+    double sum = 0;
+    for (size_t r = 0; r < vocab; r++) cdf[r] = (sum += 1.0 / (double)(r + 1));
+    size_t n = 0;
+    while (n + 32 < cap) {
+        if (rnd() % 8 == 0) {
+            n += (size_t)sprintf(buf + n, "%lld ", (long long)(rnd() % 2000001) - 1000000);
+            continue;
+        }
+        double u = (double)(rnd() >> 11) / 9007199254740992.0 * sum;
+        size_t lo = 0, hi = vocab - 1;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+        }
+        n += (size_t)sprintf(buf + n, "word%zu ", lo);
+    }
+    free(cdf);
+    return n;
+}
+
+/* ------------------------------- Stream --------------------------------- */
+static tokstats_t *run(tokstats_mode_t mode, size_t k, size_t width,
+                       const char *corpus, size_t len, size_t stream_bytes) {
+    tokstats_t *ts = tokstats_new(mode, k, width);
+    if (!ts) { perror("tokstats_new"); exit(1); }
+    size_t passes = (stream_bytes + len - 1) / len;
+    uint64_t t0 = timing_now_ns();
+    for (size_t p = 0; p < passes; p++) {
+        const char *s = corpus, *end = corpus + len;
+        while (s < end) {
+            const char *sp = strscan_memchr(s, ' ', (size_t)(end - s));
+            if (!sp) sp = end;
+            if (sp > s && tokstats_add(ts, s, (size_t)(sp - s), NULL) < 0) {
+                fprintf(stderr, "error: out of memory after %llu tokens\n",
+                        (unsigned long long)tokstats_total(ts));
+                exit(1);
+            }
+            s = sp + 1;
+        }
+    }
+    double secs = (double)(timing_now_ns() - t0) / 1e9;
+    printf("%-7s %9.0f %9.1f %12.1f %12zu\n", mode == TOKSTATS_EXACT ? "exact" : "sketch",
+           (double)(passes * len) / 1e6 / secs, (double)tokstats_total(ts) / 1e6 / secs,
+           (double)tokstats_bytes(ts) / (1 << 20), tokstats_distinct(ts));
+    return ts;
+}
+
+int main(int argc, char **argv) {
+    size_t stream = 1ul << 30, k = 1000, width = 65536, vocab = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:k:w:V:")) != -1) {
+        switch (opt) {
+            case 's': stream = parse_size(optarg); break;
+            case 'k': k = (size_t)atol(optarg); break;
+            case 'w': width = (size_t)atol(optarg); break;
+            case 'V': vocab = (size_t)atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s bytes[K|M|G]] [-k heavy_hitters] [-w cms_width] [-V vocab]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (k < TOP) k = TOP;
+    if (!vocab) vocab = 1;
+
+    char *corpus = malloc(CORPUS_BYTES);
+    if (!corpus) { perror("malloc"); return 1; }
+    size_t len = make_corpus(corpus, CORPUS_BYTES, vocab);
+    if (!len) { perror("malloc"); return 1; }
+
+    printf("=== tokstats: %.1f GiB stream (%zu MiB corpus x %zu), Zipf over %zu words, %s scans ===\n\n",
+           (double)stream / (1 << 30), len >> 20, (stream + len - 1) / len, vocab, strscan_isa());
+    printf("%-7s %9s %9s %12s %12s\n", "mode", "MB/s", "Mtok/s", "memory MiB", "keys held");
+    tokstats_t *sk = run(TOKSTATS_SKETCH, k, width, corpus, len, stream);
+    tokstats_t *ex = run(TOKSTATS_EXACT, 0, 0, corpus, len, stream);
+
+    // ---- Sketch accuracy against the exact answer ----
+    tokstat_t te[TOP], ts[TOP];
+    size_t ne = tokstats_top(ex, te, TOP), ns = tokstats_top(sk, ts, TOP);
+    size_t hits = 0;
+    double worst_ss = 0;
+    for (size_t i = 0; i < ne; i++) {
+        for (size_t j = 0; j < ns; j++) {
+            if (te[i].len == ts[j].len && memcmp(te[i].key, ts[j].key, te[i].len) == 0) {
+                hits++;
+                double over = (double)(ts[j].count - te[i].count) / (double)te[i].count;
+                if (over > worst_ss) worst_ss = over;
+            }
+        }
+    }
+    printf("\nexact top-%d:", TOP);
+    for (size_t i = 0; i < ne; i++) printf(" %.*s", (int)te[i].len, te[i].key);
+    printf("\nsketch top-%d recall: %zu/%zu, worst Space-Saving overshoot %.4f%%\n",
+           TOP, hits, ne, 100.0 * worst_ss);
+
+    double worst_cms = 0, sum_cms = 0;
+    int probes = 0;
+    for (size_t r = 1000; r < vocab && r < 1100; r++, probes++) {
+        char w[32];
+        int wl = snprintf(w, sizeof(w), "word%zu", r);
+        uint64_t truth = tokstats_count(ex, w, (size_t)wl), est = tokstats_count(sk, w, (size_t)wl);
+        double rel = truth ? (double)(est - truth) / (double)truth : 0.0;
+        sum_cms += rel;
+        if (rel > worst_cms) worst_cms = rel;
+    }
+    if (probes)
+        printf("Count-Min on words ranked 1000-1099: mean overshoot %.2f%%, worst %.2f%% "
+               "(error bound e*N/width = %.0f counts)\n",
+               100.0 * sum_cms / probes, 100.0 * worst_cms,
+               exp(1.0) * (double)tokstats_total(sk) / (double)width);
+
+    printf("\nnumeric tokens (exact mode):\n");
+    tokstats_print_numeric(ex, stdout);
+    const tokstats_num_t *a = tokstats_numeric(ex), *b = tokstats_numeric(sk);
+    if (a->n != b->n || a->min != b->min || a->max != b->max) {
+        printf("❌ numeric statistics differ between modes\n");
+        return 1;
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("\npeak RSS %ld MiB (includes the %u MiB corpus)\n",
+#ifdef __APPLE__
+           ru.ru_maxrss >> 20,
+#else
+           ru.ru_maxrss >> 10,
+#endif
+           CORPUS_BYTES >> 20);
+    printf("Takeaway:\n");
+    printf("  • Exact counts cost memory per distinct key and miss the cache as the\n"
+           "    map grows; the sketch stays a few MiB however long the stream runs.\n");
+    printf("  • Heavy hitters survive Space-Saving exactly enough to rank them; the\n"
+           "    long tail is only available as a Count-Min estimate.\n\n");
+    tokstats_free(sk);
+    tokstats_free(ex);
+    free(corpus);
+    return 0;
+}
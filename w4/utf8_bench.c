@@ -0,0 +1,271 @@
+// utf8_bench.c
+// Recitation extension: UTF-8 validation speed per kernel (common/utf8.h)
+//
+// Build:  make utf8_bench
+// Run:    ./utf8_bench                 (64 MiB per corpus, best of 5)
+//         ./utf8_bench -s 256M -r 10
+//         UTF8_ISA=scalar ./utf8_bench (io_demo uses whatever utf8_isa() picks)
+//
+// First the kernels are checked against an independent decoder (code point
+// ranges instead of byte tables): every 1-, 2- and 3-byte string, then
+// random valid text with random damage, at every offset within a block.
+// Then GB/s for utf8_valid() per kernel on four corpora, and for
+// utf8_replace() on text with one bad byte per MiB.
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/timing.h"
+#include "../common/utf8.h"
+
+static uint64_t rng = 0x243F6A8885A308D3ull;
+static uint64_t rnd(void) { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; }
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    switch (*end) {
+        case 'k': case 'K': v *= 1024.0; break;
+        case 'm': case 'M': v *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': v *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return (size_t)v;
+}
+
+/* --------------------------- Reference decoder --------------------------- */
+// Decode and range-check code points; shares nothing with utf8.h's tables.
+static int ref_valid(const unsigned char *p, size_t n) {
+    for (size_t i = 0; i < n;) {
+        unsigned c = p[i];
+        size_t len = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+        if (!len || i + len > n) return 0;
+        uint32_t cp = len == 1 ? c : c & (0x7F >> len);
+        for (size_t k = 1; k < len; k++) {
+            if ((p[i + k] & 0xC0) != 0x80) return 0;
+            cp = cp << 6 | (p[i + k] & 0x3F);
+        }
+        static const uint32_t min_cp[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+        i += len;
+    }
+    return 1;
+}
+
+static size_t put_cp(unsigned char *o, uint32_t cp) {
+    if (cp < 0x80) { o[0] = (unsigned char)cp; return 1; }
+    if (cp < 0x800) { o[0] = (unsigned char)(0xC0 | cp >> 6); o[1] = (unsigned char)(0x80 | (cp & 0x3F)); return 2; }
+    if (cp < 0x10000) {
+        o[0] = (unsigned char)(0xE0 | cp >> 12);
+        o[1] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+        o[2] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    o[0] = (unsigned char)(0xF0 | cp >> 18);
+    o[1] = (unsigned char)(0x80 | (cp >> 12 & 0x3F));
+    o[2] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+    o[3] = (unsigned char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static uint32_t rnd_cp(int kind) {
+    switch (kind) {
+        case 0: return 0x20 + (uint32_t)(rnd() % 0x5F);                   // ASCII
+        case 1: return 0xA0 + (uint32_t)(rnd() % 0x160);                  // Latin-1 / Latin Ext
+        case 2: return 0x4E00 + (uint32_t)(rnd() % 0x5200);               // CJK
+        case 3: return 0x1F300 + (uint32_t)(rnd() % 0x300);               // emoji
+        default: {                                                        // anything legal
+            uint32_t cp;
+            do cp = (uint32_t)(rnd() % 0x110000); while (cp >= 0xD800 && cp <= 0xDFFF);
+            return cp;
+        }
+    }
+}
+
+/* --------------------------------- Checks -------------------------------- */
+static int nisa;
+static const char *isas[8];
+
+static uint64_t check(const unsigned char *p, size_t n) {
+    static int shown;
+    int want = ref_valid(p, n);
+    uint64_t bad = 0;
+    for (int k = 0; k < nisa; k++) {
+        utf8_use(isas[k]);
+        if (utf8_valid((const char *)p, n) == want) continue;
+        if (shown++ < 8) {
+            printf("  ❌ %s says %s for", isas[k], want ? "invalid" : "valid");
+            for (size_t i = 0; i < n && i < 24; i++) printf(" %02X", p[i]);
+            printf("%s\n", n > 24 ? " ..." : "");
+        }
+        bad++;
+    }
+    if ((utf8_error_at((const char *)p, n) == n) != want) bad++;
+    return bad;
+}
+
+static uint64_t exhaustive(void) {
+    // Each string also sits at the end of a 62-byte ASCII run, so the
+    // kernels see it straddle a block boundary, and alone, as a padded tail.
+    unsigned char buf[128];
+    memset(buf, 'a', sizeof(buf));
+    uint64_t bad = 0;
+    for (unsigned v = 0; v < 256; v++) { buf[64] = (unsigned char)v; bad += check(buf + 64, 1); }
+    for (unsigned v = 0; v < (1u << 16); v++) {
+        buf[63] = (unsigned char)(v >> 8);
+        buf[64] = (unsigned char)v;
+        bad += check(buf + 63, 2) + check(buf, 65);
+    }
+    for (uint32_t v = 0; v < (1u << 24); v++) {
+        buf[62] = (unsigned char)(v >> 16);
+        buf[63] = (unsigned char)(v >> 8);
+        buf[64] = (unsigned char)v;
+        if (!((buf[62] | buf[63] | buf[64]) & 0x80)) continue;   // plain ASCII
+        bad += check(buf + 62, 3) + check(buf, 65);
+    }
+    return bad;
+}
+
+static uint64_t fuzz(uint64_t rounds) {
+    unsigned char buf[512];
+    uint64_t bad = 0;
+    for (uint64_t r = 0; r < rounds; r++) {
+        size_t n = 0, want = (size_t)(rnd() % 400);
+        int kind = (int)(rnd() % 5);
+        while (n + 4 < want) n += put_cp(buf + n, rnd_cp(rnd() % 4 ? kind : 4));
+        switch (rnd() % 4) {
+            case 0: break;                                                // valid
+            case 1: if (n) buf[rnd() % n] = (unsigned char)rnd(); break;  // one random byte
+            case 2: if (n) buf[rnd() % n] ^= (unsigned char)(1u << (rnd() % 8)); break;
+            default: if (n) n -= (size_t)(rnd() % (n < 3 ? n : 3)); break; // cut the end
+        }
+        size_t off = (size_t)(rnd() % 64);
+        memmove(buf + off, buf, n);
+        bad += check(buf + off, n);
+    }
+    return bad;
+}
+
+static int replace_example(void) {
+    // Unicode 3.9, "U+FFFD Substitution of Maximal Subparts".
+    const char in[] = "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64";
+    const char want[] = "a\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD" "b\xEF\xBF\xBD" "c\xEF\xBF\xBD\xEF\xBF\xBD" "d";
+    char out[64];
+    size_t bad, n = utf8_replace(in, sizeof(in) - 1, out, sizeof(out), &bad);
+    int ok = n == sizeof(want) - 1 && memcmp(out, want, n) == 0 && bad == 6;
+    printf("%s utf8_replace matches the Unicode maximal-subpart example (%zu replacements)\n",
+           ok ? "✅" : "❌", bad);
+    return ok;
+}
+
+/* -------------------------------- Timing --------------------------------- */
+static unsigned char *make_corpus(int kind, size_t size) {
+    unsigned char *p = malloc(size);
+    if (!p) { perror("malloc"); exit(1); }
+    size_t n = 0;
+    // ASCII log lines, or text in one script with a space every few characters.
+    while (n + 8 < size) {
+        if (kind == 0) {
+            p[n++] = (rnd() % 64) ? (unsigned char)rnd_cp(0) : '\n';
+        } else {
+            n += put_cp(p + n, rnd_cp(kind));
+            if (rnd() % 4 == 0) p[n++] = ' ';
+        }
+    }
+    while (n < size) p[n++] = '\n';
+    return p;
+}
+
+static double best_gbs(int (*fn)(const char *, size_t), const unsigned char *p, size_t n, int reps) {
+    double best = 0.0;
+    for (int r = 0; r < reps; r++) {
+        uint64_t t0 = timing_now_ns();
+        int ok = fn((const char *)p, n);
+        double gbs = (double)n / (double)(timing_now_ns() - t0);
+        if (!ok) return -1.0;
+        if (gbs > best) best = gbs;
+    }
+    return best;
+}
+
+static int valid_active(const char *p, size_t n) { return utf8_valid(p, n); }
+
+int main(int argc, char **argv) {
+    size_t size = 64u << 20;
+    int reps = 5, opt;
+    while ((opt = getopt(argc, argv, "s:r:")) != -1) {
+        switch (opt) {
+            case 's': size = parse_size(optarg); break;
+            case 'r': reps = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-s corpus_bytes] [-r repeats]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (size < 64) size = 64;
+    if (reps < 1) reps = 1;
+    const char *dflt = utf8_isa();
+    for (size_t i = 0; i < UTF8_NIMPLS; i++)
+        if (utf8_supported_(i)) isas[nisa++] = utf8_impls_[i].name;
+
+    printf("=== UTF-8 validation: kernels");
+    for (int k = 0; k < nisa; k++) printf(" %s", isas[k]);
+    printf(" (default %s) ===\n\n", dflt);
+
+    uint64_t bad = exhaustive();
+    printf("%s all 1/2/3-byte strings agree with a code-point decoder\n", bad ? "❌" : "✅");
+    uint64_t fbad = fuzz(200000);
+    printf("%s 200000 random damaged strings agree (%llu mismatches)\n", fbad ? "❌" : "✅",
+           (unsigned long long)fbad);
+    int ok = !bad && !fbad && replace_example();
+
+    static const char *corpus_name[] = { "ascii logs", "latin", "cjk", "emoji" };
+    printf("\n%-11s", "GB/s");
+    for (int k = 0; k < nisa; k++) printf(" %8s", isas[k]);
+    printf("   (%zu MiB, best of %d)\n", size >> 20, reps);
+    for (int c = 0; c < 4; c++) {
+        unsigned char *p = make_corpus(c, size);
+        printf("%-11s", corpus_name[c]);
+        for (int k = 0; k < nisa; k++) {
+            utf8_use(isas[k]);
+            double g = best_gbs(valid_active, p, size, reps);
+            if (g < 0) ok = 0;
+            printf(" %8.2f", g);
+        }
+        printf("\n");
+        free(p);
+    }
+
+    // The replace policy on real-looking input: one bad byte per MiB.
+    utf8_use(dflt);
+    unsigned char *p = make_corpus(1, size);
+    for (size_t i = 512 << 10; i < size; i += 1 << 20) p[i] = 0xFF;
+    char *out = malloc(size * 3);
+    if (!out) { perror("malloc"); return 1; }
+    double best = 0.0;
+    size_t nbad = 0;
+    for (int r = 0; r < reps; r++) {
+        uint64_t t0 = timing_now_ns();
+        utf8_replace((const char *)p, size, out, size * 3, &nbad);
+        double gbs = (double)size / (double)(timing_now_ns() - t0);
+        if (gbs > best) best = gbs;
+    }
+    printf("\nutf8_replace, latin, 1 bad byte/MiB: %.2f GB/s (%zu replaced)\n", best, nbad);
+    // Rejecting instead: validate once, locate the first error only on failure.
+    uint64_t t0 = timing_now_ns();
+    size_t at = utf8_valid((const char *)p, size) ? size : utf8_error_at((const char *)p, size);
+    printf("reject policy: first error at byte %zu, found in %.2f ms\n", at,
+           (double)(timing_now_ns() - t0) / 1e6);
+    free(out);
+    free(p);
+
+    printf("\nTakeaway:\n");
+    printf("  • Validation is a handful of shuffles per 16-64 bytes; on mostly-ASCII\n"
+           "    input it is one load and one sign-bit test, so it can stay on.\n");
+    printf("  • Only the (rare) invalid input pays for the byte-at-a-time path.\n\n");
+    return ok ? 0 : 1;
+}
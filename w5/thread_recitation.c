@@ -6,12 +6,17 @@
 // Run:
 //   ./thread_recitation
 //
+// Timeline (Chrome trace JSON for ui.perfetto.dev; see ../common/trace.h):
+//   make trace && TRACE_OUT=trace.json ./thread_recitation
+// Per-Part CPU / context-switch / run-queue report on stderr (../common/part_stats.h):
+//   make stats && ./thread_recitation
+//
 // Sections (each pauses):
 //   1) Counter race (no lock)
 //   2) Counter fixed with mutex (mutual exclusion)
 //   3) Non-reentrant function bug (sequential + threaded overwrite)
 //   4) Reentrant function fix (caller buffers)
-//   5) Bounds-safety mini-clinic (fgets + snprintf)
+//   5) Bounds-safety mini-clinic (fgets + ../common/fmt.h)
 //   6) Semaphores with a single counter
 //        6a) Binary semaphore (count=1) used like a mutex → correct
 //        6b) Counting semaphore with 3 permits (count=3) → shows lost updates
@@ -33,6 +38,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "../common/trace.h"        // TRACE_* timeline events (no-ops unless -DTRACE)
+#include "../common/part_stats.h"   // PART_STATS_* CPU/ctx-switch accounting (-DPART_STATS)
+#include "../common/fmt.h"          // bounded formatting, sizes checked at compile time
+
 /* ============================ Settings ============================ */
 #ifndef THREADS
 #define THREADS    8
@@ -57,14 +66,17 @@ static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
 // counter++ is load→add→store, not atomic → lost updates under contention.
 static void *inc_no_lock(void *arg) {
     (void)arg;
+    TRACE_BEGIN("inc_no_lock");
     for (int i = 0; i < ITERATIONS; i++) {
         long tmp = counter;                  // racy read
-        if ((i & 0x3FF) == 0) sched_yield(); // encourage overlap
+        if ((i & 0x3FF) == 0) { TRACE_BEGIN("sched_yield"); sched_yield(); TRACE_END("sched_yield"); } // encourage overlap
         busy_spin(50);
         tmp = tmp + 1;                        // racy modify
-        if ((i & 0x7FF) == 0) sched_yield();
+        if ((i & 0x7FF) == 0) { TRACE_BEGIN("sched_yield"); sched_yield(); TRACE_END("sched_yield"); }
         counter = tmp;                        // racy write
     }
+    TRACE_END("inc_no_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -72,11 +84,16 @@ static void *inc_no_lock(void *arg) {
 // Make the critical section exclusive; no two threads update at once.
 static void *inc_with_lock(void *arg) {
     (void)arg;
+    TRACE_BEGIN("inc_with_lock");
     for (int i = 0; i < ITERATIONS; i++) {
+        TRACE_BEGIN("lock_wait");
         pthread_mutex_lock(&g_lock);
+        TRACE_END("lock_wait");
         counter++;
         pthread_mutex_unlock(&g_lock);
     }
+    TRACE_END("inc_with_lock");
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -129,7 +146,14 @@ typedef struct {
 
 static void semc_init(semc_t *s, int initial) { s->count = initial; pthread_mutex_init(&s->m, NULL); pthread_cond_init(&s->cv, NULL); }
 static void semc_destroy(semc_t *s) { pthread_mutex_destroy(&s->m); pthread_cond_destroy(&s->cv); }
-static void semc_wait(semc_t *s) { pthread_mutex_lock(&s->m); while (s->count == 0) pthread_cond_wait(&s->cv, &s->m); s->count--; pthread_mutex_unlock(&s->m); }
+static void semc_wait(semc_t *s) {
+    TRACE_BEGIN("sem_wait");
+    pthread_mutex_lock(&s->m);
+    while (s->count == 0) { TRACE_BEGIN("sem_blocked"); pthread_cond_wait(&s->cv, &s->m); TRACE_END("sem_blocked"); }
+    s->count--;
+    pthread_mutex_unlock(&s->m);
+    TRACE_END("sem_wait");
+}
 static void semc_post(semc_t *s) { pthread_mutex_lock(&s->m); s->count++; pthread_cond_signal(&s->cv); pthread_mutex_unlock(&s->m); }
 
 /* =================== PART 6: Semaphores (single counter) ===========
@@ -143,16 +167,20 @@ static semc_t sem_three; // initialized with 3 for 6b
 
 static void *inc_with_sem_binary(void *arg) {
     (void)arg;
+    TRACE_BEGIN("inc_with_sem_binary");
     for (int i = 0; i < ITERATIONS; i++) {
         semc_wait(&sem_bin);   // like lock()
         counter++;             // safe (exclusive entry)
         semc_post(&sem_bin);   // like unlock()
     }
+    TRACE_END("inc_with_sem_binary");
+    PART_STATS_THREAD();
     return NULL;
 }
 
 static void *inc_with_sem_three(void *arg) {
     (void)arg;
+    TRACE_BEGIN("inc_with_sem_three");
     for (int i = 0; i < ITERATIONS; i++) {
         semc_wait(&sem_three); // allows up to 3 threads in at once
         // ⚠ Not mutually exclusive when count>1 → counter++ races again
@@ -161,6 +189,8 @@ static void *inc_with_sem_three(void *arg) {
         counter = tmp + 1;
         semc_post(&sem_three);
     }
+    TRACE_END("inc_with_sem_three");
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -169,9 +199,17 @@ typedef struct { const char *tag; const char *name; } bounds_args_t;
 static void *fn_bounds(void *arg) {
     bounds_args_t *a = (bounds_args_t*)arg;
     char local[24]; // per-thread local buffer (no sharing)
-    int need2 = snprintf(local, sizeof(local), "[%s:%s]", a->tag, a->name);
-    if (need2 >= (int)sizeof(local)) fprintf(stderr, "[warn] local truncated for \"%s\"\n", a->name);
+    // Behind pointers the lengths are unknown at compile time: no FMT_FITS,
+    // but fmt_end still reports truncation like snprintf.
+    fmt_t f = FMT_BEGIN(local);
+    fmt_char(&f, '[');
+    fmt_str(&f, a->tag);
+    fmt_char(&f, ':');
+    fmt_str(&f, a->name);
+    fmt_char(&f, ']');
+    if (fmt_end(&f) >= sizeof(local)) fprintf(stderr, "[warn] local truncated for \"%s\"\n", a->name);
     printf("thread-banner: %s\n", local);
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -183,6 +221,7 @@ static void *thread_fn_bad(void *arg) {
     const char *p = upper_not_reentrant(a->in); // returns same static pointer
     sched_yield();
     *(a->out) = p;
+    PART_STATS_THREAD();
     return NULL;
 }
 
@@ -190,24 +229,35 @@ typedef struct { const char *in; char *out; size_t cap; } args_ok_t;
 static void *thread_fn_ok(void *arg) {
     args_ok_t *a2 = (args_ok_t*)arg;
     upper_reentrant(a2->in, a2->out, a2->cap);
+    PART_STATS_THREAD();
     return NULL;
 }
 
 /* ============================= Driver ============================= */
 int main(void) {
+    TRACE_THREAD_NAME("main");
+
     /* -------------------- Part 1: Race (no lock) -------------------- */
     printf("=== Part 1: Counter race (no lock) ===\n");
     pthread_t t[THREADS]; counter = 0;
+    TRACE_BEGIN("Part 1");
+    PART_STATS_BEGIN("Part 1");
     for (int i = 0; i < THREADS; i++) pthread_create(&t[i], NULL, inc_no_lock, NULL);
     for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+    PART_STATS_END();
+    TRACE_END("Part 1");
     printf("Expected: %d, got: %ld  <-- likely WRONG due to lost updates\n", THREADS * ITERATIONS, counter);
     wait_for_enter("Discuss: Why does counter++ lose updates here?");
 
     /* -------------------- Part 2: Mutex (correct) ------------------- */
     printf("=== Part 2: Counter with mutex (correct) ===\n");
     counter = 0;
+    TRACE_BEGIN("Part 2");
+    PART_STATS_BEGIN("Part 2");
     for (int i = 0; i < THREADS; i++) pthread_create(&t[i], NULL, inc_with_lock, NULL);
     for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+    PART_STATS_END();
+    TRACE_END("Part 2");
     printf("Expected: %d, got: %ld  ✅ exact\n", THREADS * ITERATIONS, counter);
     wait_for_enter("Discuss: What property does the mutex provide? Tradeoffs?");
 
@@ -222,9 +272,11 @@ int main(void) {
     const char *outA = NULL, *outB = NULL;
     args_bad_t a = { "abcdef", &outA }, b = { "XYZ123", &outB };
     pthread_t A, B;
+    PART_STATS_BEGIN("Part 3b");
     pthread_create(&A, NULL, thread_fn_bad, &a);
     pthread_create(&B, NULL, thread_fn_bad, &b);
     pthread_join(A, NULL); pthread_join(B, NULL);
+    PART_STATS_END();
     printf("Thread A saw: %s\n", outA);
     printf("Thread B saw: %s\n", outB);
     printf("(Both point to the same static buffer; last finisher “wins”.)\n");
@@ -235,33 +287,46 @@ int main(void) {
     char A_buf[64], B_buf[64];
     args_ok_t a2 = { "abcdef", A_buf, sizeof(A_buf) };
     args_ok_t b2 = { "XYZ123", B_buf, sizeof(B_buf) };
+    PART_STATS_BEGIN("Part 4");
     pthread_create(&A, NULL, thread_fn_ok, &a2);
     pthread_create(&B, NULL, thread_fn_ok, &b2);
     pthread_join(A, NULL); pthread_join(B, NULL);
+    PART_STATS_END();
     printf("Thread-safe results: A=\"%s\", B=\"%s\"  ✅\n", A_buf, B_buf);
     wait_for_enter("Discuss: Why does caller-owned memory make it reentrant?");
 
-    /* ------- Part 5: Bounds-safety mini-clinic (fgets/snprintf) ----- */
-    printf("=== Part 5: Bounds-safety clinic (fgets/snprintf) ===\n");
+    /* ------- Part 5: Bounds-safety mini-clinic (fgets/fmt.h) -------- */
+    printf("=== Part 5: Bounds-safety clinic (fgets/fmt.h) ===\n");
     char label[16]; read_label_bounded(label, sizeof(label));
-    char tag[20]; int need = snprintf(tag, sizeof(tag), "TAG:%s", label);
-    if (need >= (int)sizeof(tag)) fprintf(stderr, "[warn] tag truncated (need %d, cap %zu)\n", need, sizeof(tag));
+    char tag[20];
+    FMT_FITS(tag, FMT_LIT_MAX("TAG:") + FMT_STR_MAX(label));   // checked by the compiler
+    fmt_t f = FMT_BEGIN(tag);
+    fmt_lit(&f, "TAG:");
+    fmt_str(&f, label);
+    size_t need = fmt_end(&f);
+    if (need >= sizeof(tag)) fprintf(stderr, "[warn] tag truncated (need %zu, cap %zu)\n", need, sizeof(tag));
     printf("Safe tag = \"%s\"\n", tag);
 
     pthread_t T1, T2;
     bounds_args_t a1 = { .tag = tag, .name = "T1" };
     bounds_args_t a2b = { .tag = tag, .name = "T2" };
+    PART_STATS_BEGIN("Part 5");
     pthread_create(&T1, NULL, fn_bounds, &a1);
     pthread_create(&T2, NULL, fn_bounds, &a2b);
     pthread_join(T1, NULL); pthread_join(T2, NULL);
+    PART_STATS_END();
     wait_for_enter("Discuss: Detecting truncation & avoiding shared temporaries");
 
     /* -------------------- Part 6: Semaphores (single counter) ------- */
     printf("=== Part 6a: Binary semaphore (count=1) used like a mutex ===\n");
     semc_init(&sem_bin, 1);     // 1 permit → exclusive entry
     counter = 0;
+    TRACE_BEGIN("Part 6a");
+    PART_STATS_BEGIN("Part 6a");
     for (int i = 0; i < THREADS; i++) pthread_create(&t[i], NULL, inc_with_sem_binary, NULL);
     for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+    PART_STATS_END();
+    TRACE_END("Part 6a");
     printf("Expected: %d, got: %ld  ✅ exact (binary semaphore = mutual exclusion)\n", THREADS * ITERATIONS, counter);
     semc_destroy(&sem_bin);
     wait_for_enter("Discuss: How is a binary semaphore similar to a mutex? Any differences?");
@@ -269,8 +334,12 @@ int main(void) {
     printf("=== Part 6b: Counting semaphore with 3 permits (count=3) ===\n");
     semc_init(&sem_three, 3);   // 3 permits → up to 3 inside at once
     counter = 0;
+    TRACE_BEGIN("Part 6b");
+    PART_STATS_BEGIN("Part 6b");
     for (int i = 0; i < THREADS; i++) pthread_create(&t[i], NULL, inc_with_sem_three, NULL);
     for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+    PART_STATS_END();
+    TRACE_END("Part 6b");
     printf("Expected: %d, got: %ld  <-- likely WRONG again (not exclusive)\n", THREADS * ITERATIONS, counter);
     semc_destroy(&sem_three);
     wait_for_enter("Discuss: Why does allowing >1 permit reintroduce lost updates?");
@@ -304,7 +373,9 @@ Part 4 — Why is the reentrant version safe?
 
 Part 5 — How to detect truncation & avoid shared temporaries?
     • fgets: if no newline captured, input exceeded buffer → truncated; flush the rest.
-    • snprintf: if return value >= buffer size, output was truncated.
+    • snprintf / fmt_end: if the return value >= buffer size, output was truncated.
+    • fmt.h: when every piece has a constant maximum, FMT_FITS rejects a buffer
+      that is too small at compile time — truncation cannot happen at all.
     • Avoid shared temporaries: use per-thread locals or caller-provided buffers.
 
 Part 6a — Binary semaphore vs mutex?
@@ -6,6 +6,9 @@
 // Run:
 //   ./dns_demo
 //
+// Per-Part CPU / context-switch / fault report on stderr (../common/part_stats.h):
+//   make stats && ./dns_demo
+//
 // Sections (each pauses):
 //   1) Basic hostname resolution (getaddrinfo vs deprecated gethostbyname)
 //   2) IPv4 vs IPv6 resolution (A vs AAAA records)
@@ -34,11 +37,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
 
+#include "../common/part_stats.h"   // PART_STATS_* CPU/ctx-switch accounting (-DPART_STATS)
+#include "../common/timing.h"       // timing_now_ns: vDSO CLOCK_MONOTONIC_RAW
+
 /* ============================ Utilities ============================ */
 static void wait_for_enter(const char *title) {
     if (title && *title) printf("\n===== %s =====\n", title);
@@ -46,10 +51,9 @@ static void wait_for_enter(const char *title) {
     int c; while ((c = getchar()) != '\n' && c != EOF) {}
 }
 
+// Monotonic: gettimeofday() jumps when NTP steps the wall clock mid-lookup.
 static double get_time_ms(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+    return (double)timing_now_ns() / 1e6;
 }
 
 /* ============== PART 1: Basic hostname resolution ================= */
@@ -437,8 +441,10 @@ int main(void) {
     printf("Modern programs should use getaddrinfo (protocol-independent).\n");
     printf("Old code may use gethostbyname (IPv4-only, deprecated).\n");
     
+    PART_STATS_BEGIN("Part 1");
     resolve_with_getaddrinfo("www.google.com");
     resolve_with_gethostbyname_DEPRECATED("www.google.com");
+    PART_STATS_END();
     
     wait_for_enter("Discuss: Why is getaddrinfo preferred over gethostbyname?");
     
@@ -458,8 +464,10 @@ int main(void) {
     printf("A records: IPv4 addresses (32-bit)\n");
     printf("AAAA records: IPv6 addresses (128-bit)\n");
     
+    PART_STATS_BEGIN("Part 2");
     resolve_ipv4_only("www.google.com");
     resolve_ipv6_only("www.google.com");
+    PART_STATS_END();
     
     wait_for_enter("Discuss: What's the difference between A and AAAA records? Dual-stack?");
     
@@ -481,8 +489,10 @@ int main(void) {
     printf("PTR records map IP addresses back to hostnames.\n");
     printf("Used for logging, spam filtering, and verification.\n");
     
+    PART_STATS_BEGIN("Part 3");
     reverse_dns_lookup("8.8.8.8");        // Google DNS
     reverse_dns_lookup("1.1.1.1");        // Cloudflare DNS
+    PART_STATS_END();
     
     wait_for_enter("Discuss: When is reverse DNS useful? Why might it fail?");
     
@@ -508,8 +518,10 @@ int main(void) {
     printf("  TXT: Arbitrary text (SPF, DKIM, verification)\n");
     printf("  NS: Name servers (delegation)\n");
     
+    PART_STATS_BEGIN("Part 4");
     query_mx_records("gmail.com");
     query_txt_records("google.com");
+    PART_STATS_END();
     
     wait_for_enter("Discuss: What are MX records used for? What about TXT records?");
     
@@ -539,7 +551,9 @@ int main(void) {
     printf("Resolvers cache DNS results to reduce network traffic.\n");
     printf("TTL (Time To Live) controls how long records can be cached.\n");
     
+    PART_STATS_BEGIN("Part 5");
     demonstrate_caching("www.example.com");
+    PART_STATS_END();
     
     wait_for_enter("Discuss: Why is DNS caching important? What are the tradeoffs?");
     
@@ -577,7 +591,9 @@ int main(void) {
     printf("  - Invalid format\n");
     printf("Robust code must handle all error cases.\n");
     
+    PART_STATS_BEGIN("Part 6");
     demonstrate_errors();
+    PART_STATS_END();
     
     wait_for_enter("Discuss: What errors should applications handle? Retry strategies?");
     
@@ -607,7 +623,9 @@ int main(void) {
     /* ------------ Part 7: /etc/hosts vs DNS servers ------------------ */
     printf("\n=== Part 7: /etc/hosts vs DNS Server Resolution ===\n");
     
+    PART_STATS_BEGIN("Part 7");
     demonstrate_hosts_file();
+    PART_STATS_END();
     
     wait_for_enter("Discuss: Resolution order? Security implications of /etc/hosts?");
     